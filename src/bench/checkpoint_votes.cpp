@@ -0,0 +1,63 @@
+// Copyright (c) 2019 The Unit-e developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <esperanza/checkpoint.h>
+#include <random.h>
+#include <uint256.h>
+
+#include <cassert>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr size_t VOTES_PER_EPOCH = 10000;
+
+//! Every block gets its own finalization state and the first vote in a block
+//! copies the target checkpoint from the state of the parent block.
+constexpr size_t VOTES_PER_BLOCK = VOTES_PER_EPOCH / 50;
+
+std::vector<uint160> MakeValidators(FastRandomContext &random)
+{
+    std::vector<uint160> validators(VOTES_PER_EPOCH);
+    for (uint160 &validator : validators) {
+        const std::vector<unsigned char> bytes = random.randbytes(validator.size());
+        std::memcpy(validator.begin(), bytes.data(), bytes.size());
+    }
+    return validators;
+}
+
+} // namespace
+
+//! Tallies the votes of 10k validators for one checkpoint the way
+//! FinalizationState::ProcessVote does, after checking for double votes.
+static void CheckpointProcessVotes(benchmark::State& state)
+{
+    FastRandomContext random(true);
+    const std::vector<uint160> validators = MakeValidators(random);
+    const uint32_t source_epoch = 7;
+
+    while (state.KeepRunning()) {
+        esperanza::Checkpoint checkpoint;
+        uint64_t cur_votes = 0;
+        uint64_t prev_votes = 0;
+        for (size_t i = 0; i < validators.size(); ++i) {
+            if (i % VOTES_PER_BLOCK == 0) {
+                esperanza::Checkpoint parent_copy(checkpoint);
+                checkpoint = std::move(parent_copy);
+            }
+            if (checkpoint.HasVoted(validators[i])) {
+                continue;
+            }
+            checkpoint.AddVote(validators[i]);
+            cur_votes = checkpoint.GetCurDynastyVotes(source_epoch) += 1000;
+            prev_votes = checkpoint.GetPrevDynastyVotes(source_epoch) += 1000;
+        }
+        assert(cur_votes == prev_votes);
+    }
+}
+
+BENCHMARK(CheckpointProcessVotes, 20);
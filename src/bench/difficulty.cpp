@@ -0,0 +1,89 @@
+// Copyright (c) 2019 The Unit-e developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <blockchain/blockchain_behavior.h>
+#include <chain.h>
+#include <random.h>
+#include <uint256.h>
+
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr blockchain::Height CHAIN_LENGTH = 1000;
+
+//! A chain of block indexes whose tip can be moved, like the active chain
+//! while it is synced.
+class BenchChain : public blockchain::ChainAccess
+{
+public:
+    std::vector<uint256> hashes;
+    std::vector<CBlockIndex> blocks;
+    blockchain::Height tip_height = 0;
+
+    explicit BenchChain(const blockchain::Parameters &parameters)
+        : hashes(CHAIN_LENGTH), blocks(CHAIN_LENGTH)
+    {
+        FastRandomContext random(true);
+        for (blockchain::Height height = 0; height < CHAIN_LENGTH; ++height) {
+            const std::vector<unsigned char> bytes = random.randbytes(hashes[height].size());
+            std::memcpy(hashes[height].begin(), bytes.data(), bytes.size());
+            CBlockIndex &block = blocks[height];
+            block.phashBlock = &hashes[height];
+            block.nHeight = static_cast<int>(height);
+            block.nTime = height * parameters.block_time_seconds + random.randrange(parameters.block_time_seconds);
+            block.nBits = 0x1d00ffff - random.randrange(0x10000);
+        }
+    }
+
+    const CBlockIndex *AtDepth(const blockchain::Depth depth) const override
+    {
+        return depth == 0 || depth > tip_height + 1 ? nullptr : &blocks[tip_height + 1 - depth];
+    }
+
+    const CBlockIndex *AtHeight(const blockchain::Height height) const override
+    {
+        return height > tip_height ? nullptr : &blocks[height];
+    }
+};
+
+} // namespace
+
+//! Syncing: every block is connected on a new tip, so every difficulty is
+//! calculated from the full adjustment window.
+static void CalculateDifficultyNewTip(benchmark::State& state)
+{
+    const blockchain::Parameters parameters = blockchain::Parameters::TestNet();
+    const auto behavior = blockchain::Behavior::NewFromParameters(parameters);
+    BenchChain chain(parameters);
+    const blockchain::Height first_tip = parameters.difficulty_adjustment_window + 1;
+    assert(first_tip < CHAIN_LENGTH);
+
+    chain.tip_height = first_tip;
+    while (state.KeepRunning()) {
+        behavior->CalculateDifficulty(chain.tip_height + 1, chain);
+        if (++chain.tip_height == CHAIN_LENGTH) {
+            chain.tip_height = first_tip;
+        }
+    }
+}
+
+//! Proposing and validating stake on the same tip reuse the last result.
+static void CalculateDifficultySameTip(benchmark::State& state)
+{
+    const blockchain::Parameters parameters = blockchain::Parameters::TestNet();
+    const auto behavior = blockchain::Behavior::NewFromParameters(parameters);
+    BenchChain chain(parameters);
+    chain.tip_height = CHAIN_LENGTH - 1;
+
+    while (state.KeepRunning()) {
+        behavior->CalculateDifficulty(chain.tip_height + 1, chain);
+    }
+}
+
+BENCHMARK(CalculateDifficultyNewTip, 60 * 1000);
+BENCHMARK(CalculateDifficultySameTip, 20 * 1000 * 1000);
@@ -0,0 +1,205 @@
+// Copyright (c) 2019 The Unit-e developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <blockencodings.h>
+#include <p2p/graphene.h>
+#include <random.h>
+#include <txmempool.h>
+#include <txpool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+class BenchTxPool : public TxPool
+{
+public:
+    size_t GetTxCount() const override
+    {
+        return txs.size();
+    }
+
+    void ForEachTx(const std::function<bool(const uint256&)>& filter,
+                   const std::function<void(const CTransactionRef&)>& visit) const override
+    {
+        for (const CTransactionRef& tx : txs) {
+            if (filter(tx->GetWitnessHash())) {
+                visit(tx);
+            }
+        }
+    }
+
+    std::vector<CTransactionRef> txs;
+};
+
+CTransactionRef CreateTx(uint32_t seed)
+{
+    // graphene only needs distinct hashes, so transactions are kept minimal
+    CMutableTransaction tx;
+    tx.vout.resize(1);
+    tx.vout[0].nValue = seed;
+    return MakeTransactionRef(std::move(tx));
+}
+
+//! Synthetic mempools of the sender and the receiver and the block to relay
+struct Scenario {
+    CBlock block;
+    BenchTxPool receiver;
+    size_t sender_txs_wo_block = 0;
+
+    //! transactions of the receiver which are not in the block
+    std::vector<CTransactionRef> receiver_excess;
+
+    //! \param block_txs transactions in the block besides the coinbase
+    //! \param missing_txs block transactions the receiver doesn't have
+    //! \param mempool_txs transactions which both have besides the block ones
+    Scenario(size_t block_txs, size_t missing_txs, size_t mempool_txs)
+    {
+        CMutableTransaction coinbase;
+        coinbase.vin.resize(1);
+        coinbase.SetType(TxType::COINBASE);
+        block.vtx.emplace_back(MakeTransactionRef(std::move(coinbase)));
+
+        uint32_t seed = 0;
+        for (size_t i = 0; i < block_txs; ++i) {
+            block.vtx.emplace_back(CreateTx(++seed));
+            if (i >= missing_txs) {
+                receiver.txs.emplace_back(block.vtx.back());
+            }
+        }
+        for (size_t i = 0; i < mempool_txs; ++i) {
+            receiver_excess.emplace_back(CreateTx(++seed));
+            receiver.txs.emplace_back(receiver_excess.back());
+        }
+        sender_txs_wo_block = mempool_txs;
+    }
+};
+
+double Percentile(std::vector<double> values, double percentile)
+{
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[static_cast<size_t>(percentile * (values.size() - 1))];
+}
+
+double ElapsedMs(const std::chrono::steady_clock::time_point& start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+// Encodes the block of the scenario with a new nonce on every run and
+// decodes it against the receiver's mempool. Reports the size on the wire
+// next to a compact block, how often the IBLT is decoded, the symmetric
+// difference expected by OptimizeGrapheneBlockParams against the one
+// actually produced by the bloom filter, and encode/decode latencies.
+static void GrapheneRoundTrip(benchmark::State& state, const Scenario& scenario)
+{
+    FastRandomContext random(true);
+
+    const size_t block_txs = scenario.block.vtx.size() - 1;
+    const p2p::GrapheneBlockParams params =
+        p2p::OptimizeGrapheneBlockParams(block_txs,
+                                         scenario.sender_txs_wo_block + block_txs,
+                                         scenario.receiver.GetTxCount());
+
+    std::unordered_set<uint256, SaltedTxidHasher> receiver_has;
+    for (const CTransactionRef& tx : scenario.receiver.txs) {
+        receiver_has.emplace(tx->GetWitnessHash());
+    }
+    size_t missing = 0;
+    for (size_t i = 1; i < scenario.block.vtx.size(); ++i) {
+        missing += receiver_has.count(scenario.block.vtx[i]->GetWitnessHash()) == 0;
+    }
+
+    std::vector<double> encode_ms;
+    std::vector<double> decode_ms;
+    size_t runs = 0;
+    size_t decoded = 0;
+    size_t total_bytes = 0;
+    size_t total_symmetric_difference = 0;
+
+    while (state.KeepRunning()) {
+        auto start = std::chrono::steady_clock::now();
+        const boost::optional<p2p::GrapheneBlock> graphene =
+            p2p::CreateGrapheneBlock(scenario.block, scenario.sender_txs_wo_block,
+                                     scenario.receiver.GetTxCount(), random);
+        encode_ms.push_back(ElapsedMs(start));
+        ++runs;
+        if (!graphene) {
+            continue;
+        }
+
+        total_bytes += GetSerializeSize(graphene.get(), SER_NETWORK, PROTOCOL_VERSION);
+
+        start = std::chrono::steady_clock::now();
+        const p2p::GrapheneBlockReconstructor reconstructor(graphene.get(), scenario.receiver);
+        decode_ms.push_back(ElapsedMs(start));
+        if (reconstructor.GetState() != +p2p::GrapheneDecodeState::CANT_DECODE_IBLT) {
+            ++decoded;
+        }
+
+        size_t false_positives = 0;
+        for (const CTransactionRef& tx : scenario.receiver_excess) {
+            false_positives += graphene->bloom_filter.contains(tx->GetWitnessHash());
+        }
+        total_symmetric_difference += missing + false_positives;
+    }
+
+    if (runs == 0) {
+        return;
+    }
+
+    const size_t compact_bytes = GetSerializeSize(CBlockHeaderAndShortTxIDs(scenario.block), SER_NETWORK, PROTOCOL_VERSION);
+    const size_t encoded = decode_ms.size();
+    printf("%s: %zu block txs, %zu receiver txs, %zu missing\n",
+           state.m_name.c_str(), block_txs, scenario.receiver.GetTxCount(), missing);
+    printf("  size: %.0f bytes, compact block %zu bytes\n",
+           encoded > 0 ? static_cast<double>(total_bytes) / encoded : 0.0, compact_bytes);
+    printf("  decoded: %.1f%% of %zu\n", 100.0 * decoded / runs, runs);
+    printf("  symmetric difference: expected %zu, actual %.1f\n",
+           params.expected_symmetric_difference,
+           encoded > 0 ? static_cast<double>(total_symmetric_difference) / encoded : 0.0);
+    printf("  encode ms: p50 %.3f, p90 %.3f, p99 %.3f\n",
+           Percentile(encode_ms, 0.5), Percentile(encode_ms, 0.9), Percentile(encode_ms, 0.99));
+    printf("  decode ms: p50 %.3f, p90 %.3f, p99 %.3f\n",
+           Percentile(decode_ms, 0.5), Percentile(decode_ms, 0.9), Percentile(decode_ms, 0.99));
+}
+
+static void GrapheneFullOverlap(benchmark::State& state)
+{
+    static const Scenario scenario(2000, 0, 3000);
+    GrapheneRoundTrip(state, scenario);
+}
+
+static void GraphenePartialOverlap(benchmark::State& state)
+{
+    static const Scenario scenario(2000, 20, 3000);
+    GrapheneRoundTrip(state, scenario);
+}
+
+static void GrapheneLowOverlap(benchmark::State& state)
+{
+    static const Scenario scenario(2000, 200, 3000);
+    GrapheneRoundTrip(state, scenario);
+}
+
+static void GrapheneLargeMempool(benchmark::State& state)
+{
+    static const Scenario scenario(2000, 20, 50000);
+    GrapheneRoundTrip(state, scenario);
+}
+
+BENCHMARK(GrapheneFullOverlap, 100);
+BENCHMARK(GraphenePartialOverlap, 100);
+BENCHMARK(GrapheneLowOverlap, 100);
+BENCHMARK(GrapheneLargeMempool, 20);
@@ -0,0 +1,81 @@
+// Copyright (c) 2019 The Unit-e developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <iblt.h>
+#include <random.h>
+
+#include <vector>
+
+// Graphene keys IBLTs by 64-bit short hashes and stores no values
+using BenchIBLT = IBLT<uint64_t, 0>;
+
+// A block of 2000 transactions of which 100 differ between sender and receiver
+static constexpr size_t BLOCK_TXS = 2000;
+static constexpr size_t SYMMETRIC_DIFFERENCE = 100;
+
+static std::vector<uint64_t> RandomKeys(size_t count)
+{
+    FastRandomContext random(true);
+    std::vector<uint64_t> keys(count);
+    for (uint64_t& key : keys) {
+        key = random.rand64();
+    }
+    return keys;
+}
+
+// The sender and receiver IBLTs share all keys but SYMMETRIC_DIFFERENCE
+static void FillIBLTs(BenchIBLT& sender, BenchIBLT& receiver)
+{
+    const std::vector<uint64_t> keys = RandomKeys(BLOCK_TXS + SYMMETRIC_DIFFERENCE / 2);
+    for (size_t i = 0; i < BLOCK_TXS; ++i) {
+        sender.Insert(keys[i], {});
+    }
+    for (size_t i = SYMMETRIC_DIFFERENCE / 2; i < keys.size(); ++i) {
+        receiver.Insert(keys[i], {});
+    }
+}
+
+static void IBLTInsert(benchmark::State& state)
+{
+    const std::vector<uint64_t> keys = RandomKeys(BLOCK_TXS);
+    while (state.KeepRunning()) {
+        BenchIBLT iblt(SYMMETRIC_DIFFERENCE);
+        for (const uint64_t key : keys) {
+            iblt.Insert(key, {});
+        }
+    }
+}
+
+static void IBLTSubtract(benchmark::State& state)
+{
+    BenchIBLT sender(SYMMETRIC_DIFFERENCE);
+    BenchIBLT receiver = sender.CloneEmpty();
+    FillIBLTs(sender, receiver);
+
+    while (state.KeepRunning()) {
+        const BenchIBLT diff = sender - receiver;
+        assert(diff.IsValid());
+    }
+}
+
+static void IBLTDecode(benchmark::State& state)
+{
+    BenchIBLT sender(SYMMETRIC_DIFFERENCE);
+    BenchIBLT receiver = sender.CloneEmpty();
+    FillIBLTs(sender, receiver);
+    const BenchIBLT diff = sender - receiver;
+
+    while (state.KeepRunning()) {
+        BenchIBLT::TEntriesMap only_sender;
+        BenchIBLT::TEntriesMap only_receiver;
+        const bool decoded = diff.ListEntries(only_sender, only_receiver);
+        assert(decoded);
+        assert(only_sender.size() + only_receiver.size() == SYMMETRIC_DIFFERENCE);
+    }
+}
+
+BENCHMARK(IBLTInsert, 2000);
+BENCHMARK(IBLTSubtract, 100000);
+BENCHMARK(IBLTDecode, 20000);
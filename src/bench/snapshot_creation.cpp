@@ -0,0 +1,83 @@
+// Copyright (c) 2019 The Unit-e developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chainparamsbase.h>
+#include <coins.h>
+#include <random.h>
+#include <snapshot/creator.h>
+#include <snapshot/indexer.h>
+#include <snapshot/snapshot_index.h>
+#include <txdb.h>
+#include <util.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+static constexpr uint32_t UTXO_SUBSETS = 20000;
+static constexpr uint32_t OUTPUTS_PER_SUBSET = 3;
+
+// Creates a snapshot of a chainstate with UTXO_SUBSETS * OUTPUTS_PER_SUBSET
+// outputs and reports how many UTXOs per second were written.
+static void CreateSnapshot(benchmark::State& state, const uint32_t workers)
+{
+    // snapshots are written to the regtest data directory
+    SelectBaseParams(CBaseChainParams::REGTEST);
+
+    const uint256 best_block = GetRandHash();
+    CBlockIndex* block_index = new CBlockIndex();
+    block_index->phashBlock = &mapBlockIndex.emplace(best_block, block_index).first->first;
+
+    CCoinsViewDB view_db(0, true, true);
+    {
+        CCoinsViewCache view_cache(&view_db);
+        view_cache.SetBestBlock(best_block);
+        for (uint32_t i = 0; i < UTXO_SUBSETS; ++i) {
+            const uint256 tx_id = GetRandHash();
+            for (uint32_t n = 0; n < OUTPUTS_PER_SUBSET; ++n) {
+                CScript script = CScript() << OP_DUP << OP_HASH160 << ToByteVector(GetRandHash()) << OP_EQUALVERIFY << OP_CHECKSIG;
+                view_cache.AddCoin(COutPoint(tx_id, n), Coin(CTxOut(i + n, script), i, TxType::REGULAR), false);
+            }
+        }
+        assert(view_cache.Flush());
+    }
+
+    uint64_t total_outputs = 0;
+    const auto start = std::chrono::steady_clock::now();
+    while (state.KeepRunning()) {
+        // a new stake modifier produces a new snapshot hash every time
+        block_index->stake_modifier = GetRandHash();
+
+        snapshot::Creator creator(&view_db);
+        creator.m_workers = workers;
+        const snapshot::CreationInfo info = creator.Create();
+        assert(info.status == +snapshot::Status::OK);
+        total_outputs += info.total_outputs;
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%s, %u workers: %.0f UTXOs/sec\n", state.m_name.c_str(), workers, total_outputs / seconds);
+
+    {
+        LOCK(snapshot::cs_snapshot);
+        for (const snapshot::Checkpoint& checkpoint : snapshot::GetSnapshotCheckpoints()) {
+            snapshot::Indexer::Delete(checkpoint.snapshot_hash);
+        }
+    }
+    UnloadBlockIndex();
+}
+
+static void SnapshotCreation(benchmark::State& state)
+{
+    CreateSnapshot(state, 0);
+}
+
+static void SnapshotCreationParallel(benchmark::State& state)
+{
+    CreateSnapshot(state, std::max(GetNumCores() - 1, 1));
+}
+
+BENCHMARK(SnapshotCreation, 1);
+BENCHMARK(SnapshotCreationParallel, 1);
@@ -0,0 +1,61 @@
+// Copyright (c) 2019 The Unit-e developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <random.h>
+#include <ufp64.h>
+
+#include <cassert>
+#include <vector>
+
+namespace {
+
+constexpr size_t VALIDATORS = 10000;
+
+} // namespace
+
+//! The fixed-point arithmetic of one epoch transition of FinalizationState
+//! followed by every validator voting once: the deposit scale factor and the
+//! reward factor are updated, then each vote is rewarded and counted towards
+//! the two-thirds thresholds.
+static void Ufp64EpochTransition(benchmark::State& state)
+{
+    FastRandomContext random(true);
+    std::vector<uint64_t> deposits(VALIDATORS);
+    uint64_t total_deposits = 0;
+    for (uint64_t& deposit : deposits) {
+        deposit = 10000 + random.randrange(100000);
+        total_deposits += deposit;
+    }
+
+    const ufp64::ufp64_t base_interest_factor = ufp64::to_ufp64(7);
+    const ufp64::ufp64_t base_penalty_factor = ufp64::div_2uint(2, 10000000);
+    ufp64::ufp64_t deposit_scale_factor = ufp64::to_ufp64(1);
+    ufp64::ufp64_t reward_factor = 0;
+
+    while (state.KeepRunning()) {
+        const ufp64::ufp64_t vote_fraction = ufp64::div_2uint(2, 3);
+        const ufp64::ufp64_t collective_reward_factor = ufp64::div_by_uint(ufp64::mul(vote_fraction, reward_factor), 2);
+        const ufp64::ufp64_t voter_rescale = ufp64::add_uint(collective_reward_factor, 1);
+        const ufp64::ufp64_t non_voter_rescale = ufp64::div(voter_rescale, ufp64::add_uint(reward_factor, 1));
+        deposit_scale_factor = ufp64::mul(non_voter_rescale, deposit_scale_factor);
+
+        const uint64_t sqrt_of_total_deposits = ufp64::sqrt_uint(1 + ufp64::mul_to_uint(deposit_scale_factor, total_deposits));
+        reward_factor = ufp64::add(ufp64::div(base_interest_factor, sqrt_of_total_deposits),
+                                   ufp64::mul_by_uint(base_penalty_factor, 2));
+
+        const uint64_t cur_dyn_deposits = ufp64::mul_to_uint(deposit_scale_factor, total_deposits);
+
+        uint64_t votes = 0;
+        bool justified = false;
+        for (const uint64_t deposit : deposits) {
+            votes += ufp64::mul_to_uint(deposit_scale_factor, deposit);
+            total_deposits += ufp64::mul_to_uint(reward_factor, deposit);
+            justified = votes >= ufp64::div_to_uint(cur_dyn_deposits * 2, ufp64::to_ufp64(3));
+        }
+        assert(justified);
+    }
+}
+
+BENCHMARK(Ufp64EpochTransition, 50);
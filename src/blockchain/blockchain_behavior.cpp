@@ -27,7 +27,24 @@ Behavior::Behavior(const Parameters &parameters) noexcept
 }
 
 Difficulty Behavior::CalculateDifficulty(Height height, ChainAccess &chain) const {
-  return m_parameters.difficulty_function(m_parameters, height, chain);
+  const CBlockIndex *const tip = chain.AtDepth(1);
+  if (tip == nullptr || tip->phashBlock == nullptr) {
+    return m_parameters.difficulty_function(m_parameters, height, chain);
+  }
+  const uint256 tip_hash = tip->GetBlockHash();
+  {
+    LOCK(m_difficulty_cache.cs);
+    if (m_difficulty_cache.tip_hash == tip_hash && m_difficulty_cache.height == height) {
+      return m_difficulty_cache.difficulty;
+    }
+  }
+  const Difficulty difficulty = m_parameters.difficulty_function(m_parameters, height, chain);
+
+  LOCK(m_difficulty_cache.cs);
+  m_difficulty_cache.tip_hash = tip_hash;
+  m_difficulty_cache.height = height;
+  m_difficulty_cache.difficulty = difficulty;
+  return difficulty;
 }
 
 Time Behavior::CalculateProposingTimestamp(const std::int64_t timestamp_sec) const {
@@ -31,6 +31,15 @@ class Behavior {
   const Parameters m_parameters;
   const std::size_t m_absolute_transaction_size_minimum;
 
+  //! The difficulty calculated last and the chain it was calculated on.
+  struct DifficultyCache {
+    CCriticalSection cs;
+    uint256 tip_hash;
+    Height height = 0;
+    Difficulty difficulty = 0;
+  };
+  mutable DifficultyCache m_difficulty_cache;
+
   void CheckConsistency() const;
 
  public:
@@ -50,6 +59,16 @@ class Behavior {
   CAmount CalculateBlockReward(const Height height);
 
   //! \brief Calculates the difficulty for BlockHeight
+  //!
+  //! The result only depends on the tip of the chain and the height, as the
+  //! hash of the tip commits to all the blocks below it. The proposer and the
+  //! stake validator ask for the same tip repeatedly, so the last result is
+  //! reused as long as the tip stays the same. A reorg changes the tip and
+  //! with it the cache key.
+  //!
+  //! While syncing every block comes with a new tip and misses the cache.
+  //! Such a miss costs about as much as a few arith_uint256 divisions (see
+  //! bench/difficulty.cpp), so the window is not accumulated incrementally.
   Difficulty CalculateDifficulty(Height, ChainAccess &) const;
 
   //! \brief Get a reference to the genesis block.
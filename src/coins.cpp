@@ -39,7 +39,7 @@ SaltedOutpointHasher::SaltedOutpointHasher() : k0(GetRand(std::numeric_limits<ui
 CCoinsViewCache::CCoinsViewCache(CCoinsView *baseIn) : CCoinsViewBacked(baseIn), snapshotHash(baseIn->GetSnapshotHash()), cachedCoinsUsage(0) {}
 
 size_t CCoinsViewCache::DynamicMemoryUsage() const {
-    return memusage::DynamicUsage(cacheCoins) + cachedCoinsUsage;
+    return memusage::DynamicUsage(cacheCoins) + cachedCoinsUsage + pendingSnapshotUTXOs.DynamicMemoryUsage();
 }
 
 CCoinsMap::iterator CCoinsViewCache::FetchCoin(const COutPoint &outpoint) const {
@@ -88,14 +88,14 @@ void CCoinsViewCache::AddCoin(const COutPoint &outpoint, Coin&& coin, bool possi
     if (!inserted) {
         if (!it->second.coin.IsSpent()) {
             // remove old UTXO before replacing it
-            snapshotHash.SubtractUTXO(snapshot::UTXO(outpoint, it->second.coin));
+            pendingSnapshotUTXOs.SubtractUTXO(snapshot::UTXO(outpoint, it->second.coin));
         }
     }
 
     it->second.coin = std::move(coin);
     it->second.flags |= CCoinsCacheEntry::DIRTY | (fresh ? CCoinsCacheEntry::FRESH : 0);
     cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
-    snapshotHash.AddUTXO(snapshot::UTXO(outpoint, it->second.coin));
+    pendingSnapshotUTXOs.AddUTXO(snapshot::UTXO(outpoint, it->second.coin));
 }
 
 void AddCoins(CCoinsViewCache& cache, const CTransaction &tx, int nHeight, bool check) {
@@ -112,7 +112,7 @@ bool CCoinsViewCache::SpendCoin(const COutPoint &outpoint, Coin* moveout) {
     CCoinsMap::iterator it = FetchCoin(outpoint);
     if (it == cacheCoins.end()) return false;
     cachedCoinsUsage -= it->second.coin.DynamicMemoryUsage();
-    snapshotHash.SubtractUTXO(snapshot::UTXO(outpoint, it->second.coin));
+    pendingSnapshotUTXOs.SubtractUTXO(snapshot::UTXO(outpoint, it->second.coin));
     if (moveout) {
         *moveout = std::move(it->second.coin);
     }
@@ -153,9 +153,18 @@ uint256 CCoinsViewCache::GetBestBlock() const {
 }
 
 snapshot::SnapshotHash CCoinsViewCache::GetSnapshotHash() const {
+    ApplyPendingSnapshotUTXOs();
     return snapshotHash;
 }
 
+void CCoinsViewCache::ApplyPendingSnapshotUTXOs() const {
+    if (pendingSnapshotUTXOs.IsEmpty()) {
+        return;
+    }
+    snapshotHash.Apply(pendingSnapshotUTXOs);
+    pendingSnapshotUTXOs.Clear();
+}
+
 void CCoinsViewCache::SetBestBlock(const uint256 &hashBlockIn) {
     hashBlock = hashBlockIn;
 }
@@ -215,11 +224,14 @@ bool CCoinsViewCache::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlockIn
         }
     }
     hashBlock = hashBlockIn;
+    // snapshotHashIn supersedes this view's hash, including pending changes
+    pendingSnapshotUTXOs.Clear();
     snapshotHash = snapshotHashIn;
     return true;
 }
 
 bool CCoinsViewCache::Flush() {
+    ApplyPendingSnapshotUTXOs();
     bool fOk = base->BatchWrite(cacheCoins, hashBlock, snapshotHash);
     cacheCoins.clear();
     cachedCoinsUsage = 0;
@@ -239,10 +251,11 @@ void CCoinsViewCache::ClearCoins() {
     base->ClearCoins();
     cacheCoins.clear();
     snapshotHash.Clear();
+    pendingSnapshotUTXOs.Clear();
     cachedCoinsUsage = 0;
 }
 
-bool CCoinsViewCache::ApplySnapshot(std::unique_ptr<snapshot::Indexer> &&indexer) {
+bool CCoinsViewCache::ApplySnapshot(std::unique_ptr<snapshot::Indexer> &&indexer, const size_t max_cache_usage) {
     LogPrint(BCLog::COINDB, "%s: Apply snapshot hash=%s.\n",
              __func__, indexer->GetSnapshotHeader().snapshot_hash.GetHex());
 
@@ -256,7 +269,6 @@ bool CCoinsViewCache::ApplySnapshot(std::unique_ptr<snapshot::Indexer> &&indexer
     hashBlock = snapshot_header.block_hash;
 
     uint64_t writtenSubsets = 0;
-    constexpr uint64_t batchSize = 100000;
     while (iter.Valid()) {
         snapshot::UTXOSubset &subset = iter.GetUTXOSubset();
         for (auto const &p : subset.outputs) {
@@ -267,7 +279,7 @@ bool CCoinsViewCache::ApplySnapshot(std::unique_ptr<snapshot::Indexer> &&indexer
 
         ++writtenSubsets;
 
-        if (writtenSubsets % batchSize == 0) { // ~12 MB/batch
+        if (DynamicMemoryUsage() > max_cache_usage) {
             if (!Flush()) {
                 LogPrint(BCLog::COINDB, "%s: can't write batch\n", __func__);
                 return false;
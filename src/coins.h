@@ -262,6 +262,13 @@ protected:
     mutable snapshot::SnapshotHash snapshotHash;
     mutable CCoinsMap cacheCoins;
 
+    /**
+     * UTXOs added and spent since snapshotHash was last brought up to date.
+     * Hashing them to the curve is deferred until the hash is needed, so
+     * that it's done in one parallel batch instead of per coin.
+     */
+    mutable snapshot::UTXOBatch pendingSnapshotUTXOs;
+
     /* Cached dynamic memory usage for the inner Coin objects. */
     mutable size_t cachedCoinsUsage;
 
@@ -323,9 +330,10 @@ public:
      */
     bool Flush();
 
-    //! ApplySnapshot adds all UTXOs from the snapshot to the cache and then invokes Flush().
+    //! ApplySnapshot adds all UTXOs from the snapshot to the cache and invokes Flush()
+    //! every time the cache grows over max_cache_usage bytes.
     //! If false is returned, the state of this cache (and its backing view) will be undefined.
-    bool ApplySnapshot(std::unique_ptr<snapshot::Indexer> &&indexer);
+    bool ApplySnapshot(std::unique_ptr<snapshot::Indexer> &&indexer, size_t max_cache_usage);
 
     //! Removes coins from the cache and from the base DB
     void ClearCoins() override;
@@ -357,6 +365,9 @@ public:
 
 private:
     CCoinsMap::iterator FetchCoin(const COutPoint &outpoint) const;
+
+    //! Folds pendingSnapshotUTXOs into snapshotHash.
+    void ApplyPendingSnapshotUTXOs() const;
 };
 
 //! Utility function to add all of a transaction's outputs to a cache.
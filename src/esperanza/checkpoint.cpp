@@ -5,6 +5,8 @@
 #include <esperanza/checkpoint.h>
 #include <util.h>
 
+#include <algorithm>
+
 namespace esperanza {
 
 Checkpoint::Checkpoint()
@@ -14,13 +16,60 @@ Checkpoint::Checkpoint()
       m_prev_dynasty_deposits(0),
       m_vote_set() {}
 
-uint64_t Checkpoint::GetCurDynastyVotes(uint32_t epoch) {
-  auto pair = m_cur_dynasty_votes.emplace(epoch, 0);
-  return pair.first->second;
+namespace {
+
+uint64_t &GetVotes(Checkpoint::VoteTally &tally, const uint32_t epoch) {
+  const auto it = std::lower_bound(
+      tally.begin(), tally.end(), epoch,
+      [](const Checkpoint::VoteTally::value_type &entry, const uint32_t e) { return entry.first < e; });
+  if (it != tally.end() && it->first == epoch) {
+    return it->second;
+  }
+  return tally.emplace(it, epoch, 0)->second;
+}
+
+}  // namespace
+
+uint64_t &Checkpoint::GetCurDynastyVotes(const uint32_t epoch) {
+  return GetVotes(m_cur_dynasty_votes, epoch);
+}
+
+uint64_t &Checkpoint::GetPrevDynastyVotes(const uint32_t epoch) {
+  return GetVotes(m_prev_dynasty_votes, epoch);
+}
+
+bool Checkpoint::HasVoted(const uint160 &validator_address) const {
+  return std::binary_search(m_vote_set.begin(), m_vote_set.end(), validator_address);
 }
-uint64_t Checkpoint::GetPrevDynastyVotes(uint32_t epoch) {
-  auto pair = m_prev_dynasty_votes.emplace(epoch, 0);
-  return pair.first->second;
+
+bool Checkpoint::AddVote(const uint160 &validator_address) {
+  const auto it = std::lower_bound(m_vote_set.begin(), m_vote_set.end(), validator_address);
+  if (it != m_vote_set.end() && *it == validator_address) {
+    return false;
+  }
+  m_vote_set.insert(it, validator_address);
+  return true;
+}
+
+void Checkpoint::Normalize() {
+  const auto by_epoch = [](const VoteTally::value_type &a, const VoteTally::value_type &b) {
+    return a.first < b.first;
+  };
+  for (VoteTally *tally : {&m_cur_dynasty_votes, &m_prev_dynasty_votes}) {
+    if (!std::is_sorted(tally->begin(), tally->end(), by_epoch)) {
+      std::stable_sort(tally->begin(), tally->end(), by_epoch);
+    }
+    // like std::map, keep the first entry of duplicate keys
+    tally->erase(std::unique(tally->begin(), tally->end(),
+                             [](const VoteTally::value_type &a, const VoteTally::value_type &b) {
+                               return a.first == b.first;
+                             }),
+                 tally->end());
+  }
+  if (!std::is_sorted(m_vote_set.begin(), m_vote_set.end())) {
+    std::sort(m_vote_set.begin(), m_vote_set.end());
+  }
+  m_vote_set.erase(std::unique(m_vote_set.begin(), m_vote_set.end()), m_vote_set.end());
 }
 
 bool Checkpoint::operator==(const Checkpoint &other) const {
@@ -8,14 +8,18 @@
 #include <serialize.h>
 #include <uint256.h>
 
-#include <map>
-#include <set>
+#include <utility>
 #include <vector>
 
 namespace esperanza {
 
 class Checkpoint {
  public:
+  //! Votes per source epoch, sorted by epoch. A checkpoint is voted for from
+  //! very few source epochs, so a vector saves a map node per epoch. The
+  //! serialized form is the same as the one of std::map<uint32_t, uint64_t>.
+  using VoteTally = std::vector<std::pair<uint32_t, uint64_t>>;
+
   Checkpoint();
 
   bool m_is_justified;
@@ -24,14 +28,23 @@ class Checkpoint {
   uint64_t m_cur_dynasty_deposits;
   uint64_t m_prev_dynasty_deposits;
 
-  std::map<uint32_t, uint64_t> m_cur_dynasty_votes;
-  std::map<uint32_t, uint64_t> m_prev_dynasty_votes;
+  VoteTally m_cur_dynasty_votes;
+  VoteTally m_prev_dynasty_votes;
+
+  //! Sorted addresses of the validators that voted for this checkpoint. A flat
+  //! vector is copied with a single allocation whenever the checkpoint is
+  //! detached from the parent state. The serialized form is the same as the one
+  //! of std::set<uint160>.
+  std::vector<uint160> m_vote_set;
 
-  // Set of validatorAddresses for validators that voted that checkpoint
-  std::set<uint160> m_vote_set;
+  //! \brief Returns the votes for the source epoch, adding an empty entry if missing.
+  uint64_t &GetCurDynastyVotes(uint32_t epoch);
+  uint64_t &GetPrevDynastyVotes(uint32_t epoch);
 
-  uint64_t GetCurDynastyVotes(uint32_t epoch);
-  uint64_t GetPrevDynastyVotes(uint32_t epoch);
+  bool HasVoted(const uint160 &validator_address) const;
+
+  //! \brief Records that the validator voted, returns false if it already had.
+  bool AddVote(const uint160 &validator_address);
 
   bool operator==(const Checkpoint &other) const;
 
@@ -46,9 +59,17 @@ class Checkpoint {
     READWRITE(m_cur_dynasty_votes);
     READWRITE(m_prev_dynasty_votes);
     READWRITE(m_vote_set);
+    if (ser_action.ForRead()) {
+      Normalize();
+    }
   };
 
   std::string ToString() const;
+
+ private:
+  //! Restores the ordering of the flat containers, which the serialized form
+  //! of a well-formed checkpoint already has.
+  void Normalize();
 };
 
 }  // namespace esperanza
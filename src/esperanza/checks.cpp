@@ -8,6 +8,7 @@
 #include <esperanza/finalizationstate.h>
 #include <esperanza/script.h>
 #include <script/interpreter.h>
+#include <script/sigcache.h>
 #include <script/sign.h>
 #include <script/standard.h>
 #include <txmempool.h>
@@ -19,7 +20,8 @@ namespace esperanza {
 bool ContextualCheckFinalizerCommit(const CTransaction &tx,
                                     CValidationState &err_state,
                                     const FinalizationState &fin_state,
-                                    const CCoinsView &view) {
+                                    const CCoinsView &view,
+                                    const bool cache_sig_store) {
   switch (tx.GetType()) {
     case +TxType::REGULAR:
     case +TxType::COINBASE:
@@ -27,7 +29,7 @@ bool ContextualCheckFinalizerCommit(const CTransaction &tx,
     case +TxType::DEPOSIT:
       return ContextualCheckDepositTx(tx, err_state, fin_state);
     case +TxType::VOTE:
-      return ContextualCheckVoteTx(tx, err_state, fin_state, view);
+      return ContextualCheckVoteTx(tx, err_state, fin_state, view, cache_sig_store);
     case +TxType::LOGOUT:
       return ContextualCheckLogoutTx(tx, err_state, fin_state, view);
     case +TxType::SLASH:
@@ -48,7 +50,9 @@ bool CheckFinalizerCommit(const CTransaction &tx, CValidationState &err_state) {
     case +TxType::DEPOSIT:
       return CheckDepositTx(tx, err_state, nullptr);
     case +TxType::VOTE:
-      return CheckVoteTx(tx, err_state, nullptr, nullptr);
+      // Blocks are checked before they are connected, which looks up the
+      // signature once more, so keep it in the cache.
+      return CheckVoteTx(tx, err_state, nullptr, nullptr, /* cache_sig_store= */ true);
     case +TxType::LOGOUT:
       return CheckLogoutTx(tx, err_state, nullptr);
     case +TxType::SLASH:
@@ -302,7 +306,8 @@ bool ContextualCheckWithdrawTx(const CTransaction &tx, CValidationState &err_sta
 }
 
 bool CheckVoteTx(const CTransaction &tx, CValidationState &err_state,
-                 Vote *vote_out, std::vector<unsigned char> *vote_sig_out) {
+                 Vote *vote_out, std::vector<unsigned char> *vote_sig_out,
+                 const bool cache_sig_store) {
 
   assert(tx.IsVote());
 
@@ -333,7 +338,7 @@ bool CheckVoteTx(const CTransaction &tx, CValidationState &err_state,
                          "bad-scriptpubkey-pubkey-format");
   }
 
-  if (!CheckVoteSignature(pubkey, *vote_out, *vote_sig_out)) {
+  if (!CachingCheckVoteSignature(pubkey, *vote_out, *vote_sig_out, cache_sig_store)) {
     return err_state.DoS(100, false, REJECT_INVALID, "bad-vote-signature");
   }
 
@@ -342,11 +347,12 @@ bool CheckVoteTx(const CTransaction &tx, CValidationState &err_state,
 
 bool ContextualCheckVoteTx(const CTransaction &tx, CValidationState &err_state,
                            const FinalizationState &fin_state,
-                           const CCoinsView &view) {
+                           const CCoinsView &view,
+                           const bool cache_sig_store) {
 
   Vote vote;
   std::vector<unsigned char> vote_sig;
-  if (!CheckVoteTx(tx, err_state, &vote, &vote_sig)) {
+  if (!CheckVoteTx(tx, err_state, &vote, &vote_sig, cache_sig_store)) {
     return false;
   }
 
@@ -36,21 +36,31 @@ bool IsVoteExpired(const CTransaction &tx, const FinalizationState &fin_state);
 bool CheckFinalizerCommit(const CTransaction &tx, CValidationState &err_state);
 
 //! \brief Generalized finalization transaction contextual check. Asserts on non-finalization transactions.
+//!
+//! cache_sig_store is passed to the vote signature check, see CheckVoteTx.
 bool ContextualCheckFinalizerCommit(const CTransaction &tx,
                                     CValidationState &err_state,
                                     const FinalizationState &fin_state,
-                                    const CCoinsView &view);
+                                    const CCoinsView &view,
+                                    bool cache_sig_store);
 
 bool CheckDepositTx(const CTransaction &tx, CValidationState &err_state,
                     uint160 *validator_address_out);
 bool ContextualCheckDepositTx(const CTransaction &tx, CValidationState &err_state,
                               const FinalizationState &fin_state);
 
+//! \brief Checks the vote transaction and the signature of its vote.
+//!
+//! The signature is looked up in the signature cache first. Like cacheSigStore
+//! of CheckInputs, cache_sig_store adds a valid signature to the cache, or
+//! keeps it there. Without it a cached signature is erased after the lookup.
 bool CheckVoteTx(const CTransaction &tx, CValidationState &err_state,
-                 Vote *vote_out, std::vector<unsigned char> *vote_sig_out);
+                 Vote *vote_out, std::vector<unsigned char> *vote_sig_out,
+                 bool cache_sig_store);
 bool ContextualCheckVoteTx(const CTransaction &tx, CValidationState &err_state,
                            const FinalizationState &fin_state,
-                           const CCoinsView &view);
+                           const CCoinsView &view,
+                           bool cache_sig_store);
 
 bool CheckSlashTx(const CTransaction &tx, CValidationState &err_state,
                   Vote *vote1_out, Vote *vote2_out);
@@ -61,6 +61,41 @@ FinalizationState::FinalizationState(FinalizationState &&parent)
       m_settings(parent.m_settings),
       m_status(parent.m_status) {}
 
+FinalizationState::FinalizationState(const FinalizationState &base, const Delta &delta)
+    : FinalizationState(delta.m_rest, delta.m_rest.m_status) {
+  m_checkpoints = base.m_checkpoints;
+  m_checkpoints.Apply(delta.m_checkpoints);
+  m_dynasty_start_epoch = base.m_dynasty_start_epoch;
+  m_dynasty_start_epoch.Apply(delta.m_dynasty_start_epoch);
+  m_validators = base.m_validators;
+  m_validators.Apply(delta.m_validators);
+  m_dynasty_deltas = base.m_dynasty_deltas;
+  m_dynasty_deltas.Apply(delta.m_dynasty_deltas);
+  m_deposit_scale_factor = base.m_deposit_scale_factor;
+  m_deposit_scale_factor.Apply(delta.m_deposit_scale_factor);
+  m_total_slashed = base.m_total_slashed;
+  m_total_slashed.Apply(delta.m_total_slashed);
+  m_validators.SetDynasty(m_current_dynasty);
+}
+
+FinalizationState::Delta::Delta(const finalization::Params &params) : m_rest(params) {}
+
+FinalizationState::Delta::Delta(const FinalizationState &base, const FinalizationState &target)
+    : m_checkpoints(base.m_checkpoints.Diff(target.m_checkpoints)),
+      m_dynasty_start_epoch(base.m_dynasty_start_epoch.Diff(target.m_dynasty_start_epoch)),
+      m_validators(base.m_validators.Diff(target.m_validators)),
+      m_dynasty_deltas(base.m_dynasty_deltas.Diff(target.m_dynasty_deltas)),
+      m_deposit_scale_factor(base.m_deposit_scale_factor.Diff(target.m_deposit_scale_factor)),
+      m_total_slashed(base.m_total_slashed.Diff(target.m_total_slashed)),
+      m_rest(target, target.m_status) {
+  m_rest.m_checkpoints.clear();
+  m_rest.m_dynasty_start_epoch.clear();
+  m_rest.m_validators.clear();
+  m_rest.m_dynasty_deltas.clear();
+  m_rest.m_deposit_scale_factor.clear();
+  m_rest.m_total_slashed.clear();
+}
+
 bool FinalizationState::operator==(const FinalizationState &other) const {
   return static_cast<const FinalizationStateData &>(*this) ==
          static_cast<const FinalizationStateData &>(other);
@@ -121,7 +156,7 @@ Result FinalizationState::InitializeEpoch(blockchain::Height blockHeight) {
 
   IncrementDynasty();
 
-  if (GetActiveFinalizers().empty()) {
+  if (!HasActiveFinalizers()) {
     InstaJustify();
   }
 
@@ -179,16 +214,13 @@ void FinalizationState::IncrementDynasty() {
     return;
   }
   m_current_dynasty += 1;
+  m_validators.SetDynasty(m_current_dynasty);
   m_prev_dyn_deposits = m_cur_dyn_deposits;
   m_cur_dyn_deposits += GetDynastyDelta(m_current_dynasty);
   m_dynasty_start_epoch[m_current_dynasty] = m_current_epoch;
 
-  for (auto it = m_checkpoints.begin(); it != m_checkpoints.end();) {
-    if (it->first < m_last_finalized_epoch) {
-      it = m_checkpoints.erase(it);
-    } else {
-      ++it;
-    }
+  while (!m_checkpoints.empty() && m_checkpoints.begin()->first < m_last_finalized_epoch) {
+    m_checkpoints.erase(m_checkpoints.begin()->first);
   }
 
   LogPrint(BCLog::FINALIZATION, "%s: New current dynasty=%d\n", __func__,
@@ -235,20 +267,20 @@ uint32_t FinalizationState::GetEpochsSinceFinalization() const {
 void FinalizationState::DeleteValidator(const uint160 &validatorAddress) {
   LOCK(cs_esperanza);
 
-  m_validators.erase(validatorAddress);
+  m_validators.Erase(validatorAddress);
 }
 
 uint64_t FinalizationState::GetDepositSize(const uint160 &validatorAddress) const {
   LOCK(cs_esperanza);
 
-  auto validatorIt = m_validators.find(validatorAddress);
+  const Validator *validator = m_validators.Get(validatorAddress);
   auto depositScaleIt = m_deposit_scale_factor.find(m_current_epoch);
 
-  if (validatorIt != m_validators.end() &&
-      !validatorIt->second.m_is_slashed &&
+  if (validator != nullptr &&
+      !validator->m_is_slashed &&
       depositScaleIt != m_deposit_scale_factor.end()) {
 
-    return ufp64::mul_to_uint(depositScaleIt->second, validatorIt->second.m_deposit);
+    return ufp64::mul_to_uint(depositScaleIt->second, validator->m_deposit);
   } else {
     return 0;
   }
@@ -279,10 +311,7 @@ Vote FinalizationState::GetRecommendedVote(const uint160 &validatorAddress) cons
 }
 
 bool FinalizationState::IsInDynasty(const Validator &validator, uint32_t dynasty) const {
-
-  uint32_t startDynasty = validator.m_start_dynasty;
-  uint32_t endDynasty = validator.m_end_dynasty;
-  return (startDynasty <= dynasty) && (dynasty < endDynasty);
+  return ValidatorSet::IsInDynasty(validator, dynasty);
 }
 
 uint64_t FinalizationState::GetTotalCurDynDeposits() const {
@@ -300,10 +329,12 @@ uint64_t FinalizationState::GetTotalPrevDynDeposits() const {
   return ufp64::mul_to_uint(GetDepositScaleFactor(m_current_epoch - 1), m_prev_dyn_deposits);
 }
 
-CAmount FinalizationState::ProcessReward(const uint160 &validatorAddress, uint64_t reward) {
+CAmount FinalizationState::ProcessReward(const ValidatorSet::Id validatorId, uint64_t reward) {
 
-  Validator &validator = m_validators.at(validatorAddress);
-  validator.m_deposit = validator.m_deposit + reward;
+  m_validators.Modify(validatorId, [reward](Validator &validator) {
+    validator.m_deposit = validator.m_deposit + reward;
+  });
+  const Validator &validator = m_validators.Get(validatorId);
   uint32_t startDynasty = validator.m_start_dynasty;
   uint32_t endDynasty = validator.m_end_dynasty;
 
@@ -342,8 +373,7 @@ Result FinalizationState::IsVotable(const Validator &validator,
   }
 
   auto &targetCheckpoint = it->second;
-  bool alreadyVoted = targetCheckpoint.m_vote_set.find(validatorAddress) !=
-                      targetCheckpoint.m_vote_set.end();
+  bool alreadyVoted = targetCheckpoint.HasVoted(validatorAddress);
 
   if (alreadyVoted) {
     return fail(Result::VOTE_ALREADY_VOTED,
@@ -407,7 +437,7 @@ Result FinalizationState::ValidateDeposit(const uint160 &validatorAddress,
                 validatorAddress.GetHex());
   }
 
-  if (m_validators.find(validatorAddress) != m_validators.end()) {
+  if (m_validators.Find(validatorAddress) != ValidatorSet::NO_ID) {
     return fail(Result::DEPOSIT_DUPLICATE,
                 /*log_errors=*/true,
                 "%s: validator=%s with the deposit already exists.\n",
@@ -432,9 +462,7 @@ void FinalizationState::ProcessDeposit(const uint160 &validatorAddress,
   uint64_t scaledDeposit = ufp64::div_to_uint(static_cast<uint64_t>(depositValue),
                                               GetDepositScaleFactor(m_current_epoch));
 
-  m_validators.insert(std::pair<uint160, Validator>(
-      validatorAddress,
-      Validator(scaledDeposit, startDynasty, validatorAddress)));
+  m_validators.Insert(Validator(scaledDeposit, startDynasty, validatorAddress));
 
   m_dynasty_deltas[startDynasty] = GetDynastyDelta(startDynasty) + scaledDeposit;
 
@@ -457,15 +485,15 @@ Result FinalizationState::ValidateVote(const Vote &vote, const bool log_errors)
                 vote.m_validator_address.GetHex());
   }
 
-  auto it = m_validators.find(vote.m_validator_address);
-  if (it == m_validators.end()) {
+  const Validator *validator = m_validators.Get(vote.m_validator_address);
+  if (validator == nullptr) {
     return fail(Result::VOTE_NOT_BY_VALIDATOR,
                 log_errors,
                 "%s: No validator with index %s found.\n", __func__,
                 vote.m_validator_address.GetHex());
   }
 
-  Result isVotable = IsVotable(it->second, vote.m_target_hash,
+  Result isVotable = IsVotable(*validator, vote.m_target_hash,
                                vote.m_target_epoch, vote.m_source_epoch,
                                log_errors);
 
@@ -494,7 +522,8 @@ Result FinalizationState::ValidateVote(const Vote &vote, const bool log_errors)
 void FinalizationState::ProcessVote(const Vote &vote) {
   LOCK(cs_esperanza);
 
-  GetCheckpoint(vote.m_target_epoch).m_vote_set.insert(vote.m_validator_address);
+  Checkpoint &targetCheckpoint = GetCheckpoint(vote.m_target_epoch);
+  targetCheckpoint.AddVote(vote.m_validator_address);
 
   LogPrint(BCLog::FINALIZATION, /* Continued */
            "%s: validator=%s voted successfully. target=%s source_epoch=%d target_epoch=%d.\n",
@@ -507,28 +536,25 @@ void FinalizationState::ProcessVote(const Vote &vote) {
   const uint160 &validatorAddress = vote.m_validator_address;
   uint32_t sourceEpoch = vote.m_source_epoch;
   uint32_t targetEpoch = vote.m_target_epoch;
-  const Validator &validator = m_validators.at(validatorAddress);
+  const ValidatorSet::Id validatorId = m_validators.GetId(validatorAddress);
+  const Validator &validator = m_validators.Get(validatorId);
 
   bool inCurDynasty = IsInDynasty(validator, m_current_dynasty);
   bool inPrevDynasty = IsInDynasty(validator, m_current_dynasty - 1);
 
-  uint64_t curDynastyVotes = GetCheckpoint(targetEpoch).GetCurDynastyVotes(sourceEpoch);
-
-  uint64_t prevDynastyVotes = GetCheckpoint(targetEpoch).GetPrevDynastyVotes(sourceEpoch);
-
+  uint64_t &curDynastyVotes = targetCheckpoint.GetCurDynastyVotes(sourceEpoch);
   if (inCurDynasty) {
     curDynastyVotes += validator.m_deposit;
-    GetCheckpoint(targetEpoch).m_cur_dynasty_votes[sourceEpoch] = curDynastyVotes;
   }
 
+  uint64_t &prevDynastyVotes = targetCheckpoint.GetPrevDynastyVotes(sourceEpoch);
   if (inPrevDynasty) {
     prevDynastyVotes += validator.m_deposit;
-    GetCheckpoint(targetEpoch).m_prev_dynasty_votes[sourceEpoch] = prevDynastyVotes;
   }
 
   if (m_expected_source_epoch == sourceEpoch) {
     uint64_t reward = CalculateVoteReward(validator);
-    ProcessReward(validatorAddress, reward);
+    ProcessReward(validatorId, reward);
   }
 
   bool isTwoThirdsCurDyn =
@@ -539,16 +565,16 @@ void FinalizationState::ProcessVote(const Vote &vote) {
 
   bool enoughVotes = isTwoThirdsCurDyn && isTwoThirdsPrevDyn;
 
-  if (enoughVotes && !GetCheckpoint(targetEpoch).m_is_justified) {
+  if (enoughVotes && !targetCheckpoint.m_is_justified) {
 
-    GetCheckpoint(targetEpoch).m_is_justified = true;
+    targetCheckpoint.m_is_justified = true;
     m_last_justified_epoch = targetEpoch;
 
     LogPrint(BCLog::FINALIZATION, "%s: epoch=%d justified.\n", __func__,
              targetEpoch);
 
     if (targetEpoch == sourceEpoch + 1) {
-      GetCheckpoint(targetEpoch).m_is_finalized = true;
+      targetCheckpoint.m_is_finalized = true;
       m_last_finalized_epoch = targetEpoch;
       LogPrint(BCLog::FINALIZATION, "%s: epoch=%d finalized.\n", __func__,
                sourceEpoch);
@@ -565,8 +591,8 @@ uint32_t FinalizationState::GetEndDynasty() const {
 Result FinalizationState::ValidateLogout(const uint160 &validatorAddress) const {
   LOCK(cs_esperanza);
 
-  auto it = m_validators.find(validatorAddress);
-  if (it == m_validators.end()) {
+  const Validator *const validatorPtr = m_validators.Get(validatorAddress);
+  if (validatorPtr == nullptr) {
     return fail(Result::LOGOUT_NOT_A_VALIDATOR,
                 /*log_errors=*/true,
                 "%s: No validator with index %s found.\n", __func__,
@@ -574,7 +600,7 @@ Result FinalizationState::ValidateLogout(const uint160 &validatorAddress) const
   }
 
   uint32_t endDynasty = GetEndDynasty();
-  const Validator &validator = it->second;
+  const Validator &validator = *validatorPtr;
 
   if (validator.m_start_dynasty > m_current_dynasty) {
     return fail(Result::LOGOUT_NOT_YET_A_VALIDATOR,
@@ -597,12 +623,15 @@ Result FinalizationState::ValidateLogout(const uint160 &validatorAddress) const
 void FinalizationState::ProcessLogout(const uint160 &validatorAddress) {
   LOCK(cs_esperanza);
 
-  Validator &validator = m_validators.at(validatorAddress);
+  const ValidatorSet::Id validatorId = m_validators.GetId(validatorAddress);
 
   uint32_t endDyn = GetEndDynasty();
-  validator.m_end_dynasty = endDyn;
-  validator.m_deposits_at_logout = m_cur_dyn_deposits;
-  m_dynasty_deltas[endDyn] = GetDynastyDelta(endDyn) - validator.m_deposit;
+  const CAmount depositsAtLogout = m_cur_dyn_deposits;
+  m_validators.Modify(validatorId, [endDyn, depositsAtLogout](Validator &validator) {
+    validator.m_end_dynasty = endDyn;
+    validator.m_deposits_at_logout = depositsAtLogout;
+  });
+  m_dynasty_deltas[endDyn] = GetDynastyDelta(endDyn) - m_validators.Get(validatorId).m_deposit;
 
   LogPrint(BCLog::FINALIZATION, /* Continued */
            "%s: validator=%s logging out at dynasty=%d.\n", __func__,
@@ -637,15 +666,15 @@ Result FinalizationState::CalculateWithdrawAmount(const uint160 &validatorAddres
 
   withdrawAmountOut = 0;
 
-  auto it = m_validators.find(validatorAddress);
-  if (it == m_validators.end()) {
+  const Validator *const validatorPtr = m_validators.Get(validatorAddress);
+  if (validatorPtr == nullptr) {
     return fail(Result::WITHDRAW_NOT_A_VALIDATOR,
                 /*log_errors=*/true,
                 "%s: No validator with index %s found.\n", __func__,
                 validatorAddress.GetHex());
   }
 
-  const Validator &validator = it->second;
+  const Validator &validator = *validatorPtr;
   const uint32_t withdrawalEpoch = CalculateWithdrawEpoch(validator);
   if (m_current_epoch < withdrawalEpoch) {
     return fail(Result::WITHDRAW_TOO_EARLY,
@@ -750,23 +779,23 @@ Result FinalizationState::IsSlashable(const Vote &vote1,
                                       bool log_errors) const {
   LOCK(cs_esperanza);
 
-  auto it = m_validators.find(vote1.m_validator_address);
-  if (it == m_validators.end()) {
+  const Validator *const validatorPtr1 = m_validators.Get(vote1.m_validator_address);
+  if (validatorPtr1 == nullptr) {
     return fail(Result::SLASH_NOT_A_VALIDATOR,
                 log_errors,
                 "%s: No validator with index %s found.\n", __func__,
                 vote1.m_validator_address.GetHex());
   }
-  const Validator &validator1 = it->second;
+  const Validator &validator1 = *validatorPtr1;
 
-  it = m_validators.find(vote2.m_validator_address);
-  if (it == m_validators.end()) {
+  const Validator *const validatorPtr2 = m_validators.Get(vote2.m_validator_address);
+  if (validatorPtr2 == nullptr) {
     return fail(Result::SLASH_NOT_A_VALIDATOR,
                 log_errors,
                 "%s: No validator with index %s found.\n", __func__,
                 vote2.m_validator_address.GetHex());
   }
-  const Validator &validator2 = it->second;
+  const Validator &validator2 = *validatorPtr2;
 
   uint160 validatorAddress1 = validator1.m_validator_address;
   uint160 validatorAddress2 = validator2.m_validator_address;
@@ -830,32 +859,34 @@ void FinalizationState::ProcessSlash(const Vote &vote1, const Vote &vote2) {
   m_total_slashed[m_current_epoch] =
       GetTotalSlashed(m_current_epoch) + validatorDeposit;
 
-  m_validators.at(validatorAddress).m_is_slashed = true;
+  m_validators.Modify(m_validators.GetId(validatorAddress), [this](Validator &validator) {
+    validator.m_is_slashed = true;
+
+    const uint32_t endDynasty = validator.m_end_dynasty;
+
+    // if validator not logged out yet, remove total from next dynasty
+    // and forcibly logout next dynasty
+    if (m_current_dynasty < endDynasty) {
+      const CAmount deposit = validator.m_deposit;
+      m_dynasty_deltas[m_current_dynasty + 1] =
+          GetDynastyDelta(m_current_dynasty + 1) - deposit;
+      validator.m_end_dynasty = m_current_dynasty + 1;
+
+      // if validator was already staged for logout at end_dynasty,
+      // ensure that we don't doubly remove from total
+      if (endDynasty < MAX_END_DYNASTY) {
+        m_dynasty_deltas[endDynasty] = GetDynastyDelta(endDynasty) + deposit;
+      } else {
+        // if no previously logged out, remember the total deposits at logout
+        validator.m_deposits_at_logout =
+            GetTotalCurDynDeposits();
+      }
+    }
+  });
 
   LogPrint(BCLog::FINALIZATION, /* Continued */
            "%s: Slashing validator with deposit hash %s of %d units.\n",
            __func__, validatorAddress.GetHex(), validatorDeposit);
-
-  const uint32_t endDynasty = m_validators.at(validatorAddress).m_end_dynasty;
-
-  // if validator not logged out yet, remove total from next dynasty
-  // and forcibly logout next dynasty
-  if (m_current_dynasty < endDynasty) {
-    const CAmount deposit = m_validators.at(validatorAddress).m_deposit;
-    m_dynasty_deltas[m_current_dynasty + 1] =
-        GetDynastyDelta(m_current_dynasty + 1) - deposit;
-    m_validators.at(validatorAddress).m_end_dynasty = m_current_dynasty + 1;
-
-    // if validator was already staged for logout at end_dynasty,
-    // ensure that we don't doubly remove from total
-    if (endDynasty < MAX_END_DYNASTY) {
-      m_dynasty_deltas[endDynasty] = GetDynastyDelta(endDynasty) + deposit;
-    } else {
-      // if no previously logged out, remember the total deposits at logout
-      m_validators.at(validatorAddress).m_deposits_at_logout =
-          GetTotalCurDynDeposits();
-    }
-  }
 }
 
 uint32_t FinalizationState::GetCurrentEpoch() const { return m_current_epoch; }
@@ -888,25 +919,16 @@ blockchain::Height FinalizationState::GetEpochCheckpointHeight(const uint32_t ep
   return m_settings.GetEpochCheckpointHeight(epoch);
 }
 
-std::vector<Validator> FinalizationState::GetActiveFinalizers() const {
-  std::vector<Validator> res;
-  for (const auto &it : m_validators) {
-    if (IsFinalizerVoting(it.second)) {
-      res.push_back(it.second);
-    }
-  }
-  return res;
+bool FinalizationState::HasActiveFinalizers() const {
+  return m_validators.AnyVoting(m_current_dynasty);
 }
 
-const Validator *FinalizationState::GetValidator(const uint160 &validatorAddress) const {
-
-  auto it = m_validators.find(validatorAddress);
+size_t FinalizationState::GetActiveFinalizersCount() const {
+  return m_validators.CountVoting(m_current_dynasty);
+}
 
-  if (it != m_validators.end()) {
-    return &it->second;
-  } else {
-    return nullptr;
-  }
+const Validator *FinalizationState::GetValidator(const uint160 &validatorAddress) const {
+  return m_validators.Get(validatorAddress);
 }
 
 bool FinalizationState::ValidateDepositAmount(CAmount amount) const {
@@ -1044,9 +1066,9 @@ CAmount FinalizationState::GetDynastyDelta(uint32_t dynasty) {
 }
 
 Checkpoint &FinalizationState::GetCheckpoint(uint32_t epoch) {
-  const auto it = m_checkpoints.find(epoch);
-  assert(it != m_checkpoints.end());
-  return it->second;
+  Checkpoint *const checkpoint = m_checkpoints.find_mutable(epoch);
+  assert(checkpoint != nullptr);
+  return *checkpoint;
 }
 
 const Checkpoint &FinalizationState::GetCheckpoint(const uint32_t epoch) const {
@@ -1058,12 +1080,14 @@ const Checkpoint &FinalizationState::GetCheckpoint(const uint32_t epoch) const {
 void FinalizationState::RegisterLastTx(uint160 &validatorAddress,
                                        CTransactionRef tx) {
 
-  Validator &validator = m_validators.at(validatorAddress);
-  validator.m_last_transaction_hash = tx->GetHash();
+  const uint256 txHash = tx->GetHash();
+  m_validators.Modify(m_validators.GetId(validatorAddress), [&txHash](Validator &validator) {
+    validator.m_last_transaction_hash = txHash;
+  });
 }
 
 uint256 FinalizationState::GetLastTxHash(const uint160 &validatorAddress) const {
-  const Validator &validator = m_validators.at(validatorAddress);
+  const Validator &validator = m_validators.Get(m_validators.GetId(validatorAddress));
   return validator.m_last_transaction_hash;
 }
 
@@ -1079,12 +1103,12 @@ FinalizationState::InitStatus FinalizationState::GetInitStatus() const {
 }
 
 bool FinalizationState::IsFinalizerVoting(const uint160 &finalizer_address) const {
-  const esperanza::Validator *finalizer = GetValidator(finalizer_address);
-  if (!finalizer) {
+  const ValidatorSet::Id finalizer_id = m_validators.Find(finalizer_address);
+  if (finalizer_id == ValidatorSet::NO_ID) {
     return false;
   }
 
-  return IsFinalizerVoting(*finalizer);
+  return m_validators.IsVoting(finalizer_id, m_current_dynasty);
 }
 
 bool FinalizationState::IsFinalizerVoting(const Validator &finalizer) const {
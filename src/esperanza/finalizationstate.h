@@ -65,9 +65,16 @@ class FinalizationState : public FinalizationStateData {
     COMPLETED = 2,
   };
 
+  class Delta;
+
   FinalizationState(const finalization::Params &params);
   FinalizationState(const FinalizationState &parent, InitStatus status = NEW);
   FinalizationState(FinalizationState &&parent);
+
+  //! \brief Derives a state from base by applying delta.
+  //!
+  //! The delta must have been computed against base, see Delta.
+  FinalizationState(const FinalizationState &base, const Delta &delta);
   bool operator==(const FinalizationState &other) const;
   bool operator!=(const FinalizationState &other) const;
 
@@ -137,7 +144,13 @@ class FinalizationState : public FinalizationStateData {
 
   Vote GetRecommendedVote(const uint160 &validatorAddress) const;
 
-  std::vector<Validator> GetActiveFinalizers() const;
+  //! \brief Returns whether there is at least one finalizer voting in the
+  //! current dynasty.
+  bool HasActiveFinalizers() const;
+
+  //! \brief Returns the number of finalizers voting in the current dynasty.
+  size_t GetActiveFinalizersCount() const;
+
   const Validator *GetValidator(const uint160 &validatorAddress) const;
 
   uint32_t GetEpochLength() const;
@@ -201,9 +214,9 @@ class FinalizationState : public FinalizationStateData {
                    bool log_errors) const;
 
   bool IsInDynasty(const Validator &validator, uint32_t dynasty) const;
-  CAmount ProcessReward(const uint160 &validatorAddress, uint64_t reward);
+  CAmount ProcessReward(ValidatorSet::Id validatorId, uint64_t reward);
 
-  //! Removes a validator from the validator map.
+  //! Removes a validator from the validator set.
   void DeleteValidator(const uint160 &validatorAddress);
 
   uint64_t GetTotalCurDynDeposits() const;
@@ -238,6 +251,43 @@ class FinalizationState : public FinalizationStateData {
   }
 };
 
+//! \brief The changes which turn a finalization state into another one.
+//!
+//! A block changes only a few entries of the maps and validators of the state,
+//! hence these are recorded as differences. The other members are small, they
+//! are recorded as they are by keeping a copy of the target state with its maps
+//! and validators emptied.
+class FinalizationState::Delta {
+ public:
+  explicit Delta(const finalization::Params &params);
+  Delta(const FinalizationState &base, const FinalizationState &target);
+
+ private:
+  friend class FinalizationState;
+
+  util::PersistentMap<uint32_t, Checkpoint>::Delta m_checkpoints;
+  util::PersistentMap<uint32_t, uint32_t>::Delta m_dynasty_start_epoch;
+  ValidatorSet::Delta m_validators;
+  util::PersistentMap<uint32_t, CAmount>::Delta m_dynasty_deltas;
+  util::PersistentMap<uint32_t, ufp64::ufp64_t>::Delta m_deposit_scale_factor;
+  util::PersistentMap<uint32_t, CAmount>::Delta m_total_slashed;
+  FinalizationState m_rest;
+
+ public:
+  ADD_SERIALIZE_METHODS
+
+  template <typename Stream, typename Operation>
+  void SerializationOp(Stream &s, Operation ser_action) {
+    READWRITE(m_checkpoints);
+    READWRITE(m_dynasty_start_epoch);
+    READWRITE(m_validators);
+    READWRITE(m_dynasty_deltas);
+    READWRITE(m_deposit_scale_factor);
+    READWRITE(m_total_slashed);
+    READWRITE(m_rest);
+  }
+};
+
 }  // namespace esperanza
 
 #endif  // UNITE_ESPERANZA_FINALIZATIONSTATE_H
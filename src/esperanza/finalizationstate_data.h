@@ -7,10 +7,11 @@
 
 #include <esperanza/adminstate.h>
 #include <esperanza/checkpoint.h>
-#include <esperanza/validator.h>
+#include <esperanza/validatorset.h>
 #include <serialize.h>
 #include <ufp64.h>
 #include <uint256.h>
+#include <util/persistent_map.h>
 
 namespace esperanza {
 
@@ -40,25 +41,30 @@ class FinalizationStateData {
    * ufp64t and uint64_t are safe since for the intermediate step a bigger int
    * type is used, but if the result is not representable by 32 bits then the
    * final value will overflow.
+   *
+   * The maps are persistent maps and the validators are kept in a
+   * ValidatorSet: a state copied from its parent shares all the entries with
+   * it and only the entries modified afterwards are copied. Hence copying a
+   * state is cheap regardless of the number of validators.
    */
 
   // Map of epoch number to checkpoint
-  std::map<uint32_t, Checkpoint> m_checkpoints;
+  util::PersistentMap<uint32_t, Checkpoint> m_checkpoints;
 
   // Map of dynasty number to the starting epoch number
-  std::map<uint32_t, uint32_t> m_dynasty_start_epoch;
+  util::PersistentMap<uint32_t, uint32_t> m_dynasty_start_epoch;
 
-  // List of validators
-  std::map<uint160, Validator> m_validators;
+  // Validators by address, tracking who is in m_current_dynasty
+  ValidatorSet m_validators;
 
   // Map of the dynasty number with the delta in deposits with the previous one
-  std::map<uint32_t, CAmount> m_dynasty_deltas;
+  util::PersistentMap<uint32_t, CAmount> m_dynasty_deltas;
 
   // Map of the epoch number with the deposit scale factor
-  std::map<uint32_t, ufp64::ufp64_t> m_deposit_scale_factor;
+  util::PersistentMap<uint32_t, ufp64::ufp64_t> m_deposit_scale_factor;
 
   // Map of the epoch number with the running total of deposits slashed
-  std::map<uint32_t, CAmount> m_total_slashed;
+  util::PersistentMap<uint32_t, CAmount> m_total_slashed;
 
   // The current epoch number
   uint32_t m_current_epoch = 0;
@@ -112,6 +118,9 @@ class FinalizationStateData {
     READWRITE(m_recommended_target_epoch);
     READWRITE(m_reward_factor);
     READWRITE(m_admin_state);
+    if (ser_action.ForRead()) {
+      m_validators.SetDynasty(m_current_dynasty);
+    }
   };
 
   std::string ToString() const;
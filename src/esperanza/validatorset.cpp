@@ -0,0 +1,393 @@
+// Copyright (c) 2019 The Unit-e developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <esperanza/validatorset.h>
+
+#include <hash.h>
+#include <random.h>
+#include <util.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace esperanza {
+
+constexpr ValidatorSet::Id ValidatorSet::NO_ID;
+constexpr std::size_t ValidatorSet::BITS_PER_WORD;
+
+namespace {
+
+unsigned int PopCount(uint64_t word) {
+  word = word - ((word >> 1) & 0x5555555555555555ULL);
+  word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+  word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return static_cast<unsigned int>((word * 0x0101010101010101ULL) >> 56);
+}
+
+}  // namespace
+
+//! \brief Maps validator addresses to ids.
+//!
+//! An open addressing hash table with linear probing which is kept at most
+//! half full. Addresses are chosen by the finalizers, hence they are hashed
+//! with a random key so that they cannot be picked to collide.
+class ValidatorSet::Index {
+ public:
+  Index()
+      : m_k0(GetRand(std::numeric_limits<uint64_t>::max())),
+        m_k1(GetRand(std::numeric_limits<uint64_t>::max())) {}
+
+  Id Find(const uint160 &address) const {
+    if (m_buckets.empty()) {
+      return NO_ID;
+    }
+    for (std::size_t i = Home(address);; i = Next(i)) {
+      const Bucket &bucket = m_buckets[i];
+      if (bucket.id == NO_ID || bucket.address == address) {
+        return bucket.id;
+      }
+    }
+  }
+
+  //! Adds an address which is not in the index yet.
+  void Insert(const uint160 &address, const Id id) {
+    if ((m_size + 1) * 2 > m_buckets.size()) {
+      Grow();
+    }
+    std::size_t i = Home(address);
+    while (m_buckets[i].id != NO_ID) {
+      i = Next(i);
+    }
+    m_buckets[i].address = address;
+    m_buckets[i].id = id;
+    ++m_size;
+  }
+
+  //! Removes an address which is in the index.
+  //!
+  //! The entries following it are shifted back instead of leaving a tombstone,
+  //! so that lookups never have to probe past removed entries.
+  void Erase(const uint160 &address) {
+    std::size_t hole = Home(address);
+    while (m_buckets[hole].address != address) {
+      assert(m_buckets[hole].id != NO_ID);
+      hole = Next(hole);
+    }
+    for (std::size_t i = Next(hole); m_buckets[i].id != NO_ID; i = Next(i)) {
+      // The entry at i may fill the hole if its probe sequence passes the hole.
+      const std::size_t mask = m_buckets.size() - 1;
+      if (((i - Home(m_buckets[i].address)) & mask) >= ((i - hole) & mask)) {
+        m_buckets[hole] = m_buckets[i];
+        hole = i;
+      }
+    }
+    m_buckets[hole] = Bucket();
+    --m_size;
+  }
+
+ private:
+  struct Bucket {
+    uint160 address;
+    Id id = NO_ID;
+  };
+
+  static constexpr std::size_t MIN_BUCKETS = 16;
+
+  std::size_t Home(const uint160 &address) const {
+    const uint64_t hash = CSipHasher(m_k0, m_k1).Write(address.begin(), address.size()).Finalize();
+    return static_cast<std::size_t>(hash) & (m_buckets.size() - 1);
+  }
+
+  std::size_t Next(const std::size_t i) const { return (i + 1) & (m_buckets.size() - 1); }
+
+  void Grow() {
+    std::vector<Bucket> buckets(std::max(MIN_BUCKETS, m_buckets.size() * 2));
+    buckets.swap(m_buckets);
+    m_size = 0;
+    for (const Bucket &bucket : buckets) {
+      if (bucket.id != NO_ID) {
+        Insert(bucket.address, bucket.id);
+      }
+    }
+  }
+
+  std::vector<Bucket> m_buckets;
+  std::size_t m_size = 0;
+  uint64_t m_k0;
+  uint64_t m_k1;
+};
+
+constexpr std::size_t ValidatorSet::Index::MIN_BUCKETS;
+
+ValidatorSet::Id ValidatorSet::Find(const uint160 &address) const {
+  return m_index ? m_index->Find(address) : NO_ID;
+}
+
+ValidatorSet::Id ValidatorSet::GetId(const uint160 &address) const {
+  const Id id = Find(address);
+  if (id == NO_ID) {
+    throw std::out_of_range("ValidatorSet::GetId");
+  }
+  return id;
+}
+
+const Validator *ValidatorSet::Get(const uint160 &address) const {
+  const Id id = Find(address);
+  return id != NO_ID ? &m_validators[id] : nullptr;
+}
+
+bool ValidatorSet::Insert(const Validator &validator) {
+  if (Find(validator.m_validator_address) != NO_ID) {
+    return false;
+  }
+  const Id id = NextFreeId();
+  if (id == m_validators.size()) {
+    if (id % BITS_PER_WORD == 0) {
+      m_used.push_back(0);
+      m_in_dynasty.push_back(0);
+      m_in_previous_dynasty.push_back(0);
+    }
+    m_validators.push_back(validator);
+  } else {
+    m_validators.at_mutable(id) = validator;
+  }
+  SetBit(m_used, id, true);
+  MutableIndex().Insert(validator.m_validator_address, id);
+  UpdateDynastyBits(id, validator);
+  ++m_size;
+  return true;
+}
+
+void ValidatorSet::Upsert(const Validator &validator) {
+  const Id id = Find(validator.m_validator_address);
+  if (id == NO_ID) {
+    Insert(validator);
+    return;
+  }
+  Modify(id, [&validator](Validator &existing) { existing = validator; });
+}
+
+bool ValidatorSet::Erase(const uint160 &address) {
+  const Id id = Find(address);
+  if (id == NO_ID) {
+    return false;
+  }
+  SetBit(m_used, id, false);
+  SetBit(m_in_dynasty, id, false);
+  SetBit(m_in_previous_dynasty, id, false);
+  MutableIndex().Erase(address);
+  --m_size;
+  return true;
+}
+
+void ValidatorSet::clear() {
+  m_validators.clear();
+  m_used.clear();
+  m_in_dynasty.clear();
+  m_in_previous_dynasty.clear();
+  m_index.reset();
+  m_size = 0;
+}
+
+bool ValidatorSet::IsInDynasty(const Validator &validator, const uint32_t dynasty) {
+  return validator.m_start_dynasty <= dynasty && dynasty < validator.m_end_dynasty;
+}
+
+void ValidatorSet::SetDynasty(const uint32_t dynasty) {
+  if (dynasty == m_dynasty) {
+    return;
+  }
+  if (dynasty == m_dynasty + 1) {
+    m_in_previous_dynasty = m_in_dynasty;
+  } else {
+    m_in_previous_dynasty = BuildDynastyBits(dynasty - 1);
+  }
+  m_in_dynasty = BuildDynastyBits(dynasty);
+  m_dynasty = dynasty;
+}
+
+bool ValidatorSet::IsVoting(const Id id, const uint32_t dynasty) const {
+  if (dynasty != m_dynasty) {
+    const Validator &validator = Get(id);
+    return IsInDynasty(validator, dynasty) || IsInDynasty(validator, dynasty - 1);
+  }
+  return GetBit(m_in_dynasty, id) || GetBit(m_in_previous_dynasty, id);
+}
+
+std::size_t ValidatorSet::CountVoting(const uint32_t dynasty) const {
+  std::size_t count = 0;
+  if (dynasty != m_dynasty) {
+    for (Id id = 0; id < m_validators.size(); ++id) {
+      if (IsUsed(id) && IsVoting(id, dynasty)) {
+        ++count;
+      }
+    }
+    return count;
+  }
+  for (std::size_t i = 0; i < m_used.size(); ++i) {
+    count += PopCount(m_in_dynasty[i] | m_in_previous_dynasty[i]);
+  }
+  return count;
+}
+
+bool ValidatorSet::AnyVoting(const uint32_t dynasty) const {
+  if (dynasty != m_dynasty) {
+    for (Id id = 0; id < m_validators.size(); ++id) {
+      if (IsUsed(id) && IsVoting(id, dynasty)) {
+        return true;
+      }
+    }
+    return false;
+  }
+  for (std::size_t i = 0; i < m_used.size(); ++i) {
+    if ((m_in_dynasty[i] | m_in_previous_dynasty[i]) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ValidatorSet::operator==(const ValidatorSet &other) const {
+  if (m_size != other.m_size) {
+    return false;
+  }
+  for (Id id = 0; id < m_validators.size(); ++id) {
+    if (!IsUsed(id)) {
+      continue;
+    }
+    const Validator &validator = m_validators[id];
+    const Validator *other_validator = other.Get(validator.m_validator_address);
+    if (other_validator == nullptr || !(*other_validator == validator)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+ValidatorSet::Delta ValidatorSet::Diff(const ValidatorSet &target) const {
+  Delta delta;
+  const std::size_t slots = std::max(m_validators.size(), target.m_validators.size());
+  for (Id id = 0; id < slots; ++id) {
+    if (m_validators.SharesPage(target.m_validators, id) &&
+        m_used.SharesPage(target.m_used, id / BITS_PER_WORD)) {
+      continue;
+    }
+    const Validator *validator = IsUsed(id) ? &m_validators[id] : nullptr;
+    const Validator *target_validator = target.IsUsed(id) ? &target.m_validators[id] : nullptr;
+
+    if (validator != nullptr &&
+        (target_validator == nullptr || target_validator->m_validator_address != validator->m_validator_address) &&
+        target.Find(validator->m_validator_address) == NO_ID) {
+      delta.erasures.push_back(validator->m_validator_address);
+    }
+
+    if (target_validator != nullptr) {
+      // The validator may have a different id in this set if it has been
+      // removed and added again.
+      const Validator *base =
+          validator != nullptr && validator->m_validator_address == target_validator->m_validator_address
+              ? validator
+              : Get(target_validator->m_validator_address);
+      if (base == nullptr || !(*base == *target_validator)) {
+        delta.upserts.emplace_back(target_validator->m_validator_address, *target_validator);
+      }
+    }
+  }
+  // Ordered by address like the delta of a map.
+  std::sort(delta.upserts.begin(), delta.upserts.end(),
+            [](const std::pair<uint160, Validator> &left, const std::pair<uint160, Validator> &right) {
+              return left.first < right.first;
+            });
+  std::sort(delta.erasures.begin(), delta.erasures.end());
+  return delta;
+}
+
+void ValidatorSet::Apply(const Delta &delta) {
+  for (const uint160 &address : delta.erasures) {
+    Erase(address);
+  }
+  for (const std::pair<uint160, Validator> &entry : delta.upserts) {
+    Upsert(entry.second);
+  }
+}
+
+std::string ValidatorSet::ToString() const {
+  std::vector<std::pair<uint160, Validator>> entries;
+  for (const Validator *validator : Sorted()) {
+    entries.emplace_back(validator->m_validator_address, *validator);
+  }
+  return util::to_string(entries);
+}
+
+bool ValidatorSet::GetBit(const Bits &bits, const Id id) {
+  return (bits[id / BITS_PER_WORD] >> (id % BITS_PER_WORD)) & 1;
+}
+
+void ValidatorSet::SetBit(Bits &bits, const Id id, const bool value) {
+  if (GetBit(bits, id) != value) {
+    bits.at_mutable(id / BITS_PER_WORD) ^= uint64_t{1} << (id % BITS_PER_WORD);
+  }
+}
+
+ValidatorSet::Id ValidatorSet::NextFreeId() const {
+  for (std::size_t i = 0; i < m_used.size(); ++i) {
+    const uint64_t word = m_used[i];
+    if (word == std::numeric_limits<uint64_t>::max()) {
+      continue;
+    }
+    std::size_t bit = 0;
+    while ((word >> bit) & 1) {
+      ++bit;
+    }
+    // The bits past the last slot are clear, hence this is at most the number of slots.
+    return static_cast<Id>(i * BITS_PER_WORD + bit);
+  }
+  return static_cast<Id>(m_validators.size());
+}
+
+ValidatorSet::Index &ValidatorSet::MutableIndex() {
+  if (!m_index) {
+    m_index = std::make_shared<Index>();
+  } else if (m_index.use_count() != 1) {
+    m_index = std::make_shared<Index>(*m_index);
+  }
+  return *m_index;
+}
+
+void ValidatorSet::UpdateDynastyBits(const Id id, const Validator &validator) {
+  SetBit(m_in_dynasty, id, IsInDynasty(validator, m_dynasty));
+  SetBit(m_in_previous_dynasty, id, IsInDynasty(validator, m_dynasty - 1));
+}
+
+ValidatorSet::Bits ValidatorSet::BuildDynastyBits(const uint32_t dynasty) const {
+  Bits bits;
+  for (std::size_t i = 0; i < m_used.size(); ++i) {
+    uint64_t word = 0;
+    const uint64_t used = m_used[i];
+    for (std::size_t bit = 0; bit < BITS_PER_WORD; ++bit) {
+      if (((used >> bit) & 1) && IsInDynasty(m_validators[i * BITS_PER_WORD + bit], dynasty)) {
+        word |= uint64_t{1} << bit;
+      }
+    }
+    bits.push_back(word);
+  }
+  return bits;
+}
+
+std::vector<const Validator *> ValidatorSet::Sorted() const {
+  std::vector<const Validator *> validators;
+  validators.reserve(m_size);
+  for (Id id = 0; id < m_validators.size(); ++id) {
+    if (IsUsed(id)) {
+      validators.push_back(&m_validators[id]);
+    }
+  }
+  std::sort(validators.begin(), validators.end(),
+            [](const Validator *left, const Validator *right) {
+              return left->m_validator_address < right->m_validator_address;
+            });
+  return validators;
+}
+
+}  // namespace esperanza
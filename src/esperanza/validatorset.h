@@ -0,0 +1,219 @@
+// Copyright (c) 2019 The Unit-e developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef UNITE_ESPERANZA_VALIDATORSET_H
+#define UNITE_ESPERANZA_VALIDATORSET_H
+
+#include <esperanza/validator.h>
+#include <serialize.h>
+#include <uint256.h>
+#include <util/cow_vector.h>
+
+#include <cassert>
+#include <cstdint>
+#include <ios>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace esperanza {
+
+//! \brief The validators of a finalization state, keyed by their address.
+//!
+//! Validators are stored densely in a copy-on-write vector and are identified
+//! by an integer id which stays the same for as long as the validator is in
+//! the set. The ids of removed validators are reused. An open addressing hash
+//! table maps addresses to ids.
+//!
+//! Finalization states are copied from block to block. A copy shares the
+//! pages of validators with the original and a modified validator copies only
+//! the page it is on. The address index is shared as a whole and is copied
+//! only when a validator is inserted or removed.
+//!
+//! Which validators are in the dynasty given to SetDynasty() and in the one
+//! before it is kept in bitsets, so that the voting finalizers can be counted
+//! without looking at every validator. Validators must only be modified
+//! through Modify() to keep the bitsets up to date.
+//!
+//! The serialized representation is the same as the one of
+//! std::map<uint160, Validator>.
+class ValidatorSet {
+ public:
+  using Id = uint32_t;
+
+  static constexpr Id NO_ID = std::numeric_limits<Id>::max();
+
+  //! \brief The changes which turn a set into another, see Diff() and Apply().
+  //!
+  //! Serialized like the delta of a util::PersistentMap<uint160, Validator>.
+  struct Delta {
+    std::vector<std::pair<uint160, Validator>> upserts;
+    std::vector<uint160> erasures;
+
+    bool empty() const { return upserts.empty() && erasures.empty(); }
+
+    ADD_SERIALIZE_METHODS
+
+    template <typename Stream, typename Operation>
+    void SerializationOp(Stream &s, Operation ser_action) {
+      READWRITE(upserts);
+      READWRITE(erasures);
+    }
+  };
+
+  std::size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+
+  //! \brief Returns the id of the validator with the given address or NO_ID.
+  Id Find(const uint160 &address) const;
+
+  //! \brief Returns the id of the validator with the given address.
+  //!
+  //! \throws std::out_of_range if there is no such validator.
+  Id GetId(const uint160 &address) const;
+
+  //! \brief Returns the validator with the given address or nullptr.
+  //!
+  //! The pointer is invalidated by the next modification of the set.
+  const Validator *Get(const uint160 &address) const;
+
+  //! \brief Returns the validator with the given id, which must be in the set.
+  const Validator &Get(Id id) const {
+    assert(IsUsed(id));
+    return m_validators[id];
+  }
+
+  //! \brief Adds a validator unless there is one with the same address already.
+  //!
+  //! \return whether the validator has been added.
+  bool Insert(const Validator &validator);
+
+  //! \brief Adds a validator or replaces the one with the same address.
+  void Upsert(const Validator &validator);
+
+  //! \brief Removes the validator with the given address.
+  //!
+  //! \return whether there was such a validator.
+  bool Erase(const uint160 &address);
+
+  void clear();
+
+  //! \brief Modifies the validator with the given id, which must be in the set.
+  //!
+  //! modify is called with a reference to the validator and must not change its
+  //! address.
+  template <typename Modifier>
+  void Modify(const Id id, Modifier modify) {
+    assert(IsUsed(id));
+    Validator &validator = m_validators.at_mutable(id);
+    const uint160 address = validator.m_validator_address;
+    modify(validator);
+    assert(validator.m_validator_address == address);
+    UpdateDynastyBits(id, validator);
+  }
+
+  //! \brief Whether the validator can vote in the given dynasty.
+  static bool IsInDynasty(const Validator &validator, uint32_t dynasty);
+
+  //! \brief Rebuilds the bitsets for the given dynasty and the one before it.
+  //!
+  //! Advancing by one dynasty rebuilds only the bitset of the new dynasty.
+  void SetDynasty(uint32_t dynasty);
+
+  //! \brief Whether the validator with the given id is in dynasty or the one before.
+  bool IsVoting(Id id, uint32_t dynasty) const;
+
+  //! \brief Returns the number of validators in dynasty or the one before.
+  std::size_t CountVoting(uint32_t dynasty) const;
+
+  //! \brief Returns whether there is a validator in dynasty or the one before.
+  bool AnyVoting(uint32_t dynasty) const;
+
+  //! \brief Compares the validators, regardless of their ids.
+  bool operator==(const ValidatorSet &other) const;
+  bool operator!=(const ValidatorSet &other) const { return !(*this == other); }
+
+  //! \brief Returns the changes which turn this set into target.
+  //!
+  //! Pages which the sets share are known to be equal and are skipped, so
+  //! diffing a state against the state it has been copied from only looks at
+  //! the pages modified since.
+  Delta Diff(const ValidatorSet &target) const;
+
+  //! \brief Applies changes obtained from Diff() on the set they were computed from.
+  void Apply(const Delta &delta);
+
+  template <typename Stream>
+  void Serialize(Stream &s) const {
+    WriteCompactSize(s, m_size);
+    for (const Validator *validator : Sorted()) {
+      ::Serialize(s, validator->m_validator_address);
+      ::Serialize(s, *validator);
+    }
+  }
+
+  template <typename Stream>
+  void Unserialize(Stream &s) {
+    clear();
+    const uint64_t size = ReadCompactSize(s);
+    for (uint64_t i = 0; i < size; ++i) {
+      std::pair<uint160, Validator> entry;
+      ::Unserialize(s, entry);
+      if (entry.first != entry.second.m_validator_address) {
+        throw std::ios_base::failure("ValidatorSet: key does not match the validator address");
+      }
+      Upsert(entry.second);
+    }
+  }
+
+  std::string ToString() const;
+
+ private:
+  class Index;
+
+  using Bits = util::CowVector<uint64_t>;
+
+  static constexpr std::size_t BITS_PER_WORD = 64;
+
+  bool IsUsed(const Id id) const {
+    return id < m_validators.size() && GetBit(m_used, id);
+  }
+
+  static bool GetBit(const Bits &bits, Id id);
+  static void SetBit(Bits &bits, Id id, bool value);
+
+  Id NextFreeId() const;
+  Index &MutableIndex();
+  void UpdateDynastyBits(Id id, const Validator &validator);
+  Bits BuildDynastyBits(uint32_t dynasty) const;
+
+  //! The validators in the order of their addresses.
+  std::vector<const Validator *> Sorted() const;
+
+  //! Indexed by id, the slots of removed validators are kept until they are
+  //! reused. A block modifies the validators which vote in it, small pages
+  //! keep the copies this causes small.
+  util::CowVector<Validator, 16> m_validators;
+
+  //! One bit per id, set for the ids which are in use.
+  Bits m_used;
+
+  //! One bit per id, set for the validators in m_dynasty.
+  Bits m_in_dynasty;
+
+  //! One bit per id, set for the validators in the dynasty before m_dynasty.
+  Bits m_in_previous_dynasty;
+
+  std::shared_ptr<Index> m_index;
+
+  uint32_t m_dynasty = 0;
+
+  std::size_t m_size = 0;
+};
+
+}  // namespace esperanza
+
+#endif  // UNITE_ESPERANZA_VALIDATORSET_H
@@ -0,0 +1,225 @@
+// Copyright (c) 2019 The Unit-e developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <esperanza/voter.h>
+
+#include <checkqueue.h>
+#include <esperanza/finalizationstate.h>
+#include <esperanza/vote.h>
+#include <esperanza/walletextension.h>
+#include <finalization/state_repository.h>
+#include <primitives/transaction.h>
+#include <proposer/multiwallet.h>
+#include <settings.h>
+#include <staking/active_chain.h>
+#include <sync.h>
+#include <util.h>
+#include <utiltime.h>
+#include <validationinterface.h>
+#include <wallet/wallet.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <boost/thread.hpp>
+
+namespace esperanza {
+
+namespace {
+
+//! The vote of a single wallet, from preparing it to committing it.
+struct WalletVote {
+  std::shared_ptr<CWallet> wallet;
+  Vote vote;
+  CTransactionRef prev_tx;
+  //! the signed vote transaction, null if signing failed
+  CTransactionRef vote_tx;
+};
+
+//! \brief Signs the vote of a single wallet, a job of the signing queue.
+class VoteSigning {
+ public:
+  VoteSigning() = default;
+  explicit VoteSigning(WalletVote &wallet_vote) : m_wallet_vote(&wallet_vote) {}
+
+  bool operator()() {
+    WalletExtension &wallet_ext = m_wallet_vote->wallet->GetWalletExtension();
+    if (!wallet_ext.SignVote(m_wallet_vote->prev_tx, m_wallet_vote->vote, m_wallet_vote->vote_tx)) {
+      m_wallet_vote->vote_tx = nullptr;
+    }
+    // A failure must not keep the other wallets from voting.
+    return true;
+  }
+
+  void swap(VoteSigning &other) {
+    std::swap(m_wallet_vote, other.m_wallet_vote);
+  }
+
+ private:
+  WalletVote *m_wallet_vote = nullptr;
+};
+
+class VoterImpl final : public Voter, public CValidationInterface {
+ private:
+  static constexpr const char *SIGN_THREAD_NAME = "unite-votesign";
+
+  const Dependency<Settings> m_settings;
+  const Dependency<proposer::MultiWallet> m_multi_wallet;
+  const Dependency<staking::ActiveChain> m_active_chain;
+  const Dependency<finalization::StateRepository> m_state_repository;
+
+  mutable CCriticalSection m_startstop_lock;
+  bool m_started = false;  // protected by m_startstop_lock
+  std::atomic_bool m_interrupted{false};
+
+  //! Whether voting is queued already, blocks connected in the meantime are
+  //! voted on together.
+  std::atomic_bool m_vote_pending{false};
+
+  //! Votes are signed by the thread voting together with these workers.
+  CCheckQueue<VoteSigning> m_sign_queue{1};
+  boost::thread_group m_sign_workers;
+
+  //! Picks the votes of all wallets from one copy of the tip's state.
+  std::vector<WalletVote> PrepareVotes() {
+    std::vector<WalletVote> votes;
+    LOCK(m_active_chain->GetLock());
+    const CBlockIndex *const tip = m_active_chain->GetTip();
+    if (!tip) {
+      return votes;
+    }
+    std::unique_ptr<const FinalizationState> fin_state;
+    {
+      LOCK(m_state_repository->GetLock());
+      const FinalizationState *const tip_state = m_state_repository->Find(*tip);
+      assert(tip_state);
+      fin_state.reset(new FinalizationState(*tip_state));
+    }
+    for (const std::shared_ptr<CWallet> &wallet : m_multi_wallet->GetWallets()) {
+      WalletExtension &wallet_ext = wallet->GetWalletExtension();
+      if (!wallet_ext.nIsValidatorEnabled) {
+        continue;
+      }
+      WalletVote wallet_vote;
+      LOCK(wallet->cs_wallet);
+      if (wallet_ext.PrepareVote(*fin_state, *tip, wallet_vote.vote, wallet_vote.prev_tx)) {
+        wallet_vote.wallet = wallet;
+        votes.emplace_back(std::move(wallet_vote));
+      }
+    }
+    return votes;
+  }
+
+  void SignVotes(std::vector<WalletVote> &votes) {
+    std::vector<VoteSigning> signings;
+    signings.reserve(votes.size());
+    for (WalletVote &wallet_vote : votes) {
+      signings.emplace_back(wallet_vote);
+    }
+    CCheckQueueControl<VoteSigning> control(&m_sign_queue);
+    control.Add(signings);
+    control.Wait();
+  }
+
+ public:
+  VoterImpl(const Dependency<Settings> settings,
+            const Dependency<proposer::MultiWallet> multi_wallet,
+            const Dependency<staking::ActiveChain> active_chain,
+            const Dependency<finalization::StateRepository> state_repository)
+      : m_settings(settings),
+        m_multi_wallet(multi_wallet),
+        m_active_chain(active_chain),
+        m_state_repository(state_repository) {}
+
+  void VoteIfNeeded() override {
+    AssertLockNotHeld(m_active_chain->GetLock());
+    if (m_interrupted) {
+      return;
+    }
+    const int64_t start_time = GetTimeMicros();
+
+    std::vector<WalletVote> votes = PrepareVotes();
+    if (votes.empty()) {
+      return;
+    }
+    SignVotes(votes);
+
+    LOCK(m_active_chain->GetLock());
+    for (const WalletVote &wallet_vote : votes) {
+      if (!wallet_vote.vote_tx) {
+        continue;
+      }
+      LOCK(wallet_vote.wallet->cs_wallet);
+      wallet_vote.wallet->GetWalletExtension().CommitVote(wallet_vote.vote, wallet_vote.vote_tx, start_time);
+    }
+  }
+
+  void BlockConnected(const std::shared_ptr<const CBlock> &block,
+                      const CBlockIndex *index,
+                      const std::vector<CTransactionRef> &txn_conflicted) override {
+    if (m_active_chain->GetInitialBlockDownloadStatus() != +SyncStatus::SYNCED) {
+      // there is no reason to vote as such votes will be outdated
+      // and won't be included in the chain
+      return;
+    }
+    // The wallets are notified of the block in this same callback. Voting is
+    // queued after it, so that every wallet has seen the block by then.
+    if (m_vote_pending.exchange(true)) {
+      return;
+    }
+    CallFunctionInValidationInterfaceQueue([this] {
+      m_vote_pending = false;
+      VoteIfNeeded();
+    });
+  }
+
+  void Start() override {
+    LOCK(m_startstop_lock);
+    if (m_started || !m_settings->node_is_validator) {
+      return;
+    }
+    // The voting thread signs too, so one worker less than cores.
+    const int num_sign_workers = std::max(GetNumCores(), 1) - 1;
+    for (int i = 0; i < num_sign_workers; ++i) {
+      m_sign_workers.create_thread([this] {
+        RenameThread(SIGN_THREAD_NAME);
+        m_sign_queue.Thread();
+      });
+    }
+    RegisterValidationInterface(this);
+    m_started = true;
+  }
+
+  void Stop() override {
+    LOCK(m_startstop_lock);
+    if (!m_started) {
+      return;
+    }
+    // Voting which is still queued is skipped.
+    m_interrupted = true;
+    UnregisterValidationInterface(this);
+    // Idle workers wait on the queue, which is an interruption point.
+    m_sign_workers.interrupt_all();
+    m_sign_workers.join_all();
+    m_started = false;
+  }
+
+  ~VoterImpl() override {
+    Stop();
+  }
+};
+
+}  // namespace
+
+std::unique_ptr<Voter> Voter::New(const Dependency<Settings> settings,
+                                  const Dependency<proposer::MultiWallet> multi_wallet,
+                                  const Dependency<staking::ActiveChain> active_chain,
+                                  const Dependency<finalization::StateRepository> state_repository) {
+  return MakeUnique<VoterImpl>(settings, multi_wallet, active_chain, state_repository);
+}
+
+}  // namespace esperanza
@@ -0,0 +1,57 @@
+// Copyright (c) 2019 The Unit-e developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef UNITE_ESPERANZA_VOTER_H
+#define UNITE_ESPERANZA_VOTER_H
+
+#include <dependency.h>
+
+#include <memory>
+
+struct Settings;
+
+namespace finalization {
+class StateRepository;
+}
+
+namespace proposer {
+class MultiWallet;
+}
+
+namespace staking {
+class ActiveChain;
+}
+
+namespace esperanza {
+
+//! \brief Casts the votes of all finalizers hosted by this node.
+//!
+//! When a block is connected, the votes of all wallets are prepared from the
+//! same finalization state, signed concurrently and committed in a single
+//! cs_main section. A node hosting many finalizers then doesn't cast their
+//! votes one after another.
+class Voter {
+
+ public:
+  //! \brief Casts the votes which are due on the current tip.
+  //!
+  //! Must not be called with cs_main held.
+  virtual void VoteIfNeeded() = 0;
+
+  //! \brief Starts the signing workers and votes on connected blocks.
+  virtual void Start() = 0;
+
+  virtual void Stop() = 0;
+
+  virtual ~Voter() = default;
+
+  static std::unique_ptr<Voter> New(Dependency<Settings>,
+                                    Dependency<proposer::MultiWallet>,
+                                    Dependency<staking::ActiveChain>,
+                                    Dependency<finalization::StateRepository>);
+};
+
+}  // namespace esperanza
+
+#endif  // UNITE_ESPERANZA_VOTER_H
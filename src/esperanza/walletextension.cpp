@@ -27,6 +27,7 @@
 #include <wallet/walletdb.h>
 
 #include <cstdint>
+#include <limits>
 
 namespace esperanza {
 
@@ -47,44 +48,138 @@ WalletExtension::WalletExtension(const WalletExtensionDeps &dependencies,
   }
 }
 
+void WalletExtension::TransactionAddedToWallet(const uint256 &tx_hash) {
+  AssertLockHeld(m_enclosing_wallet.cs_wallet);
+
+  if (m_stakeable_outputs.initialized) {
+    m_stakeable_outputs.dirty_txs.emplace(tx_hash);
+  }
+}
+
+void WalletExtension::OutputSpendChanged(const COutPoint &out_point) {
+  AssertLockHeld(m_enclosing_wallet.cs_wallet);
+
+  if (m_stakeable_outputs.initialized) {
+    m_stakeable_outputs.dirty_txs.emplace(out_point.hash);
+  }
+}
+
+void WalletExtension::KeyStoreChanged() {
+  LOCK(m_enclosing_wallet.cs_wallet);
+  m_stakeable_outputs.initialized = false;
+}
+
+void WalletExtension::IndexStakeableOutputs(const uint256 &tx_hash) const {
+  StakeableOutputs &index = m_stakeable_outputs;
+
+  const auto height_it = index.tx_heights.find(tx_hash);
+  if (height_it != index.tx_heights.end()) {
+    const auto bucket = index.by_height.find(height_it->second);
+    if (bucket != index.by_height.end()) {
+      std::set<COutPoint> &outputs = bucket->second;
+      outputs.erase(outputs.lower_bound(COutPoint(tx_hash, 0)),
+                    outputs.upper_bound(COutPoint(tx_hash, std::numeric_limits<std::uint32_t>::max())));
+      if (outputs.empty()) {
+        index.by_height.erase(bucket);
+      }
+    }
+    index.tx_heights.erase(height_it);
+  }
+
+  const auto tx_it = m_enclosing_wallet.mapWallet.find(tx_hash);
+  if (tx_it == m_enclosing_wallet.mapWallet.end()) {
+    return;
+  }
+  const CWalletTx &tx = tx_it->second;
+  const CBlockIndex *containing_block = nullptr;
+  if (tx.GetDepthInMainChain(containing_block) <= 0 || !containing_block) {
+    // will be indexed again once the transaction is included in a block
+    return;
+  }
+
+  const blockchain::Height height = static_cast<blockchain::Height>(containing_block->nHeight);
+  const std::vector<::CTxOut> &coins = tx.tx->vout;
+  std::set<COutPoint> *outputs = nullptr;
+  for (std::size_t out_index = 0; out_index < coins.size(); ++out_index) {
+    const CTxOut &coin = coins[out_index];
+    if (coin.nValue <= 0 || !IsStakeableByMe(m_enclosing_wallet, coin.scriptPubKey)) {
+      continue;
+    }
+    if (m_enclosing_wallet.IsSpent(tx_hash, static_cast<unsigned int>(out_index))) {
+      // will be indexed again if the spending transaction is disconnected or abandoned
+      continue;
+    }
+    if (!outputs) {
+      outputs = &index.by_height[height];
+      index.tx_heights.emplace(tx_hash, height);
+    }
+    outputs->emplace(tx_hash, static_cast<std::uint32_t>(out_index));
+  }
+}
+
+void WalletExtension::UpdateStakeableOutputs() const {
+  AssertLockHeld(cs_main);
+  AssertLockHeld(m_enclosing_wallet.cs_wallet);  // access to mapWallet
+
+  StakeableOutputs &index = m_stakeable_outputs;
+  if (!index.initialized) {
+    index.by_height.clear();
+    index.tx_heights.clear();
+    index.dirty_txs.clear();
+    for (const auto &it : m_enclosing_wallet.mapWallet) {
+      IndexStakeableOutputs(it.first);
+    }
+    index.initialized = true;
+    return;
+  }
+  for (const uint256 &tx_hash : index.dirty_txs) {
+    IndexStakeableOutputs(tx_hash);
+  }
+  index.dirty_txs.clear();
+}
+
 template <typename Callable>
 void WalletExtension::ForEachStakeableCoin(Callable f) const {
   AssertLockHeld(cs_main);
   AssertLockHeld(m_enclosing_wallet.cs_wallet);  // access to mapWallet
 
-  CCoinsViewCache view(pcoinsTip.get());  // requires cs_main
-  for (const auto &it : m_enclosing_wallet.mapWallet) {
-    const CWalletTx *const tx = &it.second;
-    const uint256 &txId = tx->GetHash();
-    const std::vector<::CTxOut> &coins = tx->tx->vout;
-    const CBlockIndex *containing_block = nullptr;
-    const int depth = tx->GetDepthInMainChain(containing_block);  // requires cs_main
-    if (depth <= 0 || !containing_block) {
-      // transaction is not included in a block
-      continue;
-    }
+  UpdateStakeableOutputs();
 
-    blockchain::Height height = static_cast<blockchain::Height>(containing_block->nHeight);
-    if (!m_dependencies.GetStakeValidator().IsStakeMature(height)) {
-      continue;
+  CCoinsViewCache view(pcoinsTip.get());  // requires cs_main
+  for (const auto &bucket : m_stakeable_outputs.by_height) {
+    // buckets are ordered by height, all following ones are immature too
+    if (!m_dependencies.GetStakeValidator().IsStakeMature(bucket.first)) {
+      break;
     }
-
-    const bool skip_reward = tx->IsCoinBase() && tx->GetBlocksToRewardMaturity() > 0;
-    for (std::size_t out_index = skip_reward ? 1 : 0; out_index < coins.size(); ++out_index) {
-      if (m_enclosing_wallet.IsSpent(txId, static_cast<unsigned int>(out_index))) {
+    for (const COutPoint &out_point : bucket.second) {
+      const auto tx_it = m_enclosing_wallet.mapWallet.find(out_point.hash);
+      if (tx_it == m_enclosing_wallet.mapWallet.end()) {
+        continue;
+      }
+      const CWalletTx *const tx = &tx_it->second;
+      const CBlockIndex *containing_block = nullptr;
+      const int depth = tx->GetDepthInMainChain(containing_block);  // requires cs_main
+      if (depth <= 0 || !containing_block) {
+        // transaction is not included in a block (anymore)
+        continue;
+      }
+      if (static_cast<blockchain::Height>(containing_block->nHeight) != bucket.first &&
+          !m_dependencies.GetStakeValidator().IsStakeMature(containing_block->nHeight)) {
+        continue;
+      }
+      if (out_point.n == 0 && tx->IsCoinBase() && tx->GetBlocksToRewardMaturity() > 0) {
         continue;
       }
-      if (!view.HaveCoin(COutPoint(txId, static_cast<uint32_t>(out_index)))) {
+      if (m_enclosing_wallet.IsSpent(out_point.hash, out_point.n)) {
         continue;
       }
-      if (m_enclosing_wallet.IsLockedCoin(txId, out_index)) {
+      if (!view.HaveCoin(out_point)) {
         continue;
       }
-      const CTxOut &coin = coins[out_index];
-      if (coin.nValue <= 0 || !IsStakeableByMe(m_enclosing_wallet, coin.scriptPubKey)) {
+      if (m_enclosing_wallet.IsLockedCoin(out_point.hash, out_point.n)) {
         continue;
       }
-      f(tx, std::uint32_t(out_index), containing_block);
+      f(tx, out_point.n, containing_block);
     }
   }
 }
@@ -562,45 +657,42 @@ bool WalletExtension::SendWithdraw(const CTxDestination &address, CTransactionRe
   return true;
 }
 
-void WalletExtension::VoteIfNeeded() {
-  LOCK2(cs_main, m_enclosing_wallet.cs_wallet);
-
-  LOCK(m_dependencies.GetFinalizationStateRepository().GetLock());
-  const CBlockIndex *tip_block_index = m_dependencies.GetActiveChain().GetTip();
-  const FinalizationState *fin_state = m_dependencies.GetFinalizationStateRepository().Find(*tip_block_index);
-  assert(fin_state);
+bool WalletExtension::PrepareVote(const FinalizationState &fin_state,
+                                  const CBlockIndex &tip,
+                                  Vote &vote_out, CTransactionRef &prev_tx_out) {
+  AssertLockHeld(m_enclosing_wallet.cs_wallet);
 
-  if (GetFinalizerPhase(*fin_state) != +ValidatorState::Phase::IS_VALIDATING) {
-    return;
+  if (GetFinalizerPhase(fin_state) != +ValidatorState::Phase::IS_VALIDATING) {
+    return false;
   }
 
   assert(validatorState);
 
   ValidatorStateWatchWriter validator_writer(*this);
-  const esperanza::Validator *validator = fin_state->GetValidator(validatorState->m_validator_address);
+  const esperanza::Validator *validator = fin_state.GetValidator(validatorState->m_validator_address);
   assert(validator);
 
-  const uint32_t block_number = tip_block_index->nHeight % fin_state->GetEpochLength();
+  const uint32_t block_number = tip.nHeight % fin_state.GetEpochLength();
   if (block_number < m_dependencies.GetSettings().finalizer_vote_from_epoch_block_number) {
-    return;
+    return false;
   }
 
-  const uint32_t target_epoch = fin_state->GetRecommendedTargetEpoch();
-  if (fin_state->GetCurrentEpoch() != target_epoch + 1) {
+  const uint32_t target_epoch = fin_state.GetRecommendedTargetEpoch();
+  if (fin_state.GetCurrentEpoch() != target_epoch + 1) {
     // not the right time to vote
-    return;
+    return false;
   }
 
   // Avoid double votes
   if (validatorState->m_vote_map.find(target_epoch) != validatorState->m_vote_map.end()) {
-    return;
+    return false;
   }
 
   LogPrint(BCLog::FINALIZATION, /* Continued */
            "%s: Validator voting for epoch %d and dynasty %d.\n", __func__,
-           target_epoch, fin_state->GetCurrentDynasty());
+           target_epoch, fin_state.GetCurrentDynasty());
 
-  Vote vote = fin_state->GetRecommendedVote(validatorState->m_validator_address);
+  const Vote vote = fin_state.GetRecommendedVote(validatorState->m_validator_address);
   assert(vote.m_target_epoch == target_epoch);
 
   // Check for surrounding votes
@@ -612,38 +704,29 @@ void WalletExtension::VoteIfNeeded() {
              " prevSource %s, prevTarget: %s.\n",
              __func__, vote.m_source_epoch, vote.m_target_epoch,
              validatorState->m_last_source_epoch, validatorState->m_last_target_epoch);
-    return;
+    return false;
   }
 
   const CWalletTx *prev_tx = m_enclosing_wallet.GetWalletTx(validator->m_last_transaction_hash);
   assert(prev_tx);
 
-  CTransactionRef createdTx;
-  if (SendVote(prev_tx->tx, vote, createdTx)) {
-
-    LogPrint(BCLog::FINALIZATION, "%s: Casted vote with id %s.\n", __func__,
-             createdTx->GetHash().GetHex());
-  }
+  vote_out = vote;
+  prev_tx_out = prev_tx->tx;
+  return true;
 }
 
-bool WalletExtension::SendVote(const CTransactionRef &prevTxRef,
+bool WalletExtension::SignVote(const CTransactionRef &prevTxRef,
                                const Vote &vote, CTransactionRef &wtxNewOut) {
 
-  AssertLockHeld(m_enclosing_wallet.cs_wallet);
-
-  assert(validatorState);
-
-  ValidatorState &validator = validatorState.get();
-
-  CReserveKey reservekey(&m_enclosing_wallet);
-  CValidationState state;
-
   CMutableTransaction txNew;
   txNew.SetType(TxType::VOTE);
 
   const CScript &scriptPubKey = prevTxRef->vout[0].scriptPubKey;
   const CAmount amount = prevTxRef->vout[0].nValue;
 
+  // Signing doesn't touch the chain, cs_main is only needed to commit
+  LOCK(m_enclosing_wallet.cs_wallet);
+
   std::vector<unsigned char> voteSig;
   if (!CreateVoteSignature(&m_enclosing_wallet, vote, voteSig)) {
     return error("%s: Cannot sign vote.", __func__);
@@ -669,12 +752,30 @@ bool WalletExtension::SendVote(const CTransactionRef &prevTxRef,
   UpdateInput(txNew.vin.at(nIn), sigdata);
 
   wtxNewOut = MakeTransactionRef(std::move(txNew));
+  return true;
+}
+
+bool WalletExtension::CommitVote(const Vote &vote, const CTransactionRef &voteTx,
+                                 const int64_t startTime) {
+  AssertLockHeld(cs_main);
+  AssertLockHeld(m_enclosing_wallet.cs_wallet);
+
+  assert(validatorState);
+
+  ValidatorState &validator = validatorState.get();
+
+  // The vote might have been cast already while it was being signed
+  if (validator.m_vote_map.find(vote.m_target_epoch) != validator.m_vote_map.end()) {
+    return false;
+  }
 
+  CReserveKey reservekey(&m_enclosing_wallet);
+  CValidationState state;
   CWalletTx *wtx_new = nullptr;
 
   CConnman *connman = g_connman.get();
 
-  m_enclosing_wallet.CommitTransaction(wtxNewOut, {}, {}, {}, reservekey, g_connman.get(), state, /*relay*/ false, &wtx_new);
+  m_enclosing_wallet.CommitTransaction(voteTx, {}, {}, {}, reservekey, g_connman.get(), state, /*relay*/ false, &wtx_new);
   if (state.IsInvalid()) {
     LogPrint(BCLog::FINALIZATION, "%s: Cannot commit vote transaction: %s.\n",
              __func__, state.GetRejectReason());
@@ -695,9 +796,27 @@ bool WalletExtension::SendVote(const CTransactionRef &prevTxRef,
     wtx_new->RelayWalletTransaction(connman);
   }
 
+  m_last_vote_duration = GetTimeMicros() - startTime;
+  LogPrint(BCLog::FINALIZATION, "%s: Casted vote with id %s in %dus.\n", __func__,
+           voteTx->GetHash().GetHex(), m_last_vote_duration);
+
   return true;
 }
 
+bool WalletExtension::SendVote(const CTransactionRef &prevTxRef,
+                               const Vote &vote, CTransactionRef &wtxNewOut) {
+
+  AssertLockNotHeld(cs_main);
+
+  const int64_t start_time = GetTimeMicros();
+  if (!SignVote(prevTxRef, vote, wtxNewOut)) {
+    return false;
+  }
+
+  LOCK2(cs_main, m_enclosing_wallet.cs_wallet);
+  return CommitVote(vote, wtxNewOut, start_time);
+}
+
 bool WalletExtension::SendSlash(const finalization::VoteRecord &vote1,
                                 const finalization::VoteRecord &vote2) {
 
@@ -767,23 +886,6 @@ bool WalletExtension::SendSlash(const finalization::VoteRecord &vote1,
   return true;
 }
 
-void WalletExtension::BlockConnected(
-    const std::shared_ptr<const CBlock> &pblock, const CBlockIndex &index) {
-
-  if (!nIsValidatorEnabled) {
-    // finalizer is explicitly disabled
-    return;
-  }
-
-  if (IsInitialBlockDownload()) {
-    // there is no reason to vote as such votes will be outdated
-    // and won't be included in the chain
-    return;
-  }
-
-  VoteIfNeeded();
-}
-
 bool WalletExtension::AddToWalletIfInvolvingMe(const CTransactionRef &ptx,
                                                const CBlockIndex *pIndex) {
   if (!nIsValidatorEnabled) {
@@ -903,6 +1005,11 @@ const proposer::State &WalletExtension::GetProposerState() const {
   return m_proposer_state;
 }
 
+int64_t WalletExtension::GetLastVoteDuration() const {
+  AssertLockHeld(m_enclosing_wallet.cs_wallet);
+  return m_last_vote_duration;
+}
+
 const ValidatorState::Phase WalletExtension::GetFinalizerPhase(const FinalizationState &state) const {
   if (!nIsValidatorEnabled) {
     return ValidatorState::Phase::NOT_VALIDATING;
@@ -19,9 +19,12 @@
 #include <proposer/proposer_state.h>
 #include <settings.h>
 #include <staking/stakingwallet.h>
+#include <uint256.h>
 
 #include <cstddef>
 #include <cstdint>
+#include <map>
+#include <set>
 #include <vector>
 
 class CWallet;
@@ -59,11 +62,41 @@ class WalletExtension : public staking::StakingWallet {
 
   std::vector<std::pair<finalization::VoteRecord, finalization::VoteRecord>> pendingSlashings;
 
-  //! Cast vote if needed
-  void VoteIfNeeded();
+  //! microseconds it took to get the last vote of this wallet into the
+  //! mempool, since the node started voting on the block it was cast for.
+  int64_t m_last_vote_duration = 0;
 
   void ManagePendingSlashings();
 
+  //! \brief Outputs which might be stakeable, kept up to date from wallet notifications.
+  //!
+  //! Unspent outputs of wallet transactions that are included in a block,
+  //! have a positive value and are stakeable by this wallet are bucketed by
+  //! the height of their block, so that the mature ones are a prefix of the
+  //! map. A transaction is re-indexed when it changes and when a transaction
+  //! spending one of its outputs is added or changes state, so spent outputs
+  //! leave the index and come back if the spend is disconnected or abandoned.
+  //! Changes to the keys or watched scripts rebuild the whole index.
+  struct StakeableOutputs {
+    std::map<blockchain::Height, std::set<COutPoint>> by_height;
+
+    //! the height under which a transaction's outputs are in by_height
+    std::map<uint256, blockchain::Height> tx_heights;
+
+    //! transactions that were added or updated since the last lookup
+    std::set<uint256> dirty_txs;
+
+    //! whether by_height covers the whole wallet (it's built on first use)
+    bool initialized = false;
+  };
+  mutable StakeableOutputs m_stakeable_outputs;
+
+  //! Brings m_stakeable_outputs up to date with the transactions that changed.
+  void UpdateStakeableOutputs() const;
+
+  //! Re-indexes the stakeable outputs of a single transaction.
+  void IndexStakeableOutputs(const uint256 &tx_hash) const;
+
   template <typename Callable>
   void ForEachStakeableCoin(Callable) const;
 
@@ -143,9 +176,33 @@ class WalletExtension : public staking::StakingWallet {
   //! transaction, depending which one is the most recent
   //! \param[in] vote the vote data
   //! \param[out] wtxNew the vote transaction committed
+  //!
+  //! The transaction is signed holding only the wallet lock, cs_main is taken
+  //! to commit it and must not be held by the caller.
   bool SendVote(const CTransactionRef &depositRef, const Vote &vote,
                 CTransactionRef &wtxNewOut);
 
+  //! \brief Picks the vote to cast on tip, if any.
+  //!
+  //! fin_state is the finalization state of tip. Requires the lock of the
+  //! enclosing wallet to be held.
+  //! \returns false if the finalizer must not vote now.
+  bool PrepareVote(const FinalizationState &fin_state, const CBlockIndex &tip,
+                   Vote &vote_out, CTransactionRef &prev_tx_out);
+
+  //! \brief Creates and signs the vote transaction, see SendVote().
+  //!
+  //! Takes the lock of the enclosing wallet, wallets can sign concurrently.
+  bool SignVote(const CTransactionRef &prevTxRef, const Vote &vote,
+                CTransactionRef &wtxNewOut);
+
+  //! \brief Commits and relays a vote transaction created by SignVote().
+  //!
+  //! Fails if the vote has been cast in the meantime. startTime is when voting
+  //! started, in microseconds, see GetLastVoteDuration(). Requires cs_main
+  //! and the lock of the enclosing wallet to be held.
+  bool CommitVote(const Vote &vote, const CTransactionRef &voteTx, int64_t startTime);
+
   //! \brief Creates and sends a logout transaction.
   //!
   //! \param wtxNewOut[out] the logout transaction created.
@@ -182,11 +239,30 @@ class WalletExtension : public staking::StakingWallet {
   void ReadValidatorStateFromFile();
   void WriteValidatorStateToFile();
 
-  void BlockConnected(const std::shared_ptr<const CBlock> &pblock,
-                      const CBlockIndex &index);
+  //! \brief Notifies that a transaction was added to or updated in the wallet.
+  //!
+  //! Requires the lock of the enclosing wallet to be held.
+  void TransactionAddedToWallet(const uint256 &tx_hash);
+
+  //! \brief Notifies that a wallet transaction spending the output was added,
+  //! or that such a transaction changed its state in the chain.
+  //!
+  //! Requires the lock of the enclosing wallet to be held.
+  void OutputSpendChanged(const COutPoint &out_point);
+
+  //! \brief Notifies that keys or scripts were added to or removed from the
+  //! wallet, which can make outputs of existing transactions (un)stakeable.
+  void KeyStoreChanged();
 
   const proposer::State &GetProposerState() const;
 
+  //! \brief Returns microseconds it took this wallet to cast its last vote.
+  //!
+  //! Measured from the node starting to vote on the block the vote was cast
+  //! for, once all wallets have been notified of it, to the vote entering the
+  //! mempool. Requires the lock of the enclosing wallet to be held.
+  int64_t GetLastVoteDuration() const;
+
   boost::optional<ValidatorState> validatorState = boost::none;
   bool nIsValidatorEnabled = false;
 
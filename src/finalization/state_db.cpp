@@ -12,10 +12,38 @@
 #include <staking/block_index_map.h>
 #include <validation.h>
 
+#include <algorithm>
+#include <set>
+#include <vector>
+
 namespace finalization {
 
 namespace {
 
+//! Key prefix of the states which are stored in full.
+const char DB_STATE = 's';
+
+//! Key prefix of the states which are stored as a delta against another state.
+const char DB_STATE_DELTA = 'd';
+
+//! \brief A state stored as the changes against the state of the block base_hash.
+struct StoredDelta {
+  uint256 base_hash;
+  FinalizationState::Delta delta;
+
+  explicit StoredDelta(const finalization::Params &params) : delta(params) {}
+  StoredDelta(const uint256 &base_hash, const FinalizationState &base, const FinalizationState &state)
+      : base_hash(base_hash), delta(base, state) {}
+
+  ADD_SERIALIZE_METHODS
+
+  template <typename Stream, typename Operation>
+  void SerializationOp(Stream &s, Operation ser_action) {
+    READWRITE(base_hash);
+    READWRITE(delta);
+  }
+};
+
 class StateDBImpl : public StateDB {
  public:
   StateDBImpl(const StateDBParams &p,
@@ -24,9 +52,12 @@ class StateDBImpl : public StateDB {
               Dependency<staking::BlockIndexMap> block_index_map,
               Dependency<staking::ActiveChain> active_chain)
       : m_db(settings->data_dir / "finalization", p.cache_size, p.inmemory, p.wipe, p.obfuscate),
+        m_snapshot_interval(std::max<uint32_t>(p.snapshot_interval, 1)),
         m_finalization_params(finalization_params),
         m_block_index_map(block_index_map),
-        m_active_chain(active_chain) {}
+        m_active_chain(active_chain) {
+    MigrateLegacyStates();
+  }
 
   bool Save(const std::map<const CBlockIndex *, FinalizationState> &states) override;
 
@@ -52,19 +83,235 @@ class StateDBImpl : public StateDB {
       std::map<const CBlockIndex *, FinalizationState> *states) const override;
 
  private:
+  //! \brief A state as it is on disk.
+  struct Entry {
+    FinalizationState state;
+    //! The block whose state this one is a delta against, null if stored in full.
+    uint256 base_hash;
+  };
+
+  //! \brief Returns the state of the given block, reading it from disk if needed.
+  //!
+  //! Deltas are replayed on top of their bases, every state read on the way is
+  //! kept in m_entries. Returns nullptr if the state is not available.
+  const FinalizationState *ReadState(const uint256 &block_hash) const;
+
+  //! \brief Whether the state of the block must be stored in full.
+  bool IsSnapshot(const CBlockIndex &block_index) const;
+
+  bool HasDependents(const uint256 &block_hash) const;
+
+  //! \brief Adds an entry to m_entries and counts it as a dependent of its base.
+  //!
+  //! Does nothing if the block already has an entry. Returns the entry of the block.
+  const Entry &AddEntry(const uint256 &block_hash, Entry &&entry) const;
+
+  //! \brief Removes an entry from m_entries and from the dependents of its base.
+  std::map<uint256, Entry>::iterator RemoveEntry(std::map<uint256, Entry>::iterator it) const;
+
+  //! \brief Rewrites the states stored by older versions under their bare block hash.
+  //!
+  //! Such states are stored in full under the DB_STATE prefix and the old keys are
+  //! erased, so that they are neither lost nor kept on disk forever.
+  void MigrateLegacyStates();
+
   CDBWrapper m_db;
+  const uint32_t m_snapshot_interval;
   Dependency<finalization::Params> m_finalization_params;
   Dependency<staking::BlockIndexMap> m_block_index_map;
   Dependency<staking::ActiveChain> m_active_chain;
+
+  mutable CCriticalSection m_cs;
+  mutable std::map<uint256, Entry> m_entries;
+  //! Number of entries in m_entries whose delta is based on the given block.
+  mutable std::map<uint256, size_t> m_dependents;
+  //! Erased states which are still needed on disk as bases of other deltas.
+  std::set<uint256> m_erased;
 };
 
-bool StateDBImpl::Save(const std::map<const CBlockIndex *, FinalizationState> &states) {
+const FinalizationState *StateDBImpl::ReadState(const uint256 &block_hash) const {
+  AssertLockHeld(m_cs);
+
+  if (m_erased.count(block_hash) != 0) {
+    return nullptr;
+  }
+
+  std::vector<std::pair<uint256, StoredDelta>> deltas;
+  const FinalizationState *base = nullptr;
+  uint256 hash = block_hash;
+  while (base == nullptr) {
+    const auto it = m_entries.find(hash);
+    if (it != m_entries.end()) {
+      base = &it->second.state;
+      break;
+    }
+    FinalizationState state(*m_finalization_params);
+    if (m_db.Read(std::make_pair(DB_STATE, hash), state)) {
+      base = &AddEntry(hash, Entry{std::move(state), uint256()}).state;
+      break;
+    }
+    StoredDelta stored(*m_finalization_params);
+    if (!m_db.Read(std::make_pair(DB_STATE_DELTA, hash), stored)) {
+      if (!deltas.empty()) {
+        LogPrintf("Cannot load finalization state=%s, its base state=%s is missing.\n",
+                  util::to_string(deltas.back().first), util::to_string(hash));
+      }
+      return nullptr;
+    }
+    deltas.emplace_back(hash, std::move(stored));
+    hash = deltas.back().second.base_hash;
+  }
+
+  for (auto it = deltas.rbegin(); it != deltas.rend(); ++it) {
+    base = &AddEntry(it->first, Entry{FinalizationState(*base, it->second.delta), it->second.base_hash}).state;
+  }
+  return base;
+}
+
+bool StateDBImpl::IsSnapshot(const CBlockIndex &block_index) const {
+  const auto height = static_cast<blockchain::Height>(block_index.nHeight);
+  return m_finalization_params->IsCheckpoint(height) &&
+         m_finalization_params->GetEpoch(height) % m_snapshot_interval == 0;
+}
+
+bool StateDBImpl::HasDependents(const uint256 &block_hash) const {
+  AssertLockHeld(m_cs);
+  return m_dependents.count(block_hash) != 0;
+}
+
+const StateDBImpl::Entry &StateDBImpl::AddEntry(const uint256 &block_hash, Entry &&entry) const {
+  AssertLockHeld(m_cs);
+  const auto res = m_entries.emplace(block_hash, std::move(entry));
+  if (res.second && !res.first->second.base_hash.IsNull()) {
+    ++m_dependents[res.first->second.base_hash];
+  }
+  return res.first->second;
+}
+
+std::map<uint256, StateDBImpl::Entry>::iterator StateDBImpl::RemoveEntry(
+    std::map<uint256, Entry>::iterator it) const {
+  AssertLockHeld(m_cs);
+  const uint256 &base_hash = it->second.base_hash;
+  if (!base_hash.IsNull()) {
+    const auto dep = m_dependents.find(base_hash);
+    assert(dep != m_dependents.end() && dep->second > 0);
+    if (--dep->second == 0) {
+      m_dependents.erase(dep);
+    }
+  }
+  return m_entries.erase(it);
+}
+
+void StateDBImpl::MigrateLegacyStates() {
+  LOCK(m_cs);
+
   CDBBatch batch(m_db);
+  size_t migrated = 0;
+  std::unique_ptr<CDBIterator> cursor(m_db.NewIterator());
+  for (cursor->SeekToFirst(); cursor->Valid(); cursor->Next()) {
+    // Current keys are a prefix followed by the block hash, one byte longer
+    // than the bare hash the older versions used.
+    std::pair<char, uint256> key;
+    if (cursor->GetKey(key)) {
+      continue;
+    }
+    uint256 block_hash;
+    if (!cursor->GetKey(block_hash)) {
+      continue;
+    }
+    FinalizationState state(*m_finalization_params);
+    if (cursor->GetValue(state)) {
+      batch.Write(std::make_pair(DB_STATE, block_hash), state);
+      ++migrated;
+    } else {
+      LogPrintf("WARN: %s: cannot read legacy finalization state=%s, dropping it\n",
+                __func__, util::to_string(block_hash));
+    }
+    batch.Erase(block_hash);
+  }
+
+  if (batch.SizeEstimate() > 0 && !m_db.WriteBatch(batch, true)) {
+    LogPrintf("ERROR: %s: failed to migrate legacy finalization states\n", __func__);
+    return;
+  }
+  if (migrated > 0) {
+    LogPrintf("Migrated %d finalization states to the current format\n", migrated);
+  }
+}
+
+bool StateDBImpl::Save(const std::map<const CBlockIndex *, FinalizationState> &states) {
+  LOCK(m_cs);
+
+  // Store parents first, so that deltas can be computed against what is on disk.
+  std::vector<std::pair<const CBlockIndex *, const FinalizationState *>> sorted;
+  sorted.reserve(states.size());
   for (const auto &i : states) {
+    sorted.emplace_back(i.first, &i.second);
+  }
+  std::sort(sorted.begin(), sorted.end(), [](const std::pair<const CBlockIndex *, const FinalizationState *> &a,
+                                             const std::pair<const CBlockIndex *, const FinalizationState *> &b) {
+    return a.first->nHeight < b.first->nHeight;
+  });
+
+  CDBBatch batch(m_db);
+  std::set<uint256> written;
+  std::set<uint256> saved;
+  for (const auto &i : sorted) {
     const uint256 &block_hash = i.first->GetBlockHash();
-    const FinalizationState &state = i.second;
-    batch.Write(block_hash, state);
+    const FinalizationState &state = *i.second;
+    saved.emplace(block_hash);
+    m_erased.erase(block_hash);
+
+    const Entry *base = nullptr;
+    uint256 base_hash;
+    if (i.first->pprev != nullptr && !IsSnapshot(*i.first)) {
+      const uint256 &parent_hash = i.first->pprev->GetBlockHash();
+      const auto it = m_entries.find(parent_hash);
+      if (it != m_entries.end() && m_erased.count(parent_hash) == 0 && states.count(i.first->pprev) != 0) {
+        base = &it->second;
+        base_hash = parent_hash;
+      }
+    }
+
+    const auto it = m_entries.find(block_hash);
+    if (it != m_entries.end()) {
+      const Entry &stored = it->second;
+      const bool base_valid = stored.base_hash.IsNull() ||
+                              (stored.base_hash == base_hash && written.count(base_hash) == 0);
+      if (base_valid && stored.state.GetInitStatus() == state.GetInitStatus() && stored.state == state) {
+        continue;
+      }
+      RemoveEntry(it);
+    }
+
+    if (base != nullptr) {
+      batch.Write(std::make_pair(DB_STATE_DELTA, block_hash), StoredDelta(base_hash, base->state, state));
+      batch.Erase(std::make_pair(DB_STATE, block_hash));
+    } else {
+      batch.Write(std::make_pair(DB_STATE, block_hash), state);
+      batch.Erase(std::make_pair(DB_STATE_DELTA, block_hash));
+    }
+    AddEntry(block_hash, Entry{FinalizationState(state, state.GetInitStatus()), base_hash});
+    written.emplace(block_hash);
   }
+
+  for (const uint256 &block_hash : m_erased) {
+    batch.Erase(std::make_pair(DB_STATE, block_hash));
+    batch.Erase(std::make_pair(DB_STATE_DELTA, block_hash));
+  }
+  m_erased.clear();
+
+  // Keep in memory only what the next Save needs to compare against.
+  for (auto it = m_entries.begin(); it != m_entries.end();) {
+    if (saved.count(it->first) == 0) {
+      it = RemoveEntry(it);
+    } else {
+      ++it;
+    }
+  }
+
+  LogPrint(BCLog::FINALIZATION, "%s: %d of %d finalization states written\n",
+           __func__, written.size(), states.size());
   return m_db.WriteBatch(batch, true);
 }
 
@@ -72,28 +319,41 @@ bool StateDBImpl::Load(std::map<const CBlockIndex *, FinalizationState> *states)
 
   assert(states != nullptr);
   AssertLockHeld(m_block_index_map->GetLock());
+  LOCK(m_cs);
 
   states->clear();
 
-  std::unique_ptr<CDBIterator> cursor(m_db.NewIterator());
-  uint256 key;
-  cursor->Seek(key);
+  std::vector<uint256> block_hashes;
+  {
+    std::unique_ptr<CDBIterator> cursor(m_db.NewIterator());
+    cursor->Seek(std::make_pair(DB_STATE_DELTA, uint256()));
 
-  while (cursor->Valid()) {
-    if (!cursor->GetKey(key)) {
-      return error("%s: failed to get key", __func__);
+    for (; cursor->Valid(); cursor->Next()) {
+      std::pair<char, uint256> key;
+      if (!cursor->GetKey(key)) {
+        continue;
+      }
+      if (key.first == DB_STATE || key.first == DB_STATE_DELTA) {
+        block_hashes.emplace_back(key.second);
+      } else if (key.first > DB_STATE) {
+        break;
+      }
     }
-    const CBlockIndex *block_index = m_block_index_map->Lookup(key);
+  }
+
+  for (const uint256 &block_hash : block_hashes) {
+    const CBlockIndex *block_index = m_block_index_map->Lookup(block_hash);
     if (block_index == nullptr) {
-      return error("%s: failed to find block index %s", __func__, util::to_string(key));
+      return error("%s: failed to find block index %s", __func__, util::to_string(block_hash));
     }
-    FinalizationState state(*m_finalization_params);
-    if (!cursor->GetValue(state)) {
-      return error("%s: failed to get value for key %s", __func__, util::to_string(key));
+    const FinalizationState *state = ReadState(block_hash);
+    if (state == nullptr) {
+      LogPrint(BCLog::FINALIZATION, "WARN: %s: cannot load state for block %s, skipping it\n",
+               __func__, util::to_string(block_hash));
+      continue;
     }
-    const auto res = states->emplace(block_index, std::move(state));
+    const auto res = states->emplace(block_index, FinalizationState(*state, state->GetInitStatus()));
     assert(res.second);
-    cursor->Next();
   }
   return true;
 }
@@ -102,10 +362,10 @@ bool StateDBImpl::Load(const CBlockIndex &index,
                        std::map<const CBlockIndex *, FinalizationState> *states) const {
 
   assert(states != nullptr);
+  LOCK(m_cs);
 
-  FinalizationState state(*m_finalization_params);
-  if (m_db.Read(index.GetBlockHash(), state)) {
-    states->emplace(&index, std::move(state));
+  if (const FinalizationState *state = ReadState(index.GetBlockHash())) {
+    states->emplace(&index, FinalizationState(*state, state->GetInitStatus()));
     return true;
   }
 
@@ -113,19 +373,32 @@ bool StateDBImpl::Load(const CBlockIndex &index,
 }
 
 bool StateDBImpl::Erase(const CBlockIndex &index) {
-  return m_db.Erase(index.GetBlockHash());
+  LOCK(m_cs);
+  const uint256 &block_hash = index.GetBlockHash();
+  if (HasDependents(block_hash)) {
+    m_erased.emplace(block_hash);
+    return true;
+  }
+  const auto it = m_entries.find(block_hash);
+  if (it != m_entries.end()) {
+    RemoveEntry(it);
+  }
+  CDBBatch batch(m_db);
+  batch.Erase(std::make_pair(DB_STATE, block_hash));
+  batch.Erase(std::make_pair(DB_STATE_DELTA, block_hash));
+  return m_db.WriteBatch(batch);
 }
 
 boost::optional<uint32_t> StateDBImpl::FindLastFinalizedEpoch() const {
 
   AssertLockHeld(m_active_chain->GetLock());
+  LOCK(m_cs);
 
   const CBlockIndex *walk = m_active_chain->GetTip();
 
   while (walk != nullptr) {
-    FinalizationState state(*m_finalization_params);
-    if (m_db.Read(walk->GetBlockHash(), state)) {
-      return state.GetLastFinalizedEpoch();
+    if (const FinalizationState *state = ReadState(walk->GetBlockHash())) {
+      return state->GetLastFinalizedEpoch();
     }
     walk = walk->pprev;
   }
@@ -140,15 +413,15 @@ void StateDBImpl::LoadStatesHigherThan(
   assert(states != nullptr);
   AssertLockHeld(m_active_chain->GetLock());
   AssertLockHeld(m_block_index_map->GetLock());
+  LOCK(m_cs);
 
   states->clear();
 
   m_block_index_map->ForEach([states, height, this](const uint256 &block_hash, const CBlockIndex &block_index) {
     const CBlockIndex *origin = m_active_chain->FindForkOrigin(block_index);
     if (origin != nullptr && static_cast<blockchain::Height>(origin->nHeight) > height) {
-      FinalizationState state(*m_finalization_params);
-      if (m_db.Read(block_hash, state)) {
-        states->emplace(&block_index, std::move(state));
+      if (const FinalizationState *state = ReadState(block_hash)) {
+        states->emplace(&block_index, FinalizationState(*state, state->GetInitStatus()));
       }
     }
     return true;
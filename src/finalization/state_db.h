@@ -33,11 +33,24 @@ struct StateDBParams {
   bool inmemory = false;
   bool wipe = false;
   bool obfuscate = false;
+  //! Number of epochs between two states which are stored in full. The states
+  //! in between are stored as the changes against the state of their parent.
+  uint32_t snapshot_interval = 10;
 };
 
+//! \brief Persists finalization states.
+//!
+//! A state is stored either in full or as a delta: the changes against the state
+//! of the parent block. States of the checkpoints of every `snapshot_interval`-th
+//! epoch are stored in full, as well as the states whose parent state is not
+//! stored, so that a chain of deltas never grows longer than the interval.
+//! Loading a delta replays it on top of its (recursively loaded) parent.
+//!
+//! The database remembers what it has written, Save only writes the states which
+//! changed since the last time they were saved.
 class StateDB {
  public:
-  //! \brief Saves states.
+  //! \brief Saves the states which are new or changed since they were saved last.
   virtual bool Save(const std::map<const CBlockIndex *, FinalizationState> &states) = 0;
 
   //! \brief Loads all the states.
@@ -47,6 +60,10 @@ class StateDB {
   virtual bool Load(const CBlockIndex &index,
                     std::map<const CBlockIndex *, FinalizationState> *states) const = 0;
 
+  //! \brief Erases the state of the given index.
+  //!
+  //! If deltas of other states are based on it, it's removed from disk by the next
+  //! Save, which also stores these states in full. It cannot be loaded anymore though.
   virtual bool Erase(const CBlockIndex &index) = 0;
 
   //! \brief Returns last finalized epoch accoring to active chain's tip.
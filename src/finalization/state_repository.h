@@ -13,8 +13,10 @@
 
 //! Finalization state of every CBlockIndex in the current dynasty is stored. Once being
 //! processed, it's stored unless next checkpoint is finalized. Every state is a copy of
-//! the previous one plus new finalized commits given from corresponding block. During
-//! lifetime state changes its status: NEW -> [ FROM_COMMITS -> ] COMPLETED.
+//! the previous one plus new finalized commits given from corresponding block. The copy
+//! shares all the unchanged validators and checkpoints with its parent, so a state costs
+//! only as much memory as its block changed. During lifetime state changes its status:
+//! NEW -> [ FROM_COMMITS -> ] COMPLETED.
 //!
 //! Every finalization state is associated with one CBlockIndex (in the current dynasty).
 //! Parent state means the state of the CBlockIndex.pprev. States must be processed
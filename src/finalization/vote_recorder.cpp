@@ -18,6 +18,112 @@ using FinalizationState = esperanza::FinalizationState;
 //! * uint32_t is target epoch
 using DBKey = std::pair<uint160, uint32_t>;
 
+//! The key of the epoch before which votes are only kept in the database.
+const char DB_PRUNED_EPOCH = 'p';
+
+namespace {
+
+//! Whether the recorded vote surrounds the vote or is surrounded by it.
+bool IsSurrounding(const esperanza::Vote &record, const esperanza::Vote &vote) {
+  if (record.m_target_epoch < vote.m_source_epoch ||
+      record.m_source_epoch >= vote.m_target_epoch) {
+    return false;
+  }
+  return (record.m_source_epoch > vote.m_source_epoch &&
+          record.m_target_epoch < vote.m_target_epoch) ||
+         (record.m_source_epoch < vote.m_source_epoch &&
+          record.m_target_epoch > vote.m_target_epoch);
+}
+
+}  // namespace
+
+bool VoteHistory::Insert(const VoteRecord &record) {
+  const esperanza::Vote &vote = record.vote;
+  if (vote.m_target_epoch < m_base_epoch) {
+    return false;
+  }
+  if (!m_records.emplace(vote.m_target_epoch, record).second) {
+    return false;
+  }
+  // A vote which doesn't go forward can neither surround nor be surrounded
+  if (vote.m_source_epoch < vote.m_target_epoch) {
+    Index(vote.m_source_epoch, vote.m_target_epoch);
+  }
+  return true;
+}
+
+void VoteHistory::Index(const uint32_t source_epoch, const uint32_t target_epoch) {
+  {
+    auto it = m_max_targets.upper_bound(source_epoch);
+    const bool covered = it != m_max_targets.begin() &&
+                         std::prev(it)->second >= target_epoch;
+    if (!covered) {
+      while (it != m_max_targets.end() && it->second <= target_epoch) {
+        it = m_max_targets.erase(it);
+      }
+      m_max_targets[source_epoch] = target_epoch;
+    }
+  }
+  {
+    auto it = m_min_targets.lower_bound(source_epoch);
+    const bool covered = it != m_min_targets.end() &&
+                         it->second <= target_epoch;
+    if (!covered) {
+      while (it != m_min_targets.begin() && std::prev(it)->second >= target_epoch) {
+        m_min_targets.erase(std::prev(it));
+      }
+      m_min_targets[source_epoch] = target_epoch;
+    }
+  }
+}
+
+const VoteRecord *VoteHistory::Find(const uint32_t target_epoch) const {
+  const auto it = m_records.find(target_epoch);
+  if (it == m_records.end()) {
+    return nullptr;
+  }
+  return &it->second;
+}
+
+const VoteRecord *VoteHistory::FindSurrounding(const uint32_t source_epoch,
+                                               const uint32_t target_epoch) const {
+  assert(source_epoch >= m_base_epoch);
+  if (source_epoch >= target_epoch) {
+    return nullptr;
+  }
+
+  // The smallest target of the votes with a later source
+  const auto min_it = m_min_targets.upper_bound(source_epoch);
+  if (min_it != m_min_targets.end() && min_it->second < target_epoch) {
+    return &m_records.at(min_it->second);
+  }
+
+  // The largest target of the votes with an earlier source
+  auto max_it = m_max_targets.lower_bound(source_epoch);
+  if (max_it != m_max_targets.begin() && (--max_it)->second > target_epoch) {
+    return &m_records.at(max_it->second);
+  }
+
+  return nullptr;
+}
+
+void VoteHistory::Prune(const uint32_t base_epoch) {
+  if (base_epoch <= m_base_epoch) {
+    return;
+  }
+  m_base_epoch = base_epoch;
+  m_records.erase(m_records.begin(), m_records.lower_bound(base_epoch));
+
+  m_max_targets.clear();
+  m_min_targets.clear();
+  for (const auto &it : m_records) {
+    const esperanza::Vote &vote = it.second.vote;
+    if (vote.m_source_epoch < vote.m_target_epoch) {
+      Index(vote.m_source_epoch, vote.m_target_epoch);
+    }
+  }
+}
+
 CCriticalSection VoteRecorder::cs_recorder;
 std::shared_ptr<VoteRecorder> VoteRecorder::g_voteRecorder;
 
@@ -34,24 +140,55 @@ void VoteRecorder::LoadFromDB() {
   uint32_t count = 0;
   voteRecords.clear();
   voteCache.clear();
+  m_pruned_epoch = 0;
+  m_db.Read(DB_PRUNED_EPOCH, m_pruned_epoch);
   std::unique_ptr<CDBIterator> cursor(m_db.NewIterator());
   cursor->SeekToFirst();
   while (cursor->Valid()) {
     DBKey key;
     if (!cursor->GetKey(key)) {
+      char marker;
+      if (cursor->GetKey(marker) && marker == DB_PRUNED_EPOCH) {
+        cursor->Next();
+        continue;
+      }
       LogPrintf("WARN: cannot read next key from votes DB\n");
       return;
     }
+    if (key.second < m_pruned_epoch) {
+      cursor->Next();
+      continue;
+    }
     VoteRecord record;
     if (!cursor->GetValue(record)) {
       LogPrintf("WARN: cannot fetch data from votes DB, key=%s\n", util::to_string(key));
       return;
     }
-    voteRecords[key.first].emplace(key.second, record);
+    voteRecords.emplace(key.first, VoteHistory(m_pruned_epoch)).first->second.Insert(record);
     cursor->Next();
     ++count;
   }
-  LogPrint(BCLog::FINALIZATION, "Loaded %d vote records\n", count);
+  LogPrint(BCLog::FINALIZATION, "Loaded %d vote records, votes before epoch %d are kept on disk\n",
+           count, m_pruned_epoch);
+}
+
+void VoteRecorder::PruneVotes(const uint32_t epoch) {
+  AssertLockHeld(cs_recorder);
+  if (epoch <= m_pruned_epoch) {
+    return;
+  }
+  m_pruned_epoch = epoch;
+  m_db.Write(DB_PRUNED_EPOCH, m_pruned_epoch);
+
+  for (auto it = voteRecords.begin(); it != voteRecords.end();) {
+    it->second.Prune(m_pruned_epoch);
+    if (it->second.IsEmpty()) {
+      it = voteRecords.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  LogPrint(BCLog::FINALIZATION, "Votes before epoch %d are kept on disk only\n", m_pruned_epoch);
 }
 
 void VoteRecorder::SaveVoteToDB(const VoteRecord &record) {
@@ -72,22 +209,25 @@ void VoteRecorder::RecordVote(const esperanza::Vote &vote,
     return;
   }
 
+  // Votes of finalized epochs can't be reverted, older votes are only needed
+  // to check votes which use a source before it.
+  PruneVotes(fin_state.GetLastFinalizedEpoch());
+
   boost::optional<VoteRecord> offendingVote = FindOffendingVote(vote);
 
   VoteRecord voteRecord{vote, voteSig};
 
   // Record the vote
-  bool saved_in_memory = false;
-  const auto validatorIt = voteRecords.find(vote.m_validator_address);
-  if (validatorIt != voteRecords.end()) {
-    saved_in_memory = validatorIt->second.emplace(vote.m_target_epoch, voteRecord).second;
+  bool is_new = false;
+  if (vote.m_target_epoch < m_pruned_epoch) {
+    is_new = !m_db.Exists(DBKey(vote.m_validator_address, vote.m_target_epoch));
   } else {
-    std::map<uint32_t, VoteRecord> newMap;
-    newMap.emplace(vote.m_target_epoch, voteRecord);
-    saved_in_memory = voteRecords.emplace(vote.m_validator_address, std::move(newMap)).second;
+    const auto validatorIt =
+        voteRecords.emplace(vote.m_validator_address, VoteHistory(m_pruned_epoch)).first;
+    is_new = validatorIt->second.Insert(voteRecord);
   }
 
-  if (saved_in_memory) {
+  if (is_new) {
     SaveVoteToDB(voteRecord);
   }
 
@@ -120,44 +260,74 @@ boost::optional<VoteRecord> VoteRecorder::FindOffendingVote(const esperanza::Vot
     }
   }
 
-  esperanza::Vote slashCandidate;
+  // Votes reaching before the pruned epoch could be slashed for votes which
+  // are not kept in memory anymore
+  if (vote.m_source_epoch < m_pruned_epoch || vote.m_target_epoch < m_pruned_epoch) {
+    return FindOffendingVoteInDB(vote);
+  }
+
   const auto validatorIt = voteRecords.find(vote.m_validator_address);
   if (validatorIt != voteRecords.end()) {
 
-    const auto &voteMap = validatorIt->second;
+    const VoteHistory &history = validatorIt->second;
 
     // Check for double votes
-    const auto recordIt = voteMap.find(vote.m_target_epoch);
-    if (recordIt != voteMap.end()) {
-      if (recordIt->second.vote.m_target_hash != vote.m_target_hash) {
-        return recordIt->second;
-      }
+    const VoteRecord *record = history.Find(vote.m_target_epoch);
+    if (record != nullptr && record->vote.m_target_hash != vote.m_target_hash) {
+      return *record;
     }
 
     // Check for a surrounding vote
-    for (auto it = voteMap.lower_bound(vote.m_source_epoch); it != voteMap.end(); ++it) {
-      const VoteRecord &record = it->second;
-      if (record.vote.m_source_epoch < vote.m_target_epoch) {
-        if ((record.vote.m_source_epoch > vote.m_source_epoch &&
-             record.vote.m_target_epoch < vote.m_target_epoch) ||
-            (record.vote.m_source_epoch < vote.m_source_epoch &&
-             record.vote.m_target_epoch > vote.m_target_epoch)) {
-          return record;
-        }
-      }
+    record = history.FindSurrounding(vote.m_source_epoch, vote.m_target_epoch);
+    if (record != nullptr) {
+      return *record;
     }
   }
   return boost::none;
 }
 
+boost::optional<VoteRecord> VoteRecorder::FindOffendingVoteInDB(const esperanza::Vote &vote) {
+  AssertLockHeld(cs_recorder);
+
+  // Check for double votes
+  VoteRecord record;
+  if (m_db.Read(DBKey(vote.m_validator_address, vote.m_target_epoch), record) &&
+      record.vote.m_target_hash != vote.m_target_hash) {
+    return record;
+  }
+
+  // Check for a surrounding vote. Epochs are not stored in order, so all the
+  // votes of the validator are scanned.
+  std::unique_ptr<CDBIterator> cursor(m_db.NewIterator());
+  cursor->Seek(DBKey(vote.m_validator_address, 0));
+  while (cursor->Valid()) {
+    DBKey key;
+    if (!cursor->GetKey(key) || key.first != vote.m_validator_address) {
+      break;
+    }
+    if (cursor->GetValue(record) && IsSurrounding(record.vote, vote)) {
+      return record;
+    }
+    cursor->Next();
+  }
+  return boost::none;
+}
+
 boost::optional<VoteRecord> VoteRecorder::GetVote(const uint160 &validatorAddress, uint32_t epoch) const {
 
   LOCK(cs_recorder);
+  if (epoch < m_pruned_epoch) {
+    VoteRecord record;
+    if (m_db.Read(DBKey(validatorAddress, epoch), record)) {
+      return record;
+    }
+    return boost::none;
+  }
   const auto validatorIt = voteRecords.find(validatorAddress);
   if (validatorIt != voteRecords.end()) {
-    const auto recordIt = validatorIt->second.find(epoch);
-    if (recordIt != validatorIt->second.end()) {
-      return recordIt->second;
+    const VoteRecord *record = validatorIt->second.Find(epoch);
+    if (record != nullptr) {
+      return *record;
     }
   }
   return boost::none;
@@ -45,6 +45,50 @@ struct VoteRecord {
   }
 };
 
+//! \brief Votes of a single validator which are kept in memory.
+//!
+//! Next to the votes keyed by target epoch it keeps two staircases of
+//! (source, target) pairs with the targets growing along the sources: one
+//! gives the largest target of the votes with a source before any epoch, the
+//! other the smallest target of the votes with a source after it. A vote
+//! (s, t) is surrounded by a recorded vote if the former is greater than t and
+//! surrounds one if the latter is less than t, so both checks are a single
+//! lookup. Votes targeting epochs before the base epoch are not kept.
+class VoteHistory {
+ public:
+  explicit VoteHistory(uint32_t base_epoch) : m_base_epoch(base_epoch) {}
+
+  //! Adds the record unless there is a vote for its target epoch already.
+  bool Insert(const VoteRecord &record);
+
+  const VoteRecord *Find(uint32_t target_epoch) const;
+
+  //! \brief Returns a vote which surrounds or is surrounded by the given one.
+  //!
+  //! source_epoch must not be before the base epoch, older votes which could
+  //! be surrounded are not known to the history.
+  const VoteRecord *FindSurrounding(uint32_t source_epoch,
+                                    uint32_t target_epoch) const;
+
+  //! Drops the votes targeting epochs before base_epoch.
+  void Prune(uint32_t base_epoch);
+
+  uint32_t GetBaseEpoch() const { return m_base_epoch; }
+  bool IsEmpty() const { return m_records.empty(); }
+
+ private:
+  uint32_t m_base_epoch;
+  std::map<uint32_t, VoteRecord> m_records;
+
+  //! No vote has a source before or at the key and a target after the value.
+  std::map<uint32_t, uint32_t> m_max_targets;
+
+  //! No vote has a source after or at the key and a target before the value.
+  std::map<uint32_t, uint32_t> m_min_targets;
+
+  void Index(uint32_t source_epoch, uint32_t target_epoch);
+};
+
 class VoteRecorder : private boost::noncopyable {
  public:
   struct DBParams {
@@ -57,9 +101,12 @@ class VoteRecorder : private boost::noncopyable {
  private:
   VoteRecorder(const DBParams &p);
 
-  // Contains a map by validatorAddress. Each entry contains a map of the target
-  // epoch height with the actual vote
-  std::map<uint160, std::map<uint32_t, VoteRecord>> voteRecords;
+  // Contains the votes of every validator which target the last finalized
+  // epoch or later. Older votes are only kept in the database.
+  std::map<uint160, VoteHistory> voteRecords;
+
+  // Votes targeting epochs before this one were pruned from voteRecords
+  uint32_t m_pruned_epoch = 0;
 
   // Contains the most recent vote casted by any validator
   std::map<uint160, VoteRecord> voteCache;
@@ -70,6 +117,8 @@ class VoteRecorder : private boost::noncopyable {
   static std::shared_ptr<VoteRecorder> g_voteRecorder;
 
   boost::optional<VoteRecord> FindOffendingVote(const esperanza::Vote &vote);
+  boost::optional<VoteRecord> FindOffendingVoteInDB(const esperanza::Vote &vote);
+  void PruneVotes(uint32_t epoch);
   void LoadFromDB();
   void SaveVoteToDB(const VoteRecord &record);
 
@@ -7,7 +7,11 @@
 #define UNITE_IBLT_H
 
 #include <stdlib.h>
+#include <algorithm>
+#include <array>
 #include <cinttypes>
+#include <ios>
+#include <map>
 #include <set>
 #include <vector>
 
@@ -25,10 +29,14 @@
 //!
 //! "Invertible Bloom Lookup Tables" by Goodrich and
 //! Mitzenmacher
+//!
+//! Values are stored inline in the entries so the table is one contiguous
+//! allocation and IBLTs with ValueSize == 0 don't allocate per entry.
 template <typename TKey, size_t ValueSize>
 class IBLT {
  public:
   using TEntriesMap = std::map<TKey, std::vector<uint8_t>>;
+  using TValue = std::array<uint8_t, ValueSize>;
 
   explicit IBLT(size_t expected_items_count) {
     const IBLTParams optimal_params = IBLTParams::FindOptimal(expected_items_count);
@@ -48,11 +56,11 @@ class IBLT {
   }
 
   void Insert(const TKey key, const std::vector<uint8_t> &value) {
-    Update(1, key, value);
+    Update(1, key, ToValue(value));
   }
 
   void Erase(const TKey key, const std::vector<uint8_t> &value) {
-    Update(-1, key, value);
+    Update(-1, key, ToValue(value));
   }
 
   //! \brief Tries to get a value from the IBLT
@@ -64,58 +72,22 @@ class IBLT {
   bool Get(const TKey key, std::vector<uint8_t> &value_out) const {
     value_out.clear();
 
-    const size_t buckets_per_hash = m_hash_table.size() / m_num_hashes;
-    for (size_t i = 0; i < m_num_hashes; i++) {
-      const size_t start_entry = i * buckets_per_hash;
-
-      // Although in theory seed might overflow here - we don't care.
-      // It is seed after all
-      const auto seed = static_cast<unsigned int>(i);
-      const unsigned int h = ComputeHash(seed, key);
-      const size_t bucket = start_entry + (h % buckets_per_hash);
-      const IBLTEntry &entry = m_hash_table.at(bucket);
-
-      if (entry.IsEmpty()) {
-        // Definitely not in the table. Leave result empty, return true.
-        return true;
-      }
-
-      if (entry.IsPure()) {
-        if (entry.key_sum == key) {
-          // Found!
-          value_out = entry.value_sum;
-        }
-        // Otherwise - definitely not in the table.
-        // In any case - we are confident about result, so return true
-        return true;
-      }
+    if (Lookup(key, value_out)) {
+      return true;
     }
 
     // Don't know if key is in table or not; "peel" the IBLT to try to find it
     IBLT<TKey, ValueSize> peeled = *this;
-    bool erased = false;
-    for (size_t i = 0; i < peeled.m_hash_table.size(); ++i) {
-      const IBLTEntry &entry = peeled.m_hash_table[i];
-      if (entry.IsPure()) {
-        if (entry.key_sum == key) {
-          // Found!
-          value_out = entry.value_sum;
-          return true;
-        }
-        erased = true;
-
-        // Need a copy because `Update` will reiterate table and might change
-        // our entry because it is a reference
-        const std::vector<uint8_t> value_sum_copy = entry.value_sum;
-        peeled.Update(-entry.count, entry.key_sum, value_sum_copy);
+    bool found = false;
+    peeled.Peel([&key, &value_out, &found](const IBLTEntry &entry) {
+      if (entry.key_sum == key) {
+        value_out.assign(entry.value_sum.begin(), entry.value_sum.end());
+        found = true;
       }
-    }
+      return !found;
+    });
 
-    if (erased) {
-      // Recurse with smaller IBLT
-      return peeled.Get(key, value_out);
-    }
-    return false;
+    return found || peeled.Lookup(key, value_out);
   }
 
   //! \brief Decodes IBLT entries
@@ -129,25 +101,11 @@ class IBLT {
                    TEntriesMap &negative_out) const {
     IBLT<TKey, ValueSize> peeled = *this;
 
-    bool erased;
-    do {
-      erased = false;
-      for (size_t i = 0; i < peeled.m_hash_table.size(); ++i) {
-        const IBLTEntry &entry = peeled.m_hash_table[i];
-        if (entry.IsPure()) {
-          if (entry.count == 1) {
-            positive_out.emplace(entry.key_sum, entry.value_sum);
-          } else {
-            negative_out.emplace(entry.key_sum, entry.value_sum);
-          }
-          // Update will reiterate table and might change our entry because it
-          // is a reference
-          const std::vector<uint8_t> copy = entry.value_sum;
-          peeled.Update(-entry.count, entry.key_sum, copy);
-          erased = true;
-        }
-      }
-    } while (erased);
+    peeled.Peel([&positive_out, &negative_out](const IBLTEntry &entry) {
+      TEntriesMap &out = entry.count == 1 ? positive_out : negative_out;
+      out.emplace(entry.key_sum, std::vector<uint8_t>(entry.value_sum.begin(), entry.value_sum.end()));
+      return true;
+    });
 
     // If any buckets for one of the hash functions is not empty,
     // then we didn't peel them all:
@@ -172,11 +130,7 @@ class IBLT {
       e1.count -= e2.count;
       e1.key_sum ^= e2.key_sum;
       e1.key_check ^= e2.key_check;
-      if (e1.IsEmpty()) {
-        e1.value_sum.clear();
-      } else {
-        e1.AddValue(e2.value_sum);
-      }
+      e1.AddValue(e2.value_sum);
     }
 
     return result;
@@ -241,7 +195,7 @@ class IBLT {
     int64_t count = 0;
     TKey key_sum = 0;
     uint32_t key_check = 0;
-    std::vector<uint8_t> value_sum;
+    TValue value_sum{};
 
     bool IsPure() const {
       if (count == 1 || count == -1) {
@@ -255,16 +209,8 @@ class IBLT {
       return count == 0 && key_sum == 0 && key_check == 0;
     }
 
-    void AddValue(const std::vector<uint8_t> &value) {
-      if (value.empty()) {
-        return;
-      }
-
-      if (value_sum.size() < value.size()) {
-        value_sum.resize(value.size());
-      }
-
-      for (size_t i = 0; i < value.size(); i++) {
+    void AddValue(const TValue &value) {
+      for (size_t i = 0; i < ValueSize; i++) {
         value_sum[i] ^= value[i];
       }
     }
@@ -283,7 +229,18 @@ class IBLT {
       READWRITE(key_sum);
       READWRITE(key_check);
       if (ValueSize != 0) {
-        READWRITE(value_sum);
+        // serialized as a vector which is empty for empty entries
+        uint64_t value_size = IsEmpty() ? 0 : ValueSize;
+        READWRITE(COMPACTSIZE(value_size));
+        if (ser_action.ForRead()) {
+          if (value_size != 0 && value_size != ValueSize) {
+            throw std::ios_base::failure("Invalid IBLT value size");
+          }
+          value_sum.fill(0);
+        }
+        if (value_size != 0) {
+          READWRITE(value_sum);
+        }
       }
     }
   };
@@ -296,13 +253,85 @@ class IBLT {
     return MurmurHash3(seed, data_ptr, sizeof(key));
   }
 
+  static TValue ToValue(const std::vector<uint8_t> &value) {
+    assert(value.size() == ValueSize);
+
+    TValue result{};
+    std::copy(value.begin(), value.end(), result.begin());
+    return result;
+  }
+
   static constexpr size_t N_HASHCHECK = 11;
 
+  //! \brief Looks the key up in its buckets
+  //!
+  //! \returns True if the key is definitely found or not found
+  bool Lookup(const TKey key, std::vector<uint8_t> &value_out) const {
+    const size_t buckets_per_hash = m_hash_table.size() / m_num_hashes;
+    for (size_t i = 0; i < m_num_hashes; i++) {
+      const size_t start_entry = i * buckets_per_hash;
+
+      // Although in theory seed might overflow here - we don't care.
+      // It is seed after all
+      const auto seed = static_cast<unsigned int>(i);
+      const unsigned int h = ComputeHash(seed, key);
+      const size_t bucket = start_entry + (h % buckets_per_hash);
+      const IBLTEntry &entry = m_hash_table[bucket];
+
+      if (entry.IsEmpty()) {
+        // Definitely not in the table. Leave result empty, return true.
+        return true;
+      }
+
+      if (entry.IsPure()) {
+        if (entry.key_sum == key) {
+          // Found!
+          value_out.assign(entry.value_sum.begin(), entry.value_sum.end());
+        }
+        // Otherwise - definitely not in the table.
+        // In any case - we are confident about result, so return true
+        return true;
+      }
+    }
+    return false;
+  }
+
+  //! \brief Removes pure entries until there are none left
+  //!
+  //! Only the buckets touched by removing an entry can become pure, so they
+  //! are queued instead of rescanning the table. \p on_pure is invoked with
+  //! every pure entry before it's removed and stops peeling by returning false.
+  template <typename Callback>
+  void Peel(Callback on_pure) {
+    std::vector<size_t> queue;
+    for (size_t i = 0; i < m_hash_table.size(); ++i) {
+      if (m_hash_table[i].IsPure()) {
+        queue.push_back(i);
+      }
+    }
+
+    while (!queue.empty()) {
+      const size_t bucket = queue.back();
+      queue.pop_back();
+
+      // the entry might have changed since it was queued
+      if (!m_hash_table[bucket].IsPure()) {
+        continue;
+      }
+
+      // Update will change the entry, so a copy is needed
+      const IBLTEntry entry = m_hash_table[bucket];
+      if (!on_pure(entry)) {
+        return;
+      }
+      Update(-entry.count, entry.key_sum, entry.value_sum, &queue);
+    }
+  }
+
   void Update(const int64_t count_delta,
               const TKey key,
-              const std::vector<uint8_t> &value) {
-
-    assert(value.size() == ValueSize);
+              const TValue &value,
+              std::vector<size_t> *pure_out = nullptr) {
 
     const unsigned int key_check = ComputeHash(N_HASHCHECK, key);
 
@@ -315,14 +344,14 @@ class IBLT {
       const auto seed = static_cast<unsigned int>(i);
       const unsigned int h = ComputeHash(seed, key);
       const size_t bucket = start_entry + (h % buckets_per_hash);
-      IBLTEntry &entry = m_hash_table.at(bucket);
+      IBLTEntry &entry = m_hash_table[bucket];
       entry.count += count_delta;
       entry.key_sum ^= key;
       entry.key_check ^= key_check;
-      if (entry.IsEmpty()) {
-        entry.value_sum.clear();
-      } else {
-        entry.AddValue(value);
+      entry.AddValue(value);
+
+      if (pure_out && entry.IsPure()) {
+        pure_out->push_back(bucket);
       }
     }
   }
@@ -1926,10 +1926,11 @@ bool AppInitMain()
 
     g_wallet_init_interface.Start(scheduler);
 
-    // ********************************************************* Step 13: start proposer
+    // ********************************************************* Step 13: start proposer and voter
 
 #ifdef ENABLE_WALLET
     GetComponent<proposer::Proposer>()->Start();
+    GetComponent<esperanza::Voter>()->Start();
 #endif
 
     LogPrintf("Started up.\n");
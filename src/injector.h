@@ -33,6 +33,7 @@
 #include <util.h>
 
 #ifdef ENABLE_WALLET
+#include <esperanza/voter.h>
 #include <proposer/block_builder.h>
 #include <proposer/multiwallet.h>
 #include <proposer/proposer.h>
@@ -153,6 +154,12 @@ class UnitEInjector : public Injector<UnitEInjector> {
             proposer::BlockBuilder,
             proposer::Logic)
 
+  COMPONENT(Voter, esperanza::Voter, esperanza::Voter::New,
+            Settings,
+            proposer::MultiWallet,
+            staking::ActiveChain,
+            finalization::StateRepository)
+
 #endif
 
   UnitEInjectorConfiguration m_config;
@@ -254,7 +254,8 @@ void BlockAssembler::AddMandatoryTxs()
         if (mi->GetTx().IsVote()) {
             CValidationState state;
             //Check again in case the vote became invalid in the meanwhile (different target now)
-            if (esperanza::ContextualCheckVoteTx(mi->GetTx(), state, *fin_state, *pcoinsTip)) {
+            //The vote is still in the mempool, so its signature stays cached.
+            if (esperanza::ContextualCheckVoteTx(mi->GetTx(), state, *fin_state, *pcoinsTip, /* cache_sig_store= */ true)) {
                 AddToBlock(mempool.mapTx.project<0>(mi));
                 LogPrint(BCLog::FINALIZATION, /* Continued */
                          "%s: Add vote with id %s to a new block.\n",
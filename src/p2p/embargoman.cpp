@@ -55,7 +55,8 @@ bool EmbargoMan::SendToAndRemember(NodeId relay,
 
     LOCK(m_embargo_cs);
     m_embargoes.emplace(tx_hash, Embargo(relay, embargo_time));
-    m_embargo_to_tx.emplace(embargo_time, tx_hash);
+    m_embargo_to_tx.emplace(embargo_time, m_embargo_seq++, tx_hash);
+    m_next_embargo_time = std::get<0>(m_embargo_to_tx.top());
 
     return true;
   }
@@ -94,6 +95,10 @@ bool EmbargoMan::SendTransactionAndEmbargo(const CTransaction &tx) {
 }
 
 void EmbargoMan::FluffPendingEmbargoes() {
+  if (!m_side_effects->IsEmbargoDue(m_next_embargo_time)) {
+    return;
+  }
+
   LOCK(m_relay_cs);
   AssertLockNotHeld(m_embargo_cs);
 
@@ -103,14 +108,14 @@ void EmbargoMan::FluffPendingEmbargoes() {
     LOCK(m_embargo_cs);
 
     while (!m_embargo_to_tx.empty()) {
-      const uint256 tx_hash = m_embargo_to_tx.begin()->second;
-      const EmbargoTime embargo_time = m_embargo_to_tx.begin()->first;
+      const uint256 tx_hash = std::get<2>(m_embargo_to_tx.top());
+      const EmbargoTime embargo_time = std::get<0>(m_embargo_to_tx.top());
 
       if (!m_side_effects->IsEmbargoDue(embargo_time)) {
         break;
       }
 
-      m_embargo_to_tx.erase(m_embargo_to_tx.begin());
+      m_embargo_to_tx.pop();
 
       const auto it = m_embargoes.find(tx_hash);
 
@@ -137,10 +142,16 @@ void EmbargoMan::FluffPendingEmbargoes() {
 
       txs_to_fluff.emplace_back(tx_hash);
     }
+
+    m_next_embargo_time = m_embargo_to_tx.empty()
+                              ? std::numeric_limits<EmbargoTime>::max()
+                              : std::get<0>(m_embargo_to_tx.top());
   }
 
-  for (const uint256 &tx : txs_to_fluff) {
-    m_side_effects->SendTxInvToAll(tx);
+  // all due transactions are announced together so every peer
+  // gets them in one INV message
+  if (!txs_to_fluff.empty()) {
+    m_side_effects->SendTxInvToAll(txs_to_fluff);
   }
 }
 
@@ -190,7 +201,7 @@ void EmbargoMan::OnTxInv(const uint256 &tx_hash, NodeId from) {
              tx_hash.GetHex());
   }
 
-  m_side_effects->SendTxInvToAll(tx_hash);
+  m_side_effects->SendTxInvToAll({tx_hash});
 }
 
 EmbargoMan::EmbargoTime EmbargoMan::GetEmbargoTime(const CTransaction &tx) {
@@ -6,9 +6,15 @@
 #define UNITE_P2P_EMBARGOMAN_H
 
 #include <stdint.h>
+#include <atomic>
 #include <chrono>
+#include <functional>
+#include <limits>
 #include <memory>
+#include <queue>
 #include <set>
+#include <tuple>
+#include <vector>
 
 #include <primitives/transaction.h>
 #include <util.h>
@@ -36,7 +42,9 @@ class EmbargoManSideEffects {
   virtual std::set<NodeId> GetOutboundNodes() = 0;
   virtual size_t RandRange(size_t max_excluding) = 0;
   virtual bool SendTxInv(NodeId node_id, const uint256 &tx_hash) = 0;
-  virtual void SendTxInvToAll(const uint256 &tx) = 0;
+
+  //! \brief Announces all transactions to every peer at once
+  virtual void SendTxInvToAll(const std::vector<uint256> &tx_hashes) = 0;
 
   virtual ~EmbargoManSideEffects() = default;
 };
@@ -91,7 +99,18 @@ class EmbargoMan {
   mutable CCriticalSection m_relay_cs;
   mutable CCriticalSection m_embargo_cs;
 
-  std::multimap<EmbargoTime, uint256> m_embargo_to_tx GUARDED_BY(m_embargo_cs);
+  //! min-heap of embargo times, contiguous so that enqueueing doesn't allocate
+  //! a tree node per transaction. Embargoes with the same time expire in the
+  //! order they were set, which the sequence number keeps.
+  using EmbargoEntry = std::tuple<EmbargoTime, uint64_t, uint256>;
+  std::priority_queue<EmbargoEntry, std::vector<EmbargoEntry>, std::greater<EmbargoEntry>>
+      m_embargo_to_tx GUARDED_BY(m_embargo_cs);
+  uint64_t m_embargo_seq GUARDED_BY(m_embargo_cs) = 0;
+
+  //! the earliest time in m_embargo_to_tx. FluffPendingEmbargoes is polled
+  //! from the message handler for every peer, it's read to return without
+  //! locking when nothing is due
+  std::atomic<EmbargoTime> m_next_embargo_time{std::numeric_limits<EmbargoTime>::max()};
 
   struct Embargo {
     Embargo(NodeId relay, EmbargoTime embargo_time);
@@ -87,13 +87,15 @@ class SideEffectsImpl : public EmbargoManSideEffects {
     });
   }
 
-  void SendTxInvToAll(const uint256 &tx_hash) override {
-    return m_connman.ForEachNode([&tx_hash](CNode *node) {
+  void SendTxInvToAll(const std::vector<uint256> &tx_hashes) override {
+    return m_connman.ForEachNode([&tx_hashes](CNode *node) {
       // According to sdaftuar and gmaxwell
       // It is better to not send transactions directly
       // https://github.com/bitcoin/bitcoin/pull/13947/files#r210074699
-      CInv inv(MSG_TX, tx_hash);
-      node->PushInventory(inv);
+      LOCK(node->cs_inventory);
+      for (const uint256 &tx_hash : tx_hashes) {
+        node->PushInventory(CInv(MSG_TX, tx_hash));
+      }
     });
   }
 
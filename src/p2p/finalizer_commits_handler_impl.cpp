@@ -225,6 +225,9 @@ void FinalizerCommitsHandlerImpl::OnGetCommits(
   assert(m_active_chain->Contains(*walk));
 
   FinalizerCommitsResponse response;
+  // Serialized size of response.data items, the response is not serialized
+  // again to check the message length.
+  size_t data_size = 0;
   do {
     walk = m_active_chain->GetNext(*walk);
     if (walk == nullptr) {
@@ -232,7 +235,7 @@ void FinalizerCommitsHandlerImpl::OnGetCommits(
       break;
     }
 
-    const boost::optional<HeaderAndFinalizerCommits> header_and_commits =
+    boost::optional<HeaderAndFinalizerCommits> header_and_commits =
         FindHeaderAndFinalizerCommits(*walk, params);
     if (!header_and_commits) {
       continue;
@@ -241,19 +244,16 @@ void FinalizerCommitsHandlerImpl::OnGetCommits(
     // In case of long unjustified dynasty we can reach the message length limit.
     // To prevent this, compute message length on every iteration and set status=
     // LengthExceeded once limit reached.
-    FinalizerCommitsResponse response_copy = response;
-
-    response_copy.data.emplace_back(*header_and_commits);
-
-    const size_t response_size = GetSerializeSize(response_copy, SER_NETWORK, PROTOCOL_VERSION);
+    const size_t item_size = GetSerializeSize(*header_and_commits, SER_NETWORK, PROTOCOL_VERSION);
+    const size_t response_size = GetResponseSize(response.data.size() + 1, data_size + item_size);
     if (response_size >= MAX_PROTOCOL_MESSAGE_LENGTH) {
       response.status = FinalizerCommitsResponse::Status::LengthExceeded;
-      LogPrint(BCLog::NET, "Send %d headers+commits, status=%d\n",
-               response.data.size(), static_cast<uint8_t>(response.status));
-      PushMessage(node, NetMsgType::COMMITS, std::move(response));
+      SendCommits(node, std::move(response));
       response = FinalizerCommitsResponse();
+      data_size = 0;
     } else {
-      response = std::move(response_copy);
+      response.data.emplace_back(std::move(*header_and_commits));
+      data_size += item_size;
     }
 
   } while (walk != stop && !fin_state->IsFinalizedCheckpoint(walk->nHeight));
@@ -262,6 +262,14 @@ void FinalizerCommitsHandlerImpl::OnGetCommits(
     return;
   }
 
+  SendCommits(node, std::move(response));
+}
+
+size_t FinalizerCommitsHandlerImpl::GetResponseSize(const size_t data_count, const size_t data_size) {
+  return sizeof(FinalizerCommitsResponse::Status) + GetSizeOfCompactSize(data_count) + data_size;
+}
+
+void FinalizerCommitsHandlerImpl::SendCommits(CNode &node, FinalizerCommitsResponse &&response) const {
   LogPrint(BCLog::NET, "Send %d headers+commits, status=%d\n",
            response.data.size(), static_cast<uint8_t>(response.status));
   PushMessage(node, NetMsgType::COMMITS, std::move(response));
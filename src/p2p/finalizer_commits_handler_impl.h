@@ -72,6 +72,16 @@ class FinalizerCommitsHandlerImpl : public FinalizerCommitsHandler {
   //!
   static bool IsSameFork(const CBlockIndex *head, const CBlockIndex *test, const CBlockIndex *&prev);
 
+  //! \brief Returns the serialized size of a "commits" message.
+  //!
+  //! The message holds data_count items, data_size is their serialized size.
+  //! OnGetCommits sums up the sizes of the items it adds, instead of
+  //! serializing the message again for every item.
+  static size_t GetResponseSize(size_t data_count, size_t data_size);
+
+  //! \brief Sends a "commits" message to the node.
+  virtual void SendCommits(CNode &node, FinalizerCommitsResponse &&response) const;
+
  private:
   const CBlockIndex &FindLastFinalizedCheckpoint(
       const finalization::FinalizationState &fin_state) const;
@@ -84,19 +84,21 @@ GrapheneBlockReconstructor::GrapheneBlockReconstructor(const GrapheneBlock &grap
   std::unordered_map<GrapheneShortHash, CTransactionRef> candidates;
   bool hash_collision = false;
 
-  GrapheneIblt receiver_iblt = graphene_block.iblt.CloneEmpty();
+  // Transactions of the receiver are erased from the sender's IBLT right away
+  // instead of building the receiver's IBLT and subtracting it
+  GrapheneIblt iblt_diff = graphene_block.iblt;
 
   {
     SCOPE_STOPWATCH("Graphene tx pool enumeration");
 
-    const std::vector<CTransactionRef> txs = tx_pool.GetTxs();
-    for (const CTransactionRef &tx : txs) {
-      const GrapheneFullHash full_hash = m_hasher.GetFullHash(*tx);
-      const GrapheneShortHash short_hash = m_hasher.GetShortHash(full_hash);
+    // Most of the pool is filtered out by the bloom filter, so short hashes
+    // are only computed for the transactions which can be in the block
+    const auto filter = [&graphene_block, &hash_collision](const uint256 &witness_hash) {
+      return !hash_collision && graphene_block.bloom_filter.contains(witness_hash);
+    };
 
-      if (!graphene_block.bloom_filter.contains(full_hash)) {
-        continue;
-      }
+    const auto visit = [&](const CTransactionRef &tx) {
+      const GrapheneShortHash short_hash = m_hasher.GetShortHash(*tx);
 
       const auto emplace_result = candidates.emplace(short_hash, tx);
       if (!emplace_result.second) {
@@ -106,10 +108,12 @@ GrapheneBlockReconstructor::GrapheneBlockReconstructor(const GrapheneBlock &grap
                  graphene_block.header.GetHash().GetHex(), tx->GetHash().GetHex(), already_stored_hash.GetHex(), short_hash);
 
         hash_collision = true;
-        break;
+        return;
       }
-      receiver_iblt.Insert(short_hash, {});
+      iblt_diff.Erase(short_hash, {});
     };
+
+    tx_pool.ForEachTx(filter, visit);
   }
 
   if (hash_collision) {
@@ -117,15 +121,13 @@ GrapheneBlockReconstructor::GrapheneBlockReconstructor(const GrapheneBlock &grap
     return;
   }
 
-  const GrapheneIblt iblt_diff = graphene_block.iblt - receiver_iblt;
-
   GrapheneIblt::TEntriesMap only_sender_has;
   GrapheneIblt::TEntriesMap only_receiver_has;
 
   const bool reconciled = iblt_diff.ListEntries(only_sender_has, only_receiver_has);
   if (!reconciled) {
-    LogPrint(BCLog::NET, "Can not reconcile graphene block %s. Receiver iblt has %d txs, sender has %d\n",
-             graphene_block.header.GetHash().GetHex(), receiver_iblt.Size(), graphene_block.iblt.Size());
+    LogPrint(BCLog::NET, "Can not reconcile graphene block %s. Receiver has %d candidate txs, sender has %d\n",
+             graphene_block.header.GetHash().GetHex(), candidates.size(), graphene_block.iblt.Size());
     m_state = GrapheneDecodeState::CANT_DECODE_IBLT;
 
     return;
@@ -6,6 +6,7 @@
 #include <proposer/proposer.h>
 
 #include <chainparams.h>
+#include <checkqueue.h>
 #include <key_io.h>
 #include <net.h>
 #include <proposer/block_builder.h>
@@ -23,14 +24,68 @@
 #include <utilmoneystr.h>
 #include <wallet/wallet.h>
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <memory>
 #include <numeric>
+#include <thread>
+
+#include <boost/thread.hpp>
 
 namespace proposer {
 
 namespace {
+
+//! \brief The part of a new block which doesn't depend on the winning stake.
+//!
+//! Picking transactions and computing the snapshot hash only depend on the
+//! tip and the mempool. The active proposer keeps a candidate around and
+//! refreshes it when either of them changes, so that winning a slot only
+//! requires the coinbase transaction to be built and the block to be signed.
+struct BlockCandidate {
+  const CBlockIndex *tip = nullptr;
+  unsigned int transactions_updated = 0;
+  uint256 snapshot_hash;
+  std::vector<CTransactionRef> transactions;
+  CAmount fees = 0;
+};
+
+void PrepareCandidate(staking::ActiveChain &active_chain,
+                      staking::TransactionPicker &transaction_picker,
+                      BlockCandidate &candidate) {
+  AssertLockHeld(active_chain.GetLock());
+
+  candidate.tip = active_chain.GetTip();
+  // Read before picking, a change while picking then triggers another refresh.
+  candidate.transactions_updated = transaction_picker.GetTransactionsUpdated();
+
+  staking::TransactionPicker::PickTransactionsParameters parameters{};
+  staking::TransactionPicker::PickTransactionsResult result =
+      transaction_picker.PickTransactions(parameters);
+
+  if (!result) {
+    LogPrint(BCLog::PROPOSING, "Failed to pick transactions (error=%s) – proposing empty block.\n", result.error);
+  }
+  candidate.transactions = std::move(result.transactions);
+  candidate.fees = std::accumulate(result.fees.begin(), result.fees.end(), CAmount(0));
+  candidate.snapshot_hash = active_chain.ComputeSnapshotHash();
+}
+
+std::shared_ptr<const CBlock> AssembleBlock(proposer::BlockBuilder &block_builder,
+                                            staking::StakingWallet &wallet,
+                                            const BlockCandidate &candidate,
+                                            const EligibleCoin &coin,
+                                            const staking::CoinSet &coins,
+                                            const boost::optional<CScript> &coinbase_script) {
+
+  LogPrint(BCLog::PROPOSING, "Proposing... (wallet=%s, coin=%s)\n",
+           wallet.GetName(), util::to_string(coin.utxo));
+
+  return block_builder.BuildBlock(
+      *candidate.tip, candidate.snapshot_hash, coin, coins, candidate.transactions, candidate.fees, coinbase_script, wallet);
+}
+
 std::shared_ptr<const CBlock> GenerateBlock(staking::ActiveChain &active_chain,
                                             staking::TransactionPicker &transaction_picker,
                                             proposer::BlockBuilder &block_builder,
@@ -39,28 +94,19 @@ std::shared_ptr<const CBlock> GenerateBlock(staking::ActiveChain &active_chain,
                                             const staking::CoinSet &coins,
                                             const boost::optional<CScript> &coinbase_script) {
 
-  const std::string &wallet_name = wallet.GetName();
-
-  const boost::optional<EligibleCoin> winning_ticket = logic.TryPropose(coins);
-  if (!winning_ticket) {
-    LogPrint(BCLog::PROPOSING, "Not proposing this time (wallet=%s)\n", wallet_name);
+  LOCK(active_chain.GetLock());
+  const CBlockIndex *const tip = active_chain.GetTip();
+  if (!tip) {
     return nullptr;
   }
-  const EligibleCoin &coin = winning_ticket.get();
-  LogPrint(BCLog::PROPOSING, "Proposing... (wallet=%s, coin=%s)\n",
-           wallet_name, util::to_string(coin.utxo));
-  staking::TransactionPicker::PickTransactionsParameters parameters{};
-  staking::TransactionPicker::PickTransactionsResult result =
-      transaction_picker.PickTransactions(parameters);
-
-  if (!result) {
-    LogPrint(BCLog::PROPOSING, "Failed to pick transactions (wallet=%s, error=%s) – proposing empty block.\n", wallet_name, result.error);
+  const boost::optional<EligibleCoin> winning_ticket = logic.TryPropose(coins, *tip);
+  if (!winning_ticket) {
+    LogPrint(BCLog::PROPOSING, "Not proposing this time (wallet=%s)\n", wallet.GetName());
+    return nullptr;
   }
-  const CAmount fees = std::accumulate(result.fees.begin(), result.fees.end(), CAmount(0));
-  const uint256 snapshot_hash = active_chain.ComputeSnapshotHash();
-
-  return block_builder.BuildBlock(
-      *active_chain.GetTip(), snapshot_hash, coin, coins, result.transactions, fees, coinbase_script, wallet);
+  BlockCandidate candidate;
+  PrepareCandidate(active_chain, transaction_picker, candidate);
+  return AssembleBlock(block_builder, wallet, candidate, winning_ticket.get(), coins, coinbase_script);
 }
 
 }  // namespace
@@ -102,6 +148,7 @@ class PassiveProposerImpl : public Proposer {
 class ActiveProposerImpl : public Proposer {
  private:
   static constexpr const char *THREAD_NAME = "unite-proposer";
+  static constexpr const char *SEARCH_THREAD_NAME = "unite-propsrch";
 
   const Dependency<staking::ActiveChain> m_active_chain;
   const Dependency<staking::TransactionPicker> m_transaction_picker;
@@ -122,9 +169,65 @@ class ActiveProposerImpl : public Proposer {
   std::atomic_bool m_interrupted;
   Waiter m_waiter;
 
+  //! Only accessed from the proposer thread (not the search workers), with
+  //! the chain lock held.
+  BlockCandidate m_candidate;
+
+  //! Whether any wallet had stakeable coins in the last round. Only accessed
+  //! from the proposer thread.
+  bool m_found_stakeable_coins = false;
+
+  //! The outcome of searching a single wallet for an eligible coin.
+  struct SearchResult {
+    staking::CoinSet coins;
+    boost::optional<EligibleCoin> winning_ticket;
+  };
+
+  //! \brief Searches a single wallet, a job of m_search_queue.
+  class WalletSearch {
+   public:
+    WalletSearch() = default;
+    WalletSearch(ActiveProposerImpl &proposer, CWallet &wallet, const CBlockIndex &tip, SearchResult &result)
+        : m_proposer(&proposer), m_wallet(&wallet), m_tip(&tip), m_result(&result) {}
+
+    bool operator()() {
+      m_proposer->SearchWallet(*m_wallet, *m_tip, *m_result);
+      return true;
+    }
+
+    void swap(WalletSearch &other) {
+      std::swap(m_proposer, other.m_proposer);
+      std::swap(m_wallet, other.m_wallet);
+      std::swap(m_tip, other.m_tip);
+      std::swap(m_result, other.m_result);
+    }
+
+   private:
+    ActiveProposerImpl *m_proposer = nullptr;
+    CWallet *m_wallet = nullptr;
+    const CBlockIndex *m_tip = nullptr;
+    SearchResult *m_result = nullptr;
+  };
+
+  //! Wallets are searched by the proposer thread together with these workers,
+  //! which are started once with the proposer.
+  CCheckQueue<WalletSearch> m_search_queue{1};
+  boost::thread_group m_search_workers;
+
+  void RefreshCandidate() {
+    AssertLockHeld(m_active_chain->GetLock());
+    if (m_candidate.tip == m_active_chain->GetTip() &&
+        m_candidate.transactions_updated == m_transaction_picker->GetTransactionsUpdated()) {
+      return;
+    }
+    PrepareCandidate(*m_active_chain, *m_transaction_picker, m_candidate);
+  }
+
   void SetStatusOfAllWallets(const Status &status) {
     for (const auto &wallet : m_multi_wallet->GetWallets()) {
-      wallet->GetWalletExtension().GetProposerState().m_status = status;
+      esperanza::WalletExtension &wallet_ext = wallet->GetWalletExtension();
+      LOCK(wallet_ext.GetLock());
+      wallet_ext.GetProposerState().m_status = status;
     }
   }
 
@@ -137,6 +240,72 @@ class ActiveProposerImpl : public Proposer {
     return !m_interrupted;
   }
 
+  //! Runs on the proposer thread or a search worker. The proposer state of
+  //! the wallet is only written with the wallet lock held.
+  void SearchWallet(CWallet &wallet, const CBlockIndex &tip, SearchResult &result) {
+    if (m_interrupted) {
+      return;
+    }
+    esperanza::WalletExtension &wallet_ext = wallet.GetWalletExtension();
+    State &state = wallet_ext.GetProposerState();
+    const std::string wallet_name = wallet.GetName();
+    if (wallet.IsLocked()) {
+      LogPrint(BCLog::PROPOSING, "Not proposing, wallet locked (wallet=%s)\n", wallet_name);
+      LOCK(wallet_ext.GetLock());
+      state.m_status = Status::NOT_PROPOSING_WALLET_LOCKED;
+      return;
+    }
+    const auto search_start = std::chrono::steady_clock::now();
+    // To pick up to date coins for staking we need to make sure that the wallet is synced to the current chain.
+    wallet.BlockUntilSyncedToCurrentChain();
+    {
+      LOCK2(m_active_chain->GetLock(), wallet_ext.GetLock());
+      if (m_active_chain->GetTip() != &tip) {
+        LogPrint(BCLog::PROPOSING, "Not proposing, the tip changed before the search (wallet=%s)\n", wallet_name);
+        return;
+      }
+      result.coins = wallet_ext.GetStakeableCoins();
+      if (result.coins.empty()) {
+        LogPrint(BCLog::PROPOSING, "Not proposing, not enough balance (wallet=%s)\n", wallet_name);
+        state.m_status = Status::NOT_PROPOSING_NOT_ENOUGH_BALANCE;
+        return;
+      }
+      state.m_status = Status::IS_PROPOSING;
+      state.m_number_of_search_attempts += 1;
+    }
+
+    // The kernel search doesn't hold the chain lock, so that blocks can
+    // be connected while a large wallet is searched. It only returns a coin
+    // if the tip was still the one the coins were picked for.
+    const boost::optional<EligibleCoin> winning_ticket = m_proposer_logic->TryPropose(result.coins, tip);
+    if (winning_ticket) {
+      result.winning_ticket.emplace(winning_ticket.get());
+    } else {
+      LogPrint(BCLog::PROPOSING, "Not proposing this time (wallet=%s)\n", wallet_name);
+    }
+    const std::int64_t duration_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                                         std::chrono::steady_clock::now() - search_start)
+                                         .count();
+    LOCK(wallet_ext.GetLock());
+    state.m_number_of_searches += 1;
+    state.m_last_search_duration_us = duration_us;
+  }
+
+  //! Searches all wallets concurrently on m_search_queue. The calling thread
+  //! takes part in the search and returns once all wallets are searched.
+  void SearchWallets(const std::vector<std::shared_ptr<CWallet>> &wallets,
+                     const CBlockIndex &tip,
+                     std::vector<SearchResult> &results) {
+    std::vector<WalletSearch> searches;
+    searches.reserve(wallets.size());
+    for (size_t i = 0; i < wallets.size(); ++i) {
+      searches.emplace_back(*this, *wallets[i], tip, results[i]);
+    }
+    CCheckQueueControl<WalletSearch> control(&m_search_queue);
+    control.Add(searches);
+    control.Wait();
+  }
+
   void Run() {
     RenameThread(THREAD_NAME);
     LogPrint(BCLog::PROPOSING, "Proposer thread started.\n");
@@ -151,55 +320,89 @@ class ActiveProposerImpl : public Proposer {
         SetStatusOfAllWallets(Status::NOT_PROPOSING_SYNCING_BLOCKCHAIN);
         continue;
       }
-      for (const std::shared_ptr<CWallet> &wallet : m_multi_wallet->GetWallets()) {
-        esperanza::WalletExtension &wallet_ext = wallet->GetWalletExtension();
-        const std::string wallet_name = wallet->GetName();
-        if (wallet->IsLocked()) {
-          LogPrint(BCLog::PROPOSING, "Not proposing, wallet locked (wallet=%s)\n", wallet_name);
-          wallet_ext.GetProposerState().m_status = Status::NOT_PROPOSING_WALLET_LOCKED;
-          continue;
-        }
-        if (m_interrupted) {
-          break;
-        }
-        std::shared_ptr<const CBlock> block;
-        {
-          // To pick up to date coins for staking we need to make sure that the wallet is synced to the current chain.
-          wallet->BlockUntilSyncedToCurrentChain();
-          LOCK2(m_active_chain->GetLock(), wallet_ext.GetLock());
-          const staking::CoinSet coins = wallet_ext.GetStakeableCoins();
-          if (coins.empty()) {
-            LogPrint(BCLog::PROPOSING, "Not proposing, not enough balance (wallet=%s)\n", wallet_name);
-            wallet_ext.GetProposerState().m_status = Status::NOT_PROPOSING_NOT_ENOUGH_BALANCE;
-            continue;
-          }
-          wallet_ext.GetProposerState().m_status = Status::IS_PROPOSING;
-          wallet_ext.GetProposerState().m_number_of_search_attempts += 1;
-          block = proposer::GenerateBlock(*m_active_chain,
-                                          *m_transaction_picker,
-                                          *m_block_builder,
-                                          *m_proposer_logic,
-                                          wallet_ext,
-                                          coins,
-                                          boost::none /* coinbase_script */);
+      const std::vector<std::shared_ptr<CWallet>> wallets = m_multi_wallet->GetWallets();
+      if (wallets.empty()) {
+        continue;
+      }
+      // All wallets are searched against the same tip. The block body is
+      // prepared for it ahead of the search only if some wallet could stake
+      // in the last round, otherwise it's prepared once a wallet wins. This
+      // is a no-op unless the tip or the mempool changed.
+      const CBlockIndex *tip = nullptr;
+      bool candidate_prepared = false;
+      {
+        LOCK(m_active_chain->GetLock());
+        tip = m_active_chain->GetTip();
+        if (tip && m_found_stakeable_coins) {
+          RefreshCandidate();
+          candidate_prepared = true;
         }
-        wallet_ext.GetProposerState().m_number_of_searches += 1;
-        if (m_interrupted) {
-          break;
+      }
+      if (!tip) {
+        continue;
+      }
+      std::vector<SearchResult> results(wallets.size());
+      SearchWallets(wallets, *tip, results);
+      if (m_interrupted) {
+        break;
+      }
+      m_found_stakeable_coins = std::any_of(results.begin(), results.end(), [](const SearchResult &result) {
+        return !result.coins.empty();
+      });
+
+      // Only one block can be proposed on top of the tip. If several wallets
+      // found an eligible coin the one with the lowest kernel hash proposes.
+      size_t winner = wallets.size();
+      for (size_t i = 0; i < results.size(); ++i) {
+        if (results[i].winning_ticket &&
+            (winner == wallets.size() ||
+             results[i].winning_ticket->kernel_hash < results[winner].winning_ticket->kernel_hash)) {
+          winner = i;
         }
-        if (!block) {
-          LogPrint(BCLog::PROPOSING, "Failed to assemble block.\n");
+      }
+      if (winner == wallets.size()) {
+        continue;
+      }
+      esperanza::WalletExtension &wallet_ext = wallets[winner]->GetWalletExtension();
+      const std::string &wallet_name = wallets[winner]->GetName();
+      std::shared_ptr<const CBlock> block;
+      {
+        // The winning coin is only valid on the tip its coins were picked for.
+        LOCK(m_active_chain->GetLock());
+        if (m_active_chain->GetTip() != tip) {
+          LogPrint(BCLog::PROPOSING, "Not proposing, the tip changed during the search (wallet=%s)\n", wallet_name);
           continue;
         }
-        const std::string hash = block->GetHash().GetHex();
-        if (!m_active_chain->ProposeBlock(block)) {
-          LogPrint(BCLog::PROPOSING, "Failed to propose block (hash=%s).\n", hash);
-          continue;
+        // A candidate prepared before the search is used as is, even if the
+        // mempool changed in the meantime. Rebuilding it here would put
+        // picking the transactions back between the win and the proposal.
+        if (!candidate_prepared || m_candidate.tip != tip) {
+          PrepareCandidate(*m_active_chain, *m_transaction_picker, m_candidate);
         }
+        assert(m_candidate.tip == tip);
+        LOCK(wallet_ext.GetLock());
+        block = proposer::AssembleBlock(*m_block_builder,
+                                        wallet_ext,
+                                        m_candidate,
+                                        results[winner].winning_ticket.get(),
+                                        results[winner].coins,
+                                        boost::none /* coinbase_script */);
+      }
+      if (!block) {
+        LogPrint(BCLog::PROPOSING, "Failed to assemble block.\n");
+        continue;
+      }
+      const std::string hash = block->GetHash().GetHex();
+      if (!m_active_chain->ProposeBlock(block)) {
+        LogPrint(BCLog::PROPOSING, "Failed to propose block (hash=%s).\n", hash);
+        continue;
+      }
+      {
+        LOCK(wallet_ext.GetLock());
         wallet_ext.GetProposerState().m_number_of_proposed_blocks += 1;
         wallet_ext.GetProposerState().m_number_of_transactions_included += block->vtx.size();
-        LogPrint(BCLog::PROPOSING, "Proposed new block (hash=%s).\n", hash);
       }
+      LogPrint(BCLog::PROPOSING, "Proposed new block (hash=%s, wallet=%s).\n", hash, wallet_name);
     } while (Wait());
     LogPrint(BCLog::PROPOSING, "Proposer thread stopping...\n");
   }
@@ -239,6 +442,14 @@ class ActiveProposerImpl : public Proposer {
       LogPrint(BCLog::PROPOSING, "Proposer already started, not starting again.\n");
       return;
     }
+    // The proposer thread searches too, so one worker less than cores.
+    const int num_search_workers = std::max(GetNumCores(), 1) - 1;
+    for (int i = 0; i < num_search_workers; ++i) {
+      m_search_workers.create_thread([this] {
+        RenameThread(SEARCH_THREAD_NAME);
+        m_search_queue.Thread();
+      });
+    }
     m_thread = std::thread(&ActiveProposerImpl::Run, this);
     m_state = STARTED;
   }
@@ -252,6 +463,9 @@ class ActiveProposerImpl : public Proposer {
     m_interrupted = true;
     Wake();
     m_thread.join();
+    // Idle workers wait on the queue, which is an interruption point.
+    m_search_workers.interrupt_all();
+    m_search_workers.join_all();
     m_state = STOPPED;
     LogPrint(BCLog::PROPOSING, "Proposer stopped.\n");
   }
@@ -4,11 +4,15 @@
 
 #include <proposer/proposer_logic.h>
 
+#include <vector>
+
 namespace proposer {
 
 class LogicImpl final : public Logic {
 
  private:
+  static constexpr std::size_t KERNEL_BATCH_SIZE = 64;
+
   const Dependency<blockchain::Behavior> m_blockchain_behavior;
   const Dependency<staking::Network> m_network;
   const Dependency<staking::ActiveChain> m_active_chain;
@@ -41,44 +45,65 @@ class LogicImpl final : public Logic {
   //
   // The part of actually proposing (`propose(block)`) is left up to the caller
   // of this function (the `Proposer`, see proposer.cpp).
-  boost::optional<proposer::EligibleCoin> TryPropose(const staking::CoinSet &eligible_coins) override {
-    AssertLockHeld(m_active_chain->GetLock());
+  //
+  // The active chain lock is only taken to check the tip, the kernel search
+  // itself runs without it.
+  boost::optional<proposer::EligibleCoin> TryPropose(const staking::CoinSet &eligible_coins,
+                                                     const CBlockIndex &tip) override {
+    const CBlockIndex *const current_tip = &tip;
+    blockchain::Height target_height;
+    blockchain::Time target_time;
+    blockchain::Difficulty target_difficulty;
+    {
+      LOCK(m_active_chain->GetLock());
+
+      if (m_active_chain->GetTip() != current_tip) {
+        LogPrint(BCLog::PROPOSING, "Not searching for a kernel, the tip changed\n");
+        return boost::none;
+      }
+
+      const blockchain::Height current_height =
+          m_active_chain->GetHeight();
+      target_height = current_height + 1;
 
-    const CBlockIndex *current_tip =
-        m_active_chain->GetTip();
-    if (!current_tip) {
-      return boost::none;
+      const int64_t best_time = std::max(current_tip->GetMedianTimePast() + 1, m_network->GetTime());
+      target_time = m_blockchain_behavior->CalculateProposingTimestampAfter(best_time);
+      target_difficulty = m_blockchain_behavior->CalculateDifficulty(target_height, *m_active_chain);
     }
 
-    const blockchain::Height current_height =
-        m_active_chain->GetHeight();
-    const blockchain::Height target_height =
-        current_height + 1;
-
-    const int64_t best_time = std::max(current_tip->GetMedianTimePast() + 1, m_network->GetTime());
-    const blockchain::Time target_time =
-        m_blockchain_behavior->CalculateProposingTimestampAfter(best_time);
-    const blockchain::Difficulty target_difficulty =
-        m_blockchain_behavior->CalculateDifficulty(target_height, *m_active_chain);
-
-    for (const staking::Coin &coin : eligible_coins) {
-      const uint256 kernel_hash = m_stake_validator->ComputeKernelHash(current_tip, coin, target_time);
-
-      if (!m_stake_validator->CheckKernel(coin.GetAmount(), kernel_hash, target_difficulty)) {
-        if (m_blockchain_behavior->GetParameters().mine_blocks_on_demand) {
-          LogPrint(BCLog::PROPOSING, "Letting artificial block generation succeed nevertheless (mine_blocks_on_demand=true)\n");
-        } else {
-          continue;
-        }
+    // Kernels are computed in small batches so that the search still stops
+    // early when one of the first (largest) coins wins.
+    std::vector<const staking::Coin *> batch;
+    batch.reserve(KERNEL_BATCH_SIZE);
+    auto next_coin = eligible_coins.begin();
+    while (next_coin != eligible_coins.end()) {
+      batch.clear();
+      for (; next_coin != eligible_coins.end() && batch.size() < KERNEL_BATCH_SIZE; ++next_coin) {
+        batch.emplace_back(&*next_coin);
       }
+      const std::vector<uint256> kernel_hashes =
+          m_stake_validator->ComputeKernelHashes(current_tip, batch, target_time);
+
+      for (std::size_t i = 0; i < batch.size(); ++i) {
+        const staking::Coin &coin = *batch[i];
+        const uint256 &kernel_hash = kernel_hashes[i];
 
-      const CAmount reward = m_blockchain_behavior->CalculateBlockReward(target_height);
-      return {{coin,
-               kernel_hash,
-               reward,
-               target_height,
-               target_time,
-               target_difficulty}};
+        if (!m_stake_validator->CheckKernel(coin.GetAmount(), kernel_hash, target_difficulty)) {
+          if (m_blockchain_behavior->GetParameters().mine_blocks_on_demand) {
+            LogPrint(BCLog::PROPOSING, "Letting artificial block generation succeed nevertheless (mine_blocks_on_demand=true)\n");
+          } else {
+            continue;
+          }
+        }
+
+        const CAmount reward = m_blockchain_behavior->CalculateBlockReward(target_height);
+        return {{coin,
+                 kernel_hash,
+                 reward,
+                 target_height,
+                 target_time,
+                 target_difficulty}};
+      }
     }
     return boost::none;
   }
@@ -30,7 +30,13 @@ class Logic {
   //!
   //! The actual proposer component can then proceed and assemble a block and
   //! broadcast it into the network.
-  virtual boost::optional<proposer::EligibleCoin> TryPropose(const staking::CoinSet &) = 0;
+  //!
+  //! The search is done on top of `tip`, which the caller read along with the
+  //! coins. If `tip` is no longer the tip of the active chain no coin is
+  //! returned. The active chain lock is only taken to check the tip, so a
+  //! caller that doesn't hold the lock itself must check that the tip is
+  //! still the same before building a block with the returned coin.
+  virtual boost::optional<proposer::EligibleCoin> TryPropose(const staking::CoinSet &, const CBlockIndex &tip) = 0;
 
   virtual ~Logic() = default;
 
@@ -45,12 +45,13 @@ class ProposerRPCImpl : public ProposerRPC {
         LOCK(wallet_extension.GetLock());
         info.pushKV("balance", ValueFromAmount(wallet->GetBalance()));
         info.pushKV("stakeable_balance", ValueFromAmount(wallet_extension.GetStakeableBalance()));
+        info.pushKV("status", UniValue(proposerState.m_status._to_string()));
+        info.pushKV("searches", UniValue(proposerState.m_number_of_searches));
+        info.pushKV("searches_attempted", UniValue(proposerState.m_number_of_search_attempts));
+        info.pushKV("blocks_proposed", UniValue(proposerState.m_number_of_proposed_blocks));
+        info.pushKV("transactions_included", UniValue(proposerState.m_number_of_transactions_included));
+        info.pushKV("last_search_duration_us", UniValue(proposerState.m_last_search_duration_us));
       }
-      info.pushKV("status", UniValue(proposerState.m_status._to_string()));
-      info.pushKV("searches", UniValue(proposerState.m_number_of_searches));
-      info.pushKV("searches_attempted", UniValue(proposerState.m_number_of_search_attempts));
-      info.pushKV("blocks_proposed", UniValue(proposerState.m_number_of_proposed_blocks));
-      info.pushKV("transactions_included", UniValue(proposerState.m_number_of_transactions_included));
       result.push_back(info);
     }
     return result;
@@ -12,6 +12,9 @@
 namespace proposer {
 
 //! bookkeeping data per wallet
+//!
+//! Wallets are searched concurrently, so the fields are only accessed with
+//! the lock of the wallet they belong to held.
 struct State {
 
   Status m_status = Status::NOT_PROPOSING;
@@ -27,6 +30,10 @@ struct State {
 
   //! \brief how many transactions the proposer included in proposed blocks in total
   std::uint64_t m_number_of_transactions_included = 0;
+
+  //! \brief how long the last search took in microseconds, including
+  //! waiting for the wallet to sync and collecting its stakeable coins
+  std::int64_t m_last_search_duration_us = 0;
 };
 
 }  // namespace proposer
@@ -480,7 +480,7 @@ bool EvalScript(std::vector<std::vector<unsigned char> >& stack, const CScript&
 
                             // Check vote signature
                             CPubKey pubkey(vchPubKey);
-                            if (!pubkey.Verify(vote.GetHash(), voteSig)) {
+                            if (!checker.CheckVoteSig(vote, voteSig, pubkey)) {
                                 return set_error(serror, SCRIPT_ERR_INVALID_VOTE_SIG);
                             }
 
@@ -570,12 +570,12 @@ bool EvalScript(std::vector<std::vector<unsigned char> >& stack, const CScript&
 
                             // Check vote1 signature
                             CPubKey pubkey(vchPubKey);
-                            if (!pubkey.Verify(vote1.GetHash(), voteSig1)) {
+                            if (!checker.CheckVoteSig(vote1, voteSig1, pubkey)) {
                                 return set_error(serror, SCRIPT_ERR_INVALID_VOTE_SIG);
                             }
 
                             // Check vote2 signature
-                            if (!pubkey.Verify(vote2.GetHash(), voteSig2)) {
+                            if (!checker.CheckVoteSig(vote2, voteSig2, pubkey)) {
                                 return set_error(serror, SCRIPT_ERR_INVALID_VOTE_SIG);
                             }
 
@@ -1479,6 +1479,17 @@ bool GenericTransactionSignatureChecker<T>::VerifySignature(const std::vector<un
     return pubkey.Verify(sighash, vchSig);
 }
 
+template <class T>
+bool GenericTransactionSignatureChecker<T>::CheckVoteSig(const esperanza::Vote& vote, const std::vector<unsigned char>& voteSig, const CPubKey& pubkey) const
+{
+    if (!pubkey.IsValid() || voteSig.empty())
+        return false;
+
+    // Goes through VerifySignature so that caching checkers can skip votes
+    // they have seen before.
+    return VerifySignature(voteSig, pubkey, vote.GetHash());
+}
+
 template <class T>
 bool GenericTransactionSignatureChecker<T>::CheckSig(const std::vector<unsigned char>& vchSigIn, const std::vector<unsigned char>& vchPubKey, const CScript& scriptCode, SigVersion sigversion) const
 {
@@ -18,6 +18,10 @@ class CScript;
 class CTransaction;
 class uint256;
 
+namespace esperanza {
+struct Vote;
+}
+
 /** Signature hash types/flags */
 enum
 {
@@ -149,6 +153,11 @@ public:
         return false;
     }
 
+    virtual bool CheckVoteSig(const esperanza::Vote& vote, const std::vector<unsigned char>& voteSig, const CPubKey& pubkey) const
+    {
+        return false;
+    }
+
     virtual bool CheckLockTime(const CScriptNum& nLockTime) const
     {
          return false;
@@ -182,6 +191,7 @@ public:
     GenericTransactionSignatureChecker(const T* txToIn, unsigned int nInIn, const CAmount& amountIn) : txTo(txToIn), nIn(nInIn), amount(amountIn), txdata(nullptr) {}
     GenericTransactionSignatureChecker(const T* txToIn, unsigned int nInIn, const CAmount& amountIn, const PrecomputedTransactionData& txdataIn) : txTo(txToIn), nIn(nInIn), amount(amountIn), txdata(&txdataIn) {}
     bool CheckSig(const std::vector<unsigned char>& scriptSig, const std::vector<unsigned char>& vchPubKey, const CScript& scriptCode, SigVersion sigversion) const override;
+    bool CheckVoteSig(const esperanza::Vote& vote, const std::vector<unsigned char>& voteSig, const CPubKey& pubkey) const override;
     bool CheckLockTime(const CScriptNum& nLockTime) const override;
     bool CheckSequence(const CScriptNum& nSequence) const override;
     TxType GetTxType() const override;
@@ -11,6 +11,9 @@
 #include <uint256.h>
 #include <util.h>
 
+#include <esperanza/vote.h>
+#include <script/sign.h>
+
 #include <cuckoocache.h>
 #include <boost/thread.hpp>
 
@@ -92,3 +95,32 @@ bool CachingTransactionSignatureChecker::VerifySignature(const std::vector<unsig
         signatureCache.Set(entry);
     return true;
 }
+
+bool CachingTransactionSignatureChecker::CheckVoteSig(const esperanza::Vote& vote, const std::vector<unsigned char>& voteSig, const CPubKey& pubkey) const
+{
+    return CachingCheckVoteSignature(pubkey, vote, voteSig, storeVote);
+}
+
+bool CachingCheckVoteSignature(const CPubKey& pubkey, const esperanza::Vote& vote, const std::vector<unsigned char>& vote_sig, const bool store)
+{
+    if (vote_sig.empty() || !pubkey.IsValid())
+        return false;
+    // Entries are keyed by the vote hash, a valid vote signature is a valid
+    // signature of that hash and can share the cache with script signatures.
+    uint256 entry;
+    signatureCache.ComputeEntry(entry, vote.GetHash(), vote_sig, pubkey);
+    if (signatureCache.Get(entry, !store))
+        return true;
+    if (!CheckVoteSignature(pubkey, vote, vote_sig))
+        return false;
+    if (store)
+        signatureCache.Set(entry);
+    return true;
+}
+
+bool IsSignatureCached(const uint256& hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey)
+{
+    uint256 entry;
+    signatureCache.ComputeEntry(entry, hash, vchSig, pubkey);
+    return signatureCache.Get(entry, false);
+}
@@ -19,6 +19,10 @@ static const int64_t MAX_MAX_SIG_CACHE_SIZE = 16384;
 
 class CPubKey;
 
+namespace esperanza {
+struct Vote;
+}
+
 /**
  * We're hashing a nonce into the entries themselves, so we don't need extra
  * blinding in the set hash computation.
@@ -44,13 +48,31 @@ class CachingTransactionSignatureChecker : public TransactionSignatureChecker
 {
 private:
     bool store;
+    //! Whether vote signatures are stored, which can differ from store, see CScriptCheck
+    bool storeVote;
 
 public:
-    CachingTransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, const CAmount& amountIn, bool storeIn, PrecomputedTransactionData& txdataIn) : TransactionSignatureChecker(txToIn, nInIn, amountIn, txdataIn), store(storeIn) {}
+    CachingTransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, const CAmount& amountIn, bool storeIn, PrecomputedTransactionData& txdataIn) : TransactionSignatureChecker(txToIn, nInIn, amountIn, txdataIn), store(storeIn), storeVote(storeIn) {}
+    CachingTransactionSignatureChecker(const CTransaction* txToIn, unsigned int nInIn, const CAmount& amountIn, bool storeIn, bool storeVoteIn, PrecomputedTransactionData& txdataIn) : TransactionSignatureChecker(txToIn, nInIn, amountIn, txdataIn), store(storeIn), storeVote(storeVoteIn) {}
 
     bool VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& vchPubKey, const uint256& sighash) const override;
+    bool CheckVoteSig(const esperanza::Vote& vote, const std::vector<unsigned char>& voteSig, const CPubKey& pubkey) const override;
 };
 
 void InitSignatureCache();
 
+/**
+ * Checks the signature of a finalizer vote using CheckVoteSignature, but
+ * consults the signature cache first. Like for CachingTransactionSignatureChecker,
+ * valid signatures are only added to the cache if store is set, and a cache
+ * entry found without store is erased.
+ */
+bool CachingCheckVoteSignature(const CPubKey& pubkey, const esperanza::Vote& vote, const std::vector<unsigned char>& vote_sig, bool store);
+
+/**
+ * Whether the signature cache holds the valid signature vchSig of hash by
+ * pubkey. Unlike a lookup by the checkers the entry is never erased.
+ */
+bool IsSignatureCached(const uint256& hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey);
+
 #endif // UNITE_SCRIPT_SIGCACHE_H
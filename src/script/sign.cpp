@@ -598,7 +598,7 @@ bool CreateVoteSignature(CKeyStore *keystore, const esperanza::Vote &vote,
 }
 
 bool CheckVoteSignature(const CPubKey &pubkey, const esperanza::Vote &vote,
-                          std::vector<unsigned char> &vote_sig) {
+                          const std::vector<unsigned char> &vote_sig) {
   return pubkey.Verify(vote.GetHash(), vote_sig);
 }
 
@@ -745,6 +745,6 @@ bool CreateVoteSignature(CKeyStore *keystore, const esperanza::Vote &vote,
 //! \param[in] vote_sig the vote signature
 //! \return true if the signature matches, false otherwise
 bool CheckVoteSignature(const CPubKey &pubkey, const esperanza::Vote &vote,
-                           std::vector<unsigned char> &vote_sig);
+                           const std::vector<unsigned char> &vote_sig);
 
 #endif // UNITE_SCRIPT_SIGN_H
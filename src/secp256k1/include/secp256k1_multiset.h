@@ -70,6 +70,31 @@ SECP256K1_API int secp256k1_multiset_remove(
 ) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2) SECP256K1_ARG_NONNULL(3);
 
 
+/** Adds and removes many data elements at once
+ *
+ *  The result is the same as calling secp256k1_multiset_add or
+ *  secp256k1_multiset_remove for every element in order, but the multiset
+ *  is only decoded and encoded once for the whole batch.
+ *
+ *  Returns: 1: success
+ *           0: invalid parameter
+ *  Args:    ctx:          pointer to a context object (cannot be NULL)
+ *  In/Out:  multiset:     the multiset to update
+ *  In:      inputs:       pointers to the n data elements
+ *           input_lens:   the sizes of the n data elements
+ *           remove_flags: per element, non-zero to remove it instead of
+ *                         adding it. NULL adds all elements
+ *           n:            the number of data elements
+ */
+SECP256K1_API int secp256k1_multiset_add_batch(
+  const secp256k1_context* ctx,
+  secp256k1_multiset *multiset,
+  const unsigned char * const *inputs,
+  const size_t *input_lens,
+  const int *remove_flags,
+  size_t n
+) SECP256K1_ARG_NONNULL(1) SECP256K1_ARG_NONNULL(2);
+
 
 /** Combines two multisets
  *
@@ -38,6 +38,40 @@ void bench_multiset(void* arg) {
     secp256k1_multiset_finalize(ctx, result, &multiset);
 }
 
+#define BATCH_SIZE 1000
+
+void bench_multiset_batch(void* arg) {
+    int it=0;
+    unsigned n,m,k;
+    unsigned char result[32];
+    static unsigned char buf[BATCH_SIZE][32*3];
+    const unsigned char *inputs[BATCH_SIZE];
+    size_t input_lens[BATCH_SIZE];
+    secp256k1_multiset multiset;
+
+    UNUSED(arg);
+    secp256k1_multiset_init(ctx, &multiset);
+
+    for (k=0; k < BATCH_SIZE; k++) {
+        inputs[k] = buf[k];
+        input_lens[k] = sizeof(buf[k]);
+    }
+
+    for (m=0; m < 300000 / BATCH_SIZE; m++)
+    {
+        for (k=0; k < BATCH_SIZE; k++) {
+            for(n = 0; n < sizeof(buf[k]); n++)
+            {
+                buf[k][n] = it++;
+            }
+        }
+
+        secp256k1_multiset_add_batch(ctx, &multiset, inputs, input_lens, NULL, BATCH_SIZE);
+    }
+
+    secp256k1_multiset_finalize(ctx, result, &multiset);
+}
+
 void bench_multiset_setup(void* arg) {
     UNUSED(arg);
 }
@@ -47,6 +81,7 @@ int main(void) {
     ctx = secp256k1_context_create(SECP256K1_CONTEXT_VERIFY);
 
     run_benchmark("multiset", bench_multiset, bench_multiset_setup, NULL, NULL, 5, 1);
+    run_benchmark("multiset_batch", bench_multiset_batch, bench_multiset_setup, NULL, NULL, 5, 1);
 
     secp256k1_context_destroy(ctx);
     return 0;
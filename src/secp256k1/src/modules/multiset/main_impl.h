@@ -126,6 +126,40 @@ int secp256k1_multiset_remove(const secp256k1_context* ctx, secp256k1_multiset *
     return multiset_add_remove(ctx, multiset, input, inputLen, 1);
 }
 
+/** Adds or removes many data elements
+ *  The accumulator stays in Jacobian coordinates between elements, it's only
+ *  normalized and encoded once at the end
+ */
+int secp256k1_multiset_add_batch(const secp256k1_context* ctx, secp256k1_multiset *multiset, const unsigned char * const *inputs, const size_t *input_lens, const int *remove_flags, size_t n) {
+    secp256k1_ge newelm;
+    secp256k1_gej acc;
+    size_t i;
+
+    VERIFY_CHECK(ctx != NULL);
+    ARG_CHECK(multiset != NULL);
+    ARG_CHECK(n == 0 || inputs != NULL);
+    ARG_CHECK(n == 0 || input_lens != NULL);
+
+    if (n == 0) {
+        return 1;
+    }
+
+    gej_from_multiset_var(&acc, multiset);
+
+    for (i = 0; i < n; i++) {
+        ARG_CHECK(inputs[i] != NULL);
+        ge_from_data_var(&newelm, inputs[i], input_lens[i], remove_flags != NULL && remove_flags[i]);
+        secp256k1_gej_add_ge_var(&acc, &acc, &newelm, NULL);
+    }
+
+    secp256k1_fe_normalize(&acc.x);
+    secp256k1_fe_normalize(&acc.y);
+    secp256k1_fe_normalize(&acc.z);
+    multiset_from_gej_var(multiset, &acc);
+
+    return 1;
+}
+
 /** Adds input multiset to multiset */
 int secp256k1_multiset_combine(const secp256k1_context* ctx, secp256k1_multiset *multiset, const secp256k1_multiset *input) {
     secp256k1_gej gej_multiset, gej_input, gej_result;
@@ -252,6 +252,55 @@ void test_empty(void) {
     CHECK_EQUAL(&empty, &r1); /* M()+M()==M() */
 }
 
+void test_batch(void) {
+
+    /* Test if a batch gives the same multiset as adding elements one by one */
+    secp256k1_multiset empty, r1, r2;
+    const unsigned char *inputs[DATACOUNT];
+    size_t input_lens[DATACOUNT];
+    int remove_flags[DATACOUNT];
+    int n;
+
+    secp256k1_multiset_init(ctx, &empty);
+    secp256k1_multiset_init(ctx, &r1);
+    secp256k1_multiset_init(ctx, &r2);
+
+    for (n = 0; n < DATACOUNT; n++) {
+        inputs[n] = elements[n];
+        input_lens[n] = DATALEN;
+        remove_flags[n] = n % 3 == 0;
+        if (remove_flags[n]) {
+            secp256k1_multiset_remove(ctx, &r1, elements[n], DATALEN);
+        } else {
+            secp256k1_multiset_add(ctx, &r1, elements[n], DATALEN);
+        }
+    }
+
+    secp256k1_multiset_add_batch(ctx, &r2, inputs, input_lens, remove_flags, DATACOUNT);
+    CHECK_EQUAL(&r1, &r2); /* M(1,2,4,..)-M(0,3,..) == batch */
+    CHECK(memcmp(r1.d, r2.d, sizeof(r1.d)) == 0);
+
+    /* empty batch leaves the multiset untouched */
+    secp256k1_multiset_add_batch(ctx, &r2, NULL, NULL, NULL, 0);
+    CHECK(memcmp(r1.d, r2.d, sizeof(r1.d)) == 0);
+
+    /* NULL remove_flags adds everything */
+    secp256k1_multiset_init(ctx, &r1);
+    secp256k1_multiset_init(ctx, &r2);
+    secp256k1_multiset_add(ctx, &r1, elements[0], DATALEN);
+    secp256k1_multiset_add(ctx, &r1, elements[1], DATALEN);
+    secp256k1_multiset_add_batch(ctx, &r2, inputs, input_lens, NULL, 2);
+    CHECK_EQUAL(&r1, &r2); /* M(0,1) == batch(0,1) */
+
+    /* a batch that cancels itself out passes through infinity */
+    remove_flags[0] = 0;
+    remove_flags[1] = 1;
+    inputs[1] = elements[0];
+    secp256k1_multiset_init(ctx, &r2);
+    secp256k1_multiset_add_batch(ctx, &r2, inputs, input_lens, remove_flags, 2);
+    CHECK_EQUAL(&r2, &empty); /* M(0)-M(0) == M() */
+}
+
 void test_testvector(void) {
     /* Tests known values from the specification */
 
@@ -320,6 +369,7 @@ void run_multiset_tests(void) {
     test_remove();
     test_empty();
     test_duplicate();
+    test_batch();
     test_testvector();
 }
 
@@ -29,7 +29,7 @@ void ChainstateIterator::Next() {
         stop = true;
       }
 
-      m_outputs[key.n] = coin.out;
+      m_outputs.emplace_back(key.n, coin.out);
       m_prev_coin = coin;
       m_prev_tx_id = key.hash;
     }
@@ -6,8 +6,8 @@
 #define UNITE_SNAPSHOT_CHAINSTATE_ITERATOR_H
 
 #include <stdint.h>
-#include <map>
 #include <memory>
+#include <vector>
 
 #include <primitives/transaction.h>
 #include <snapshot/messages.h>
@@ -22,6 +22,10 @@ class ChainstateIterator {
   bool Valid();
   void Next();
   const UTXOSubset &GetUTXOSubset() const { return m_utxo_subset; }
+
+  //! Moves the current UTXOSubset out of the iterator.
+  //! Next() must be called before accessing the subset again.
+  UTXOSubset ReleaseUTXOSubset() { return std::move(m_utxo_subset); }
   const uint256 &GetBestBlock() const { return m_cursor->GetBestBlock(); }
   const SnapshotHash &GetSnapshotHash() const {
     return m_cursor->GetSnapshotHash();
@@ -30,7 +34,7 @@ class ChainstateIterator {
  private:
   bool m_valid;
   std::unique_ptr<CCoinsViewCursor> m_cursor;
-  std::map<uint32_t, CTxOut> m_outputs;
+  std::vector<std::pair<uint32_t, CTxOut>> m_outputs;
   Coin m_prev_coin;
   uint256 m_prev_tx_id;
   UTXOSubset m_utxo_subset;
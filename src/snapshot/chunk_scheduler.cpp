@@ -0,0 +1,199 @@
+// Copyright (c) 2019 The Unit-e developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <snapshot/chunk_scheduler.h>
+
+#include <algorithm>
+#include <cassert>
+
+namespace snapshot {
+
+ChunkScheduler::ChunkScheduler(const uint256 &snapshot_hash,
+                               const uint64_t next_index,
+                               const uint64_t total_utxo_subsets)
+    : m_snapshot_hash(snapshot_hash),
+      m_total_utxo_subsets(total_utxo_subsets),
+      m_ready_index(std::min(next_index, total_utxo_subsets)),
+      m_next_index(m_ready_index) {}
+
+std::vector<ChunkScheduler::Request> ChunkScheduler::NextRequests(const NodeId node_id,
+                                                                  const time_point now) {
+  std::vector<Request> requests;
+  Peer &peer = m_peers[node_id];
+
+  while (peer.in_flight < MAX_CHUNKS_IN_FLIGHT_PER_PEER) {
+    uint64_t index;
+    Chunk *chunk = SelectChunk(node_id, now, index);
+    if (!chunk) {
+      break;
+    }
+
+    // give the peer STRAGGLER_FACTOR times longer than the chunk is expected
+    // to take according to the throughput of the peer
+    std::chrono::microseconds timeout = MIN_STRAGGLER_TIMEOUT;
+    if (peer.subsets_per_sec > 0) {
+      const double expected_sec = chunk->count / peer.subsets_per_sec;
+      timeout = std::max(timeout, std::chrono::microseconds(static_cast<int64_t>(
+                                      expected_sec * STRAGGLER_FACTOR * 1000000)));
+    }
+
+    chunk->node_id = node_id;
+    chunk->requested_at = now;
+    chunk->deadline = now + timeout;
+    ++peer.in_flight;
+
+    requests.push_back(Request{index, static_cast<uint16_t>(chunk->count)});
+  }
+
+  return requests;
+}
+
+ChunkScheduler::Chunk *ChunkScheduler::SelectChunk(const NodeId node_id, const time_point now,
+                                                   uint64_t &index_out) {
+  // chunks released by other peers go first, then the ones which are
+  // requested from another peer but weren't received in time. As the chunks
+  // are ordered, the earliest missing subsets are requested first.
+  Chunk *straggler = nullptr;
+  for (auto &entry : m_chunks) {
+    Chunk &chunk = entry.second;
+    if (chunk.received || chunk.node_id == node_id) {
+      continue;
+    }
+    if (chunk.node_id == NO_NODE) {
+      index_out = entry.first;
+      return &chunk;
+    }
+    if (!straggler && chunk.deadline < now) {
+      straggler = &chunk;
+      index_out = entry.first;
+    }
+  }
+  if (straggler) {
+    return straggler;
+  }
+
+  if (m_next_index == m_total_utxo_subsets ||
+      m_next_index - m_ready_index >= MAX_UTXO_SUBSETS_IN_FLIGHT) {
+    return nullptr;
+  }
+
+  Chunk chunk;
+  chunk.count = static_cast<uint32_t>(
+      std::min<uint64_t>(ChunkSize(node_id), m_total_utxo_subsets - m_next_index));
+
+  index_out = m_next_index;
+  m_next_index += chunk.count;
+  return &m_chunks.emplace(index_out, std::move(chunk)).first->second;
+}
+
+bool ChunkScheduler::Receive(const NodeId node_id, const uint64_t index,
+                             std::vector<UTXOSubset> &&subsets, const time_point now) {
+  const auto peer_it = m_peers.find(node_id);
+  if (peer_it != m_peers.end() && peer_it->second.in_flight > 0) {
+    --peer_it->second.in_flight;
+  }
+
+  if (subsets.empty() || index >= m_total_utxo_subsets) {
+    return false;
+  }
+
+  auto it = m_chunks.find(index);
+  if (it == m_chunks.end()) {
+    // accept the chunk which continues the requested ones
+    // as it doesn't overlap with anything
+    if (index != m_next_index) {
+      return false;
+    }
+    Chunk chunk;
+    chunk.count = static_cast<uint32_t>(
+        std::min<uint64_t>(subsets.size(), m_total_utxo_subsets - index));
+    m_next_index += chunk.count;
+    it = m_chunks.emplace(index, std::move(chunk)).first;
+  }
+
+  Chunk &chunk = it->second;
+  if (chunk.received) {
+    return false;
+  }
+
+  if (subsets.size() > chunk.count) {
+    subsets.resize(chunk.count);
+  }
+
+  if (chunk.node_id == node_id && peer_it != m_peers.end()) {
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - chunk.requested_at);
+    const double sec = std::max<int64_t>(elapsed.count(), 1000) / 1000000.0;
+    const double subsets_per_sec = subsets.size() / sec;
+
+    Peer &peer = peer_it->second;
+    if (peer.subsets_per_sec > 0) {
+      peer.subsets_per_sec = (peer.subsets_per_sec + subsets_per_sec) / 2;
+    } else {
+      peer.subsets_per_sec = subsets_per_sec;
+    }
+  }
+
+  if (subsets.size() < chunk.count) {
+    // the peer replied partially, the rest is requested again
+    Chunk rest;
+    rest.count = chunk.count - static_cast<uint32_t>(subsets.size());
+    chunk.count = static_cast<uint32_t>(subsets.size());
+    m_chunks.emplace(index + chunk.count, std::move(rest));
+  }
+
+  chunk.received = true;
+  chunk.node_id = NO_NODE;
+  chunk.subsets = std::move(subsets);
+  return true;
+}
+
+std::vector<UTXOSubset> ChunkScheduler::TakeReady() {
+  std::vector<UTXOSubset> ready;
+
+  auto it = m_chunks.begin();
+  while (it != m_chunks.end() && it->second.received) {
+    assert(it->first == m_ready_index);
+
+    std::vector<UTXOSubset> &subsets = it->second.subsets;
+    if (ready.empty()) {
+      ready = std::move(subsets);
+    } else {
+      ready.insert(ready.end(),
+                   std::make_move_iterator(subsets.begin()),
+                   std::make_move_iterator(subsets.end()));
+    }
+
+    m_ready_index += it->second.count;
+    it = m_chunks.erase(it);
+  }
+
+  return ready;
+}
+
+void ChunkScheduler::RemovePeer(const NodeId node_id) {
+  for (auto &entry : m_chunks) {
+    if (entry.second.node_id == node_id) {
+      entry.second.node_id = NO_NODE;
+    }
+  }
+  m_peers.erase(node_id);
+}
+
+size_t ChunkScheduler::InFlight(const NodeId node_id) const {
+  const auto it = m_peers.find(node_id);
+  return it != m_peers.end() ? it->second.in_flight : 0;
+}
+
+uint16_t ChunkScheduler::ChunkSize(const NodeId node_id) const {
+  const auto it = m_peers.find(node_id);
+  if (it == m_peers.end() || it->second.subsets_per_sec == 0) {
+    return INITIAL_UTXO_SET_COUNT;
+  }
+
+  const double size = it->second.subsets_per_sec * TARGET_CHUNK_DURATION.count();
+  return static_cast<uint16_t>(
+      std::max<double>(MIN_UTXO_SET_COUNT, std::min<double>(MAX_UTXO_SET_COUNT, size)));
+}
+
+}  // namespace snapshot
@@ -0,0 +1,136 @@
+// Copyright (c) 2019 The Unit-e developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef UNITE_SNAPSHOT_CHUNK_SCHEDULER_H
+#define UNITE_SNAPSHOT_CHUNK_SCHEDULER_H
+
+#include <net.h>
+#include <snapshot/messages.h>
+#include <uint256.h>
+
+#include <stdint.h>
+#include <chrono>
+#include <map>
+#include <vector>
+
+namespace snapshot {
+
+//! the biggest chunk that is requested from a peer
+constexpr uint16_t MAX_UTXO_SET_COUNT = 10000;
+
+//! the smallest chunk that is requested from a peer
+constexpr uint16_t MIN_UTXO_SET_COUNT = 100;
+
+//! the chunk size requested from the peer which throughput is not known yet
+constexpr uint16_t INITIAL_UTXO_SET_COUNT = 1000;
+
+//! how many chunks can be requested from one peer at the same time
+constexpr size_t MAX_CHUNKS_IN_FLIGHT_PER_PEER = 2;
+
+//! how many UTXO subsets can be requested ahead of the first missing one
+constexpr uint64_t MAX_UTXO_SUBSETS_IN_FLIGHT = 10 * MAX_UTXO_SET_COUNT;
+
+//! chunk sizes are adapted to be received within this duration
+constexpr std::chrono::seconds TARGET_CHUNK_DURATION{2};
+
+//! the chunk is requested from another peer if it's not received
+//! within STRAGGLER_FACTOR times of the expected duration
+constexpr int STRAGGLER_FACTOR = 4;
+
+//! the minimal time given to a peer to reply before its chunk
+//! is requested from another peer
+constexpr std::chrono::seconds MIN_STRAGGLER_TIMEOUT{5};
+
+//! \brief ChunkScheduler decides which UTXO subsets of the snapshot are
+//! requested from which peer during the initial snapshot download.
+//!
+//! Several chunks are kept in flight across all peers that have the snapshot.
+//! The chunk size is adapted to the throughput measured for every peer and the
+//! chunk which takes much longer than expected is requested again from another
+//! peer. Chunks can arrive in any order, they are kept until all preceding
+//! subsets are received so the snapshot is written sequentially. The number of
+//! requested subsets ahead of the first missing one is limited, which bounds
+//! the memory used by chunks that wait to be written.
+class ChunkScheduler {
+  using steady_clock = std::chrono::steady_clock;
+  using time_point = steady_clock::time_point;
+
+ public:
+  struct Request {
+    uint64_t index;
+    uint16_t count;
+  };
+
+  ChunkScheduler() = default;
+
+  //! \param snapshot_hash the snapshot that is downloaded
+  //! \param next_index the number of UTXO subsets which are already stored
+  //! \param total_utxo_subsets the number of UTXO subsets in the snapshot
+  ChunkScheduler(const uint256 &snapshot_hash, uint64_t next_index,
+                 uint64_t total_utxo_subsets);
+
+  const uint256 &GetSnapshotHash() const { return m_snapshot_hash; }
+
+  //! returns the chunks that should be requested from the peer now
+  std::vector<Request> NextRequests(NodeId node_id, time_point now);
+
+  //! \brief Receive keeps the received chunk until it can be written.
+  //!
+  //! Returns false if the chunk was not requested or was already received.
+  bool Receive(NodeId node_id, uint64_t index, std::vector<UTXOSubset> &&subsets,
+               time_point now);
+
+  //! moves out the received UTXO subsets which follow the ones moved before
+  std::vector<UTXOSubset> TakeReady();
+
+  //! releases chunks requested from the peer so other peers are asked for them
+  void RemovePeer(NodeId node_id);
+
+  //! returns how many chunks the peer hasn't replied to yet
+  size_t InFlight(NodeId node_id) const;
+
+  //! returns the size of the next chunk requested from the peer
+  uint16_t ChunkSize(NodeId node_id) const;
+
+  //! returns true when all UTXO subsets are moved out by TakeReady()
+  bool IsComplete() const { return m_ready_index == m_total_utxo_subsets; }
+
+ private:
+  static constexpr NodeId NO_NODE = -1;
+
+  struct Chunk {
+    uint32_t count = 0;
+    NodeId node_id = NO_NODE;  // the last peer the chunk was requested from
+    time_point requested_at;
+    time_point deadline;  // after it the chunk can be requested from another peer
+    bool received = false;
+    std::vector<UTXOSubset> subsets;
+  };
+
+  struct Peer {
+    double subsets_per_sec = 0;  // 0 until the first chunk is received
+    size_t in_flight = 0;
+  };
+
+  uint256 m_snapshot_hash;
+  uint64_t m_total_utxo_subsets = 0;
+
+  //! all UTXO subsets before this index are moved out by TakeReady()
+  uint64_t m_ready_index = 0;
+
+  //! UTXO subsets starting from this index are not part of any chunk yet
+  uint64_t m_next_index = 0;
+
+  //! chunks which cover [m_ready_index, m_next_index), key is the first index
+  std::map<uint64_t, Chunk> m_chunks;
+
+  std::map<NodeId, Peer> m_peers;
+
+  //! picks the chunk to request from the peer, nullptr if there is none
+  Chunk *SelectChunk(NodeId node_id, time_point now, uint64_t &index_out);
+};
+
+}  // namespace snapshot
+
+#endif  // UNITE_SNAPSHOT_CHUNK_SCHEDULER_H
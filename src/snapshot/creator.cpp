@@ -14,6 +14,9 @@
 #include <validation.h>
 
 #include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <queue>
 #include <thread>
 
@@ -137,6 +140,214 @@ void Creator::FinalizeSnapshots(const CBlockIndex *block_index) {
   cv.notify_one();
 }
 
+namespace {
+
+//! UTXO subsets of one index step which travel through the Pipeline together
+struct SubsetBatch {
+  std::vector<UTXOSubset> subsets;
+  CDataStream stream;           // serialized subsets
+  std::vector<uint32_t> sizes;  // serialized size of every subset
+  bool serialized = false;
+
+  SubsetBatch() : stream(SER_DISK, PROTOCOL_VERSION) {}
+};
+
+//! \brief Pipeline serializes UTXO subsets on worker threads and appends
+//! them to the indexer on a dedicated writer thread.
+//!
+//! Batches are written in the order they were pushed so the snapshot is
+//! byte-identical to the one created on a single thread. The number of batches
+//! in flight is limited to keep the memory bounded when the chainstate is read
+//! faster than the snapshot is written.
+class Pipeline {
+ public:
+  Pipeline(Indexer &indexer, const uint32_t workers)
+      : m_indexer(indexer), m_max_batches(2 * workers + 2) {
+    for (uint32_t i = 0; i < workers; ++i) {
+      m_threads.emplace_back(&Pipeline::Serialize, this);
+    }
+    m_threads.emplace_back(&Pipeline::Write, this);
+  }
+
+  ~Pipeline() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_cv.notify_all();
+    Join();
+  }
+
+  //! Blocks while too many batches are in flight.
+  //! Returns false if the pipeline stopped because of a write error.
+  bool Push(std::vector<UTXOSubset> &&subsets) {
+    std::unique_ptr<SubsetBatch> batch = MakeUnique<SubsetBatch>();
+    batch->subsets = std::move(subsets);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait(lock, [this] { return m_stop || m_batches.size() < m_max_batches; });
+    if (m_stop) {
+      return false;
+    }
+    m_to_serialize.push(batch.get());
+    m_batches.emplace_back(std::move(batch));
+    m_cv.notify_all();
+    return true;
+  }
+
+  //! Waits until all pushed batches are written.
+  bool Finish() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_done = true;
+    }
+    m_cv.notify_all();
+    Join();
+    return !m_failed;
+  }
+
+ private:
+  Indexer &m_indexer;
+  const size_t m_max_batches;
+
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::deque<std::unique_ptr<SubsetBatch>> m_batches;  // in the order of writing
+  std::queue<SubsetBatch *> m_to_serialize;
+  bool m_done = false;
+  bool m_stop = false;
+  bool m_failed = false;
+
+  std::vector<std::thread> m_threads;
+
+  void Join() {
+    for (std::thread &thread : m_threads) {
+      if (thread.joinable()) {
+        thread.join();
+      }
+    }
+  }
+
+  void Serialize() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+      m_cv.wait(lock, [this] { return m_stop || m_done || !m_to_serialize.empty(); });
+      if (m_stop || m_to_serialize.empty()) {
+        return;
+      }
+      SubsetBatch *batch = m_to_serialize.front();
+      m_to_serialize.pop();
+      lock.unlock();
+
+      batch->sizes.reserve(batch->subsets.size());
+      for (const UTXOSubset &subset : batch->subsets) {
+        const size_t size = batch->stream.size();
+        batch->stream << subset;
+        batch->sizes.push_back(static_cast<uint32_t>(batch->stream.size() - size));
+      }
+      std::vector<UTXOSubset>().swap(batch->subsets);
+
+      lock.lock();
+      batch->serialized = true;
+      m_cv.notify_all();
+    }
+  }
+
+  void Write() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+      m_cv.wait(lock, [this] {
+        return m_stop ||
+               (m_done && m_batches.empty()) ||
+               (!m_batches.empty() && m_batches.front()->serialized);
+      });
+      if (m_stop || m_batches.empty()) {
+        return;
+      }
+      std::unique_ptr<SubsetBatch> batch = std::move(m_batches.front());
+      m_batches.pop_front();
+      m_cv.notify_all();
+      lock.unlock();
+
+      bool written = true;
+      const char *data = batch->stream.data();
+      for (const uint32_t size : batch->sizes) {
+        if (!m_indexer.WriteSerializedUTXOSubset(data, size)) {
+          written = false;
+          break;
+        }
+        data += size;
+      }
+
+      lock.lock();
+      if (!written) {
+        m_failed = true;
+        m_stop = true;
+        m_cv.notify_all();
+        return;
+      }
+    }
+  }
+};
+
+}  // namespace
+
+bool Creator::WriteUTXOSubsets(Indexer &indexer, CreationInfo &info) {
+  if (m_workers == 0) {
+    while (m_iter.Valid()) {
+      boost::this_thread::interruption_point();
+
+      const UTXOSubset &subset = m_iter.GetUTXOSubset();
+      info.total_outputs += subset.outputs.size();
+
+      if (!indexer.WriteUTXOSubset(subset)) {
+        return false;
+      }
+
+      if (indexer.GetSnapshotHeader().total_utxo_subsets == m_max_utxo_subsets) {
+        break;
+      }
+
+      m_iter.Next();
+    }
+    return true;
+  }
+
+  // The cursor is read on this thread, subsets are serialized by the workers
+  // and the indexer is fed by the writer thread of the pipeline.
+  Pipeline pipeline(indexer, m_workers);
+  std::vector<UTXOSubset> batch;
+  uint64_t total_subsets = 0;
+
+  while (m_iter.Valid()) {
+    boost::this_thread::interruption_point();
+
+    batch.emplace_back(m_iter.ReleaseUTXOSubset());
+    info.total_outputs += batch.back().outputs.size();
+    ++total_subsets;
+
+    const bool last = total_subsets == m_max_utxo_subsets;
+    if (batch.size() == m_step || last) {
+      if (!pipeline.Push(std::move(batch))) {
+        return false;
+      }
+      batch.clear();
+    }
+
+    if (last) {
+      break;
+    }
+
+    m_iter.Next();
+  }
+
+  if (!batch.empty() && !pipeline.Push(std::move(batch))) {
+    return false;
+  }
+
+  return pipeline.Finish();
+}
+
 CCriticalSection cs_snapshot_creation;
 
 CreationInfo Creator::Create() {
@@ -171,22 +382,9 @@ CreationInfo Creator::Create() {
 
   Indexer indexer(snapshot_header, m_step, m_steps_per_file);
 
-  while (m_iter.Valid()) {
-    boost::this_thread::interruption_point();
-
-    UTXOSubset subset = m_iter.GetUTXOSubset();
-    info.total_outputs += subset.outputs.size();
-
-    if (!indexer.WriteUTXOSubset(subset)) {
-      info.status = Status::WRITE_ERROR;
-      return info;
-    }
-
-    if (indexer.GetSnapshotHeader().total_utxo_subsets == m_max_utxo_subsets) {
-      break;
-    }
-
-    m_iter.Next();
+  if (!WriteUTXOSubsets(indexer, info)) {
+    info.status = Status::WRITE_ERROR;
+    return info;
   }
 
   if (!indexer.Flush()) {
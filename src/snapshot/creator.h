@@ -27,6 +27,9 @@ BETTER_ENUM(
 )
 // clang-format on
 
+//! number of serialization threads used to create the snapshot
+constexpr uint32_t DEFAULT_CREATOR_WORKERS = 2;
+
 struct CreationInfo {
   Status status;
   SnapshotHeader snapshot_header;
@@ -51,6 +54,11 @@ class Creator {
   //! non 0 value is used only for testing.
   uint64_t m_max_utxo_subsets = 0;
 
+  //! threads that serialize UTXO subsets while the chainstate is read and
+  //! the snapshot files are written. 0 - everything is done on the calling
+  //! thread.
+  uint32_t m_workers = DEFAULT_CREATOR_WORKERS;
+
   //! \brief Init Initializes the instance of Creator
   //!
   //! Must be invoked before calling any other snapshot::Snapshot* functions
@@ -77,6 +85,10 @@ class Creator {
 
  private:
   ChainstateIterator m_iter;
+
+  //! Reads UTXO subsets from the chainstate and writes them to the indexer.
+  //! Returns false if the snapshot files can't be written.
+  bool WriteUTXOSubsets(Indexer &indexer, CreationInfo &info);
 };
 
 bool IsRecurrentCreation();
@@ -4,13 +4,93 @@
 
 #include <snapshot/indexer.h>
 
+#include <crypto/common.h>
 #include <crypto/sha256.h>
 #include <util.h>
 
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace snapshot {
 
 CCriticalSection cs_snapshot;
 
+//! \brief MappedFile is a read-only memory mapping of the whole file.
+//!
+//! On Windows the file is read into memory instead.
+class MappedFile {
+ public:
+  static std::shared_ptr<const MappedFile> Open(const fs::path &path);
+  ~MappedFile();
+
+  const char *Data() const { return m_data; }
+  size_t Size() const { return m_size; }
+
+ private:
+  const char *m_data = nullptr;
+  size_t m_size = 0;
+#ifdef WIN32
+  std::vector<char> m_buffer;
+#endif
+
+  MappedFile() = default;
+};
+
+std::shared_ptr<const MappedFile> MappedFile::Open(const fs::path &path) {
+  std::shared_ptr<MappedFile> file(new MappedFile());
+#ifdef WIN32
+  FILE *f = fsbridge::fopen(path, "rb");
+  if (!f) {
+    return nullptr;
+  }
+  char buf[4096];
+  size_t read;
+  while ((read = std::fread(buf, 1, sizeof(buf), f)) > 0) {
+    file->m_buffer.insert(file->m_buffer.end(), buf, buf + read);
+  }
+  const bool failed = std::ferror(f) != 0;
+  std::fclose(f);
+  if (failed) {
+    return nullptr;
+  }
+  file->m_data = file->m_buffer.data();
+  file->m_size = file->m_buffer.size();
+#else
+  const int fd = open(path.string().c_str(), O_RDONLY);
+  if (fd == -1) {
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return nullptr;
+  }
+  if (st.st_size > 0) {
+    void *addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+      close(fd);
+      return nullptr;
+    }
+    file->m_data = static_cast<const char *>(addr);
+    file->m_size = static_cast<size_t>(st.st_size);
+  }
+  close(fd);  // the mapping stays valid
+#endif
+  return file;
+}
+
+MappedFile::~MappedFile() {
+#ifndef WIN32
+  if (m_data) {
+    munmap(const_cast<char *>(m_data), m_size);
+  }
+#endif
+}
+
 std::unique_ptr<Indexer> Indexer::Open(const uint256 &snapshot_hash) EXCLUSIVE_LOCKS_REQUIRED(cs_snapshot) {
   AssertLockHeld(cs_snapshot);
 
@@ -101,6 +181,24 @@ bool Indexer::WriteUTXOSubsets(const std::vector<UTXOSubset> &list) {
 }
 
 bool Indexer::WriteUTXOSubset(const UTXOSubset &utxo_subset) {
+  if (!SwitchFile()) {
+    return false;
+  }
+  m_stream << utxo_subset;
+  AddToIndex();
+  return true;
+}
+
+bool Indexer::WriteSerializedUTXOSubset(const char *data, const size_t size) {
+  if (!SwitchFile()) {
+    return false;
+  }
+  m_stream.write(data, size);
+  AddToIndex();
+  return true;
+}
+
+bool Indexer::SwitchFile() {
   auto file_id = static_cast<uint32_t>(m_meta.snapshot_header.total_utxo_subsets /
                                        (m_meta.step * m_meta.steps_per_file));
   if (file_id > m_file_id) {
@@ -116,14 +214,16 @@ bool Indexer::WriteUTXOSubset(const UTXOSubset &utxo_subset) {
     m_file_bytes = 0;
     m_file_id = file_id;
   }
-  m_stream << utxo_subset;
+  return true;
+}
+
+void Indexer::AddToIndex() {
   uint32_t idx = m_file_msgs / m_meta.step;
   m_file_idx[idx] = static_cast<uint32_t>(m_stream.size()) + m_file_bytes;
+  m_stream_offsets.push_back(m_file_idx[idx]);
 
   ++m_meta.snapshot_header.total_utxo_subsets;
   ++m_file_msgs;
-
-  return true;
 }
 
 FILE *Indexer::GetClosestIdx(const uint64_t subset_index, uint32_t &subset_left_out,
@@ -134,35 +234,42 @@ FILE *Indexer::GetClosestIdx(const uint64_t subset_index, uint32_t &subset_left_
     return nullptr;
   }
 
-  IdxMap idx_map = m_dir_idx.at(file_id);
+  IdxMap &idx_map = m_dir_idx.at(file_id);
   uint32_t prev_count = file_id * m_meta.step * m_meta.steps_per_file;
-  auto index = static_cast<uint32_t>(subset_index - prev_count) / m_meta.step;
+  auto file_index = static_cast<uint32_t>(subset_index - prev_count);
+  auto index = file_index / m_meta.step;
 
   if (idx_map.find(index) == idx_map.end()) {
     return nullptr;
   }
 
-  subset_read_out =
-      file_id * m_meta.step * m_meta.steps_per_file + index * m_meta.step;
-
-  if (m_dir_idx.find(file_id + 1) == m_dir_idx.end()) {
-    // last file can have less messages than m_step * stepPerFile
-    auto msg_in_file =
-        static_cast<uint32_t>(m_meta.snapshot_header.total_utxo_subsets - prev_count);
-    subset_left_out = msg_in_file - index * m_meta.step;
+  // the offset table points to the exact subset, otherwise
+  // the cursor is moved to the beginning of its step
+  uint32_t offset = 0;
+  const std::shared_ptr<const MappedFile> offsets = MapOffsets(file_id);
+  if (offsets) {
+    if (file_index > 0) {
+      offset = ReadLE32(reinterpret_cast<const unsigned char *>(offsets->Data()) +
+                        (file_index - 1) * sizeof(uint32_t));
+    }
   } else {
-    subset_left_out =
-        m_meta.step * m_meta.steps_per_file - index * m_meta.step;
+    file_index = index * m_meta.step;
+    if (index > 0) {
+      offset = idx_map[index - 1];
+    }
   }
 
+  subset_read_out = prev_count + file_index;
+  subset_left_out = SubsetsInFile(file_id) - file_index;
+
   fs::path filePath = m_dir_path / FileName(file_id);
   FILE *file = fsbridge::fopen(filePath, "rb");
   if (!file) {
     return nullptr;
   }
 
-  if (index > 0) {
-    if (std::fseek(file, idx_map[index - 1], SEEK_SET) != 0) {
+  if (offset > 0) {
+    if (std::fseek(file, offset, SEEK_SET) != 0) {
       fclose(file);
       return nullptr;
     }
@@ -171,6 +278,80 @@ FILE *Indexer::GetClosestIdx(const uint64_t subset_index, uint32_t &subset_left_
   return file;
 }
 
+bool Indexer::ReadSerializedUTXOSubsets(uint64_t subset_index, const uint16_t count,
+                                        SerializedUTXOSubsets &subsets_out) {
+  subsets_out = SerializedUTXOSubsets();
+
+  const uint64_t total = m_meta.snapshot_header.total_utxo_subsets;
+  if (subset_index >= total) {
+    return false;
+  }
+
+  const uint64_t end = std::min<uint64_t>(total, subset_index + count);
+  const uint64_t subsets_per_file = m_meta.step * m_meta.steps_per_file;
+
+  while (subset_index < end) {
+    const auto file_id = static_cast<uint32_t>(subset_index / subsets_per_file);
+    const auto first = static_cast<uint32_t>(subset_index - file_id * subsets_per_file);
+    const auto last = static_cast<uint32_t>(
+        std::min<uint64_t>(SubsetsInFile(file_id), first + end - subset_index));
+
+    const std::shared_ptr<const MappedFile> offsets = MapOffsets(file_id);
+    const std::shared_ptr<const MappedFile> data = MapFile(FileName(file_id));
+    if (!offsets || !data || last <= first) {
+      return false;
+    }
+
+    const auto *table = reinterpret_cast<const unsigned char *>(offsets->Data());
+    const uint32_t begin = first > 0 ? ReadLE32(table + (first - 1) * sizeof(uint32_t)) : 0;
+    const uint32_t finish = ReadLE32(table + (last - 1) * sizeof(uint32_t));
+    if (begin > finish || finish > data->Size()) {
+      return false;
+    }
+
+    subsets_out.m_parts.push_back(SerializedUTXOSubsets::Part{data, data->Data() + begin, finish - begin});
+    subsets_out.m_count += last - first;
+    subset_index += last - first;
+  }
+
+  return true;
+}
+
+uint32_t Indexer::SubsetsInFile(const uint32_t file_id) const {
+  if (m_dir_idx.find(file_id) == m_dir_idx.end()) {
+    return 0;
+  }
+
+  const uint32_t subsets_per_file = m_meta.step * m_meta.steps_per_file;
+  if (m_dir_idx.find(file_id + 1) == m_dir_idx.end()) {
+    // last file can have less messages than m_step * stepPerFile
+    return static_cast<uint32_t>(m_meta.snapshot_header.total_utxo_subsets -
+                                 static_cast<uint64_t>(file_id) * subsets_per_file);
+  }
+  return subsets_per_file;
+}
+
+std::shared_ptr<const MappedFile> Indexer::MapFile(const std::string &file_name) {
+  auto it = m_mapped_files.find(file_name);
+  if (it == m_mapped_files.end()) {
+    std::shared_ptr<const MappedFile> file = MappedFile::Open(m_dir_path / file_name);
+    if (!file) {
+      return nullptr;
+    }
+    it = m_mapped_files.emplace(file_name, std::move(file)).first;
+  }
+  return it->second;
+}
+
+std::shared_ptr<const MappedFile> Indexer::MapOffsets(const uint32_t file_id) {
+  std::shared_ptr<const MappedFile> offsets = MapFile(OffsetsFileName(file_id));
+  if (!offsets ||
+      offsets->Size() != static_cast<size_t>(SubsetsInFile(file_id)) * sizeof(uint32_t)) {
+    return nullptr;
+  }
+  return offsets;
+}
+
 bool Indexer::Flush() {
   if (!m_stream.empty()) {
     if (!FlushFile()) {
@@ -189,6 +370,10 @@ std::string Indexer::FileName(const uint32_t file_id) {
   return "utxo" + std::to_string(file_id) + ".dat";
 }
 
+std::string Indexer::OffsetsFileName(const uint32_t file_id) {
+  return "utxo" + std::to_string(file_id) + ".idx";
+}
+
 bool Indexer::FlushFile() {
   CAutoFile file(fsbridge::fopen(m_dir_path / FileName(m_file_id), "ab"),
                  SER_DISK, CLIENT_VERSION);
@@ -200,6 +385,22 @@ bool Indexer::FlushFile() {
   file << m_stream;
   m_stream.clear();
 
+  // the offset table is written after the data, an incomplete one
+  // is ignored by the readers
+  CAutoFile offsets(fsbridge::fopen(m_dir_path / OffsetsFileName(m_file_id), "ab"),
+                    SER_DISK, CLIENT_VERSION);
+  if (offsets.IsNull()) {
+    return false;
+  }
+  for (const uint32_t offset : m_stream_offsets) {
+    offsets << offset;
+  }
+  m_stream_offsets.clear();
+
+  // the mapping doesn't include the appended data
+  m_mapped_files.erase(FileName(m_file_id));
+  m_mapped_files.erase(OffsetsFileName(m_file_id));
+
   return true;
 }
 
@@ -99,6 +99,16 @@ namespace snapshot {
 //! utxo???.dat file has an incremental suffix starting from 0.
 //! File doesn't contain the length of messages/bytes that needs to be read.
 //! This info should be taken from the index
+//!
+//! utxo???.idx is the dense offset table of utxo???.dat with the same suffix
+//! | size | type    | field  | description
+//! | 4    | uint32  | offset | bytes from the beginning of utxo???.dat
+//! |      |         |        | until the end of the UTXOSubset
+//!
+//! It has one entry for every UTXOSubset of the file, so any of them is found
+//! without reading the preceding ones. Files are memory-mapped to serve
+//! UTXO subsets without deserializing them. Snapshots which were written
+//! without (or with an incomplete) utxo???.idx are read using index.dat.
 
 constexpr uint32_t DEFAULT_INDEX_STEP = 1000;
 constexpr uint32_t DEFAULT_INDEX_STEP_PER_FILE = 100;
@@ -106,6 +116,37 @@ const char *const SNAPSHOT_FOLDER = "snapshots";
 
 extern CCriticalSection cs_snapshot;
 
+class MappedFile;
+
+//! \brief SerializedUTXOSubsets refers to UTXO subsets as they are stored
+//! in the snapshot files.
+//!
+//! Is serialized the same way as std::vector<UTXOSubset>.
+class SerializedUTXOSubsets {
+ public:
+  uint64_t Count() const { return m_count; }
+
+  template <typename Stream>
+  void Serialize(Stream &s) const {
+    WriteCompactSize(s, m_count);
+    for (const Part &part : m_parts) {
+      s.write(part.data, part.size);
+    }
+  }
+
+ private:
+  friend class Indexer;
+
+  struct Part {
+    std::shared_ptr<const MappedFile> file;  // keeps data mapped
+    const char *data;
+    size_t size;
+  };
+
+  uint64_t m_count = 0;
+  std::vector<Part> m_parts;
+};
+
 struct Meta {
   SnapshotHeader snapshot_header;
   uint32_t step = 0;
@@ -143,6 +184,12 @@ class Indexer {
   bool WriteUTXOSubsets(const std::vector<UTXOSubset> &list);
   bool WriteUTXOSubset(const UTXOSubset &utxo_subset);
 
+  //! \brief WriteSerializedUTXOSubset appends one UTXOSubset which was
+  //! already serialized with SER_DISK and PROTOCOL_VERSION.
+  //!
+  //! Allows to serialize subsets outside of the indexer, e.g. on other threads.
+  bool WriteSerializedUTXOSubset(const char *data, size_t size);
+
   //! \brief GetClosestIdx returns the file which contains the expected
   //! index and adjusts the file cursor as close as possible to the UTXOSubset.
   //!
@@ -154,6 +201,14 @@ class Indexer {
   FILE *GetClosestIdx(uint64_t subset_index, uint32_t &subset_left_out,
                       uint64_t &subset_read_out);
 
+  //! \brief ReadSerializedUTXOSubsets returns up to count UTXO subsets
+  //! starting from subset_index exactly as they are stored.
+  //!
+  //! Returns false if subset_index is out of range or the files which
+  //! contain the subsets don't have the offset table.
+  bool ReadSerializedUTXOSubsets(uint64_t subset_index, uint16_t count,
+                                 SerializedUTXOSubsets &subsets_out);
+
   //! \brief Flush flushes data in the memory to disk.
   //!
   //! Can be invoked after each write. It's automatically called when it's time
@@ -170,11 +225,30 @@ class Indexer {
   uint32_t m_file_id = 0;                // current opened file ID
   uint32_t m_file_msgs = 0;              // messages in the current opened file
   uint32_t m_file_bytes = 0;             // written bytes in the current opened file
+  std::vector<uint32_t> m_stream_offsets;  // offset table entries of m_stream
   fs::path m_dir_path;
 
+  //! key: file name
+  std::map<std::string, std::shared_ptr<const MappedFile>> m_mapped_files;
+
   explicit Indexer(const Meta &meta, std::map<uint32_t, IdxMap> &&dir_idx);
 
   std::string FileName(uint32_t file_id);
+  std::string OffsetsFileName(uint32_t file_id);
+
+  //! returns the number of UTXO subsets in the file, 0 if it doesn't exist
+  uint32_t SubsetsInFile(uint32_t file_id) const;
+
+  std::shared_ptr<const MappedFile> MapFile(const std::string &file_name);
+
+  //! returns the offset table of the file or nullptr if it's incomplete
+  std::shared_ptr<const MappedFile> MapOffsets(uint32_t file_id);
+
+  //! flushes the current file if the next UTXOSubset belongs to the new one
+  bool SwitchFile();
+
+  //! accounts the UTXOSubset which was just appended to m_stream
+  void AddToIndex();
 
   bool FlushFile();
   bool FlushIndex();
@@ -15,6 +15,14 @@
 
 namespace snapshot {
 
+namespace {
+
+//! number of UTXOs hashed at once by CalculateHash, bounds the memory held by
+//! the pending batch
+constexpr size_t HASH_BATCH_SIZE = 100000;
+
+}  // namespace
+
 Iterator::Iterator(std::unique_ptr<Indexer> indexer)
     : m_indexer(std::move(indexer)),
       m_file(nullptr),
@@ -133,16 +141,23 @@ uint256 Iterator::CalculateHash(const uint256 &stake_modifier,
   }
 
   SnapshotHash hash;
+  UTXOBatch batch;
   while (Valid()) {
     UTXOSubset subset = GetUTXOSubset();
     for (const auto &p : subset.outputs) {
       const COutPoint out(subset.tx_id, p.first);
       const Coin coin(p.second, subset.height, subset.tx_type);
-      hash.AddUTXO(UTXO(out, coin));
+      batch.AddUTXO(UTXO(out, coin));
+    }
+
+    if (batch.Size() >= HASH_BATCH_SIZE) {
+      hash.Apply(batch);
+      batch.Clear();
     }
 
     Next();
   }
+  hash.Apply(batch);
 
   return hash.GetHash(stake_modifier, chain_work);
 }
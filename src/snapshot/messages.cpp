@@ -5,10 +5,14 @@
 #include <snapshot/messages.h>
 
 #include <algorithm>
+#include <functional>
+#include <thread>
 
 #include <chain.h>
 #include <coins.h>
+#include <memusage.h>
 #include <streams.h>
+#include <util.h>
 #include <version.h>
 
 namespace snapshot {
@@ -28,6 +32,25 @@ bool InitSecp256k1Context() {
 
 void DestroySecp256k1Context() { secp256k1_context_destroy(context); }
 
+void UTXOBatch::AddUTXO(const UTXO &utxo) { Append(utxo, false); }
+
+void UTXOBatch::SubtractUTXO(const UTXO &utxo) { Append(utxo, true); }
+
+void UTXOBatch::Append(const UTXO &utxo, const bool subtract) {
+  const size_t begin = m_data.size();
+  CVectorWriter(SER_NETWORK, PROTOCOL_VERSION, m_data, begin, utxo);
+  m_entries.push_back(Entry{begin, m_data.size(), subtract});
+}
+
+void UTXOBatch::Clear() {
+  m_data.clear();
+  m_entries.clear();
+}
+
+size_t UTXOBatch::DynamicMemoryUsage() const {
+  return memusage::DynamicUsage(m_data) + memusage::DynamicUsage(m_entries);
+}
+
 SnapshotHash::SnapshotHash() { Clear(); }
 
 SnapshotHash::SnapshotHash(const std::vector<uint8_t> &data) {
@@ -53,6 +76,65 @@ void SnapshotHash::SubtractUTXO(const UTXO &utxo) {
                             stream.size());
 }
 
+namespace {
+
+//! Below this number of UTXOs per thread spawning threads costs more than
+//! the hash-to-curve work it saves
+constexpr size_t MIN_UTXOS_PER_THREAD = 256;
+
+}  // namespace
+
+void SnapshotHash::ApplyRange(secp256k1_multiset *multiset,
+                              const UTXOBatch &batch,
+                              const size_t begin, const size_t end) {
+  const size_t size = end - begin;
+  std::vector<const uint8_t *> inputs(size);
+  std::vector<size_t> input_lens(size);
+  std::vector<int> remove_flags(size);
+  for (size_t i = 0; i < size; ++i) {
+    const UTXOBatch::Entry &entry = batch.m_entries[begin + i];
+    inputs[i] = batch.m_data.data() + entry.begin;
+    input_lens[i] = entry.end - entry.begin;
+    remove_flags[i] = entry.subtract ? 1 : 0;
+  }
+
+  secp256k1_multiset_add_batch(context, multiset, inputs.data(),
+                               input_lens.data(), remove_flags.data(), size);
+}
+
+void SnapshotHash::Apply(const UTXOBatch &batch) {
+  const size_t size = batch.Size();
+  const size_t max_threads = static_cast<size_t>(std::max(GetNumCores(), 1));
+  const size_t num_parts = std::min(max_threads, size / MIN_UTXOS_PER_THREAD);
+
+  if (num_parts <= 1) {
+    ApplyRange(&m_multiset, batch, 0, size);
+    return;
+  }
+
+  std::vector<secp256k1_multiset> parts(num_parts);
+  for (secp256k1_multiset &part : parts) {
+    secp256k1_multiset_init(context, &part);
+  }
+
+  // the first part is processed on the calling thread
+  std::vector<std::thread> threads;
+  threads.reserve(num_parts - 1);
+  for (size_t i = 1; i < num_parts; ++i) {
+    threads.emplace_back(ApplyRange, &parts[i], std::cref(batch),
+                         size * i / num_parts, size * (i + 1) / num_parts);
+  }
+  ApplyRange(&parts[0], batch, 0, size / num_parts);
+
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  for (const secp256k1_multiset &part : parts) {
+    secp256k1_multiset_combine(context, &m_multiset, &part);
+  }
+}
+
 uint256 SnapshotHash::GetHash(const uint256 &stake_modifier,
                               const uint256 &chain_work) const {
   CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
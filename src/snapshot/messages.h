@@ -5,6 +5,8 @@
 #ifndef UNITE_SNAPSHOT_MESSAGES_H
 #define UNITE_SNAPSHOT_MESSAGES_H
 
+#include <cstddef>
+#include <utility>
 #include <vector>
 
 #include <primitives/transaction.h>
@@ -28,13 +30,15 @@ struct UTXOSubset {
 
   TxType tx_type = TxType::REGULAR;
 
-  //! key is the CTxOut index
-  std::map<uint32_t, CTxOut> outputs;
+  //! CTxOut index and the output. Outputs are kept in one vector instead of
+  //! a map to avoid an allocation per output, the serialized form is the same
+  //! as of std::map<uint32_t, CTxOut>.
+  std::vector<std::pair<uint32_t, CTxOut>> outputs;
 
   UTXOSubset() : tx_id(), outputs() {}
 
   UTXOSubset(const uint256 &_tx_id, const uint32_t _height, const TxType _tx_type,
-             std::map<uint32_t, CTxOut> out_map)
+             std::vector<std::pair<uint32_t, CTxOut>> out_map)
       : tx_id(_tx_id),
         height(_height),
         tx_type(_tx_type),
@@ -173,6 +177,35 @@ struct UTXO {
   }
 };
 
+//! UTXOBatch collects UTXO changes that are folded into SnapshotHash at once
+//! by SnapshotHash::Apply. Serialized UTXOs are stored back to back in a
+//! single buffer so recording a change doesn't allocate per UTXO.
+class UTXOBatch {
+ public:
+  void AddUTXO(const UTXO &utxo);
+  void SubtractUTXO(const UTXO &utxo);
+
+  bool IsEmpty() const { return m_entries.empty(); }
+  size_t Size() const { return m_entries.size(); }
+  void Clear();
+
+  size_t DynamicMemoryUsage() const;
+
+ private:
+  friend class SnapshotHash;
+
+  struct Entry {
+    size_t begin;
+    size_t end;
+    bool subtract;
+  };
+
+  std::vector<uint8_t> m_data;
+  std::vector<Entry> m_entries;
+
+  void Append(const UTXO &utxo, bool subtract);
+};
+
 class SnapshotHash {
  public:
   SnapshotHash();
@@ -181,6 +214,12 @@ class SnapshotHash {
   void AddUTXO(const UTXO &utxo);
   void SubtractUTXO(const UTXO &utxo);
 
+  //! Apply adds and subtracts all UTXOs of the batch. Large batches are
+  //! split between threads, each of them building a partial multiset which
+  //! are then combined. As the multiset is commutative, the resulting hash
+  //! is the same as if every UTXO was added one by one.
+  void Apply(const UTXOBatch &batch);
+
   //! GetHash returns the hash that represents the snapshot
   //!
   //! \param stake_modifier which points to the same height as the snapshot hash
@@ -201,6 +240,9 @@ class SnapshotHash {
 
  private:
   secp256k1_multiset m_multiset;
+
+  static void ApplyRange(secp256k1_multiset *multiset, const UTXOBatch &batch,
+                         size_t begin, size_t end);
 };
 
 //! InitSecp256k1Context creates secp256k1_context. If creation failed,
@@ -85,6 +85,23 @@ bool P2PState::ProcessGetSnapshot(CNode &node, CDataStream &data,
     return false;
   }
 
+  // serve the subsets straight from the snapshot files when possible
+  SerializedUTXOSubsets serialized;
+  if (indexer->ReadSerializedUTXOSubsets(get.utxo_subset_index, get.utxo_subset_count,
+                                         serialized)) {
+    LogPrint(BCLog::SNAPSHOT, "%s: return chunk index=%i count=%i to peer=%i\n",
+             NetMsgType::GETSNAPSHOT,
+             get.utxo_subset_index,
+             serialized.Count(),
+             node.GetId());
+
+    g_connman->PushMessage(&node, msg_maker.Make(NetMsgType::SNAPSHOT,
+                                                 indexer->GetSnapshotHeader().snapshot_hash,
+                                                 get.utxo_subset_index,
+                                                 serialized));
+    return true;
+  }
+
   Iterator iter(std::move(indexer));
   Snapshot snapshot;
   snapshot.snapshot_hash = iter.GetSnapshotHeader().snapshot_hash;
@@ -114,11 +131,61 @@ bool P2PState::SendGetSnapshot(CNode &node, GetSnapshot &msg,
            NetMsgType::GETSNAPSHOT,
            node.GetId(), msg.utxo_subset_index, msg.utxo_subset_count);
 
-  node.m_requested_snapshot_at = steady_clock::now();
   g_connman->PushMessage(&node, msg_maker.Make(NetMsgType::GETSNAPSHOT, msg));
   return true;
 }
 
+ChunkScheduler &P2PState::GetChunkScheduler() {
+  if (m_chunk_scheduler.GetSnapshotHash() != m_downloading_snapshot.snapshot_hash) {
+    // continue from the subsets which are already stored
+    uint64_t stored_utxo_subsets = 0;
+    {
+      LOCK(cs_snapshot);
+      std::unique_ptr<const Indexer> indexer = Indexer::Open(m_downloading_snapshot.snapshot_hash);
+      if (indexer) {
+        stored_utxo_subsets = indexer->GetSnapshotHeader().total_utxo_subsets;
+      }
+    }
+    m_chunk_scheduler = ChunkScheduler(m_downloading_snapshot.snapshot_hash,
+                                       stored_utxo_subsets,
+                                       m_downloading_snapshot.total_utxo_subsets);
+
+    // subsets stored in the previous session are hashed once all are received
+    m_downloading_hash.Clear();
+    m_hashed_utxo_subsets = stored_utxo_subsets > 0 ? UINT64_MAX : 0;
+  }
+  return m_chunk_scheduler;
+}
+
+void P2PState::RemoveDisconnectedPeers() {
+  std::vector<NodeId> disconnected;
+  {
+    LOCK(cs_main);
+    disconnected.swap(m_disconnected_peers);
+  }
+  for (const NodeId node_id : disconnected) {
+    m_chunk_scheduler.RemovePeer(node_id);
+  }
+}
+
+void P2PState::RequestChunks(CNode &node, const CNetMsgMaker &msg_maker) {
+  ChunkScheduler &scheduler = GetChunkScheduler();
+
+  // the peer times out if it doesn't reply to any request
+  // within snapshot_chunk_timeout_sec after it was asked
+  const auto now = steady_clock::now();
+  if (scheduler.InFlight(node.GetId()) == 0) {
+    node.m_requested_snapshot_at = now;
+  }
+
+  for (const ChunkScheduler::Request &request : scheduler.NextRequests(node.GetId(), now)) {
+    GetSnapshot msg(m_downloading_snapshot.snapshot_hash);
+    msg.utxo_subset_index = request.index;
+    msg.utxo_subset_count = request.count;
+    SendGetSnapshot(node, msg, msg_maker);
+  }
+}
+
 bool P2PState::ProcessSnapshot(CNode &node, CDataStream &data,
                                const CNetMsgMaker &msg_maker) {
   if (!IsISDEnabled()) {
@@ -164,25 +231,49 @@ bool P2PState::ProcessSnapshot(CNode &node, CDataStream &data,
 
   LOCK2(cs_main, cs_snapshot);
 
+  LogPrint(BCLog::SNAPSHOT, "%s: received index=%i len=%i from peer=%i\n",
+           NetMsgType::SNAPSHOT,
+           msg.utxo_subset_index, msg.utxo_subsets.size(), node.GetId());
+
+  ChunkScheduler &scheduler = GetChunkScheduler();
+  if (!scheduler.Receive(node.GetId(), msg.utxo_subset_index, std::move(msg.utxo_subsets),
+                         steady_clock::now())) {
+    // the chunk was already received from another peer
+    LogPrint(BCLog::SNAPSHOT, "%s: ignore unexpected chunk index=%i\n",
+             NetMsgType::SNAPSHOT, msg.utxo_subset_index);
+    RequestChunks(node, msg_maker);
+    return true;
+  }
+  node.m_requested_snapshot_at = steady_clock::now();
+
+  // chunks are written in order, the ones received ahead wait in the scheduler
+  const std::vector<UTXOSubset> utxo_subsets = scheduler.TakeReady();
+  if (utxo_subsets.empty()) {
+    RequestChunks(node, msg_maker);
+    return true;
+  }
+
   std::unique_ptr<Indexer> indexer = Indexer::Open(msg.snapshot_hash);
   if (!indexer) {
     indexer.reset(new Indexer(node.m_best_snapshot,
                               DEFAULT_INDEX_STEP, DEFAULT_INDEX_STEP_PER_FILE));
   }
 
-  if (indexer->GetSnapshotHeader().total_utxo_subsets != msg.utxo_subset_index) {
-    // ask the peer the correct index
-    GetSnapshot get(msg.snapshot_hash);
-    get.utxo_subset_index = indexer->GetSnapshotHeader().total_utxo_subsets;
-    get.utxo_subset_count = MAX_UTXO_SET_COUNT;
-    return SendGetSnapshot(node, get, msg_maker);
+  // the hash is accumulated while chunks arrive
+  // so the snapshot doesn't need to be read again once it's complete
+  if (m_hashed_utxo_subsets == indexer->GetSnapshotHeader().total_utxo_subsets) {
+    UTXOBatch batch;
+    for (const UTXOSubset &subset : utxo_subsets) {
+      for (const auto &output : subset.outputs) {
+        const COutPoint out(subset.tx_id, output.first);
+        batch.AddUTXO(UTXO(out, Coin(output.second, subset.height, subset.tx_type)));
+      }
+    }
+    m_downloading_hash.Apply(batch);
+    m_hashed_utxo_subsets += utxo_subsets.size();
   }
 
-  LogPrint(BCLog::SNAPSHOT, "%s: received index=%i len=%i\n",
-           NetMsgType::SNAPSHOT,
-           msg.utxo_subset_index, msg.utxo_subsets.size());
-
-  if (!indexer->WriteUTXOSubsets(msg.utxo_subsets)) {
+  if (!indexer->WriteUTXOSubsets(utxo_subsets)) {
     LogPrint(BCLog::SNAPSHOT, "%s: can't write message\n", NetMsgType::SNAPSHOT);
     return false;
   }
@@ -193,9 +284,19 @@ bool P2PState::ProcessSnapshot(CNode &node, CDataStream &data,
   }
 
   if (indexer->GetSnapshotHeader().total_utxo_subsets == node.m_best_snapshot.total_utxo_subsets) {
-    Iterator iterator(std::move(indexer));
-    uint256 hash = iterator.CalculateHash(node.m_best_snapshot.stake_modifier,
-                                          node.m_best_snapshot.chain_work);
+    const uint256 block_hash = indexer->GetSnapshotHeader().block_hash;
+
+    // the snapshot which download was resumed is read again to hash it
+    uint256 hash;
+    if (m_hashed_utxo_subsets == node.m_best_snapshot.total_utxo_subsets) {
+      hash = m_downloading_hash.GetHash(node.m_best_snapshot.stake_modifier,
+                                        node.m_best_snapshot.chain_work);
+    } else {
+      Iterator iterator(std::move(indexer));
+      hash = iterator.CalculateHash(node.m_best_snapshot.stake_modifier,
+                                    node.m_best_snapshot.chain_work);
+    }
+
     if (hash != msg.snapshot_hash) {
       LogPrint(BCLog::SNAPSHOT, "%s: invalid hash. has=%s got=%s\n",
                NetMsgType::SNAPSHOT,
@@ -204,12 +305,13 @@ bool P2PState::ProcessSnapshot(CNode &node, CDataStream &data,
       // restart the initial download from the beginning
       Indexer::Delete(msg.snapshot_hash);
       m_downloading_snapshot.SetNull();
+      m_chunk_scheduler = ChunkScheduler();
       node.m_best_snapshot.SetNull();
 
       return false;
     }
 
-    StoreCandidateBlockHash(iterator.GetSnapshotHeader().block_hash);
+    StoreCandidateBlockHash(block_hash);
     const CBlockIndex *const bi = LookupBlockIndex(node.m_best_snapshot.block_hash);
     assert(bi);
     AddSnapshotHash(m_downloading_snapshot.snapshot_hash, bi);
@@ -219,15 +321,17 @@ bool P2PState::ProcessSnapshot(CNode &node, CDataStream &data,
     return true;
   }
 
-  GetSnapshot get(msg.snapshot_hash);
-  get.utxo_subset_index = msg.utxo_subset_index + msg.utxo_subsets.size();
-  get.utxo_subset_count = MAX_UTXO_SET_COUNT;
-  return SendGetSnapshot(node, get, msg_maker);
+  RequestChunks(node, msg_maker);
+  return true;
 }
 
 void P2PState::StartInitialSnapshotDownload(CNode &node, const size_t node_index, const size_t total_nodes,
                                             const CNetMsgMaker &msg_maker,
                                             const CBlockIndex &last_finalized_checkpoint) {
+  // is called for every peer, so disconnected peers don't pile up
+  // even if the snapshot is not downloaded
+  RemoveDisconnectedPeers();
+
   if (!IsISDEnabled()) {
     return;
   }
@@ -279,23 +383,9 @@ void P2PState::StartInitialSnapshotDownload(CNode &node, const size_t node_index
     SetIfBestSnapshot(node_best_snapshot, last_finalized_checkpoint);
 
     // if the peer has the snapshot that node decided to download
-    // ask for the relevant chunk from it
-    if (node_best_snapshot == m_downloading_snapshot &&
-        node.m_requested_snapshot_at == time_point::min()) {
-      GetSnapshot msg;
-      msg.snapshot_hash = m_downloading_snapshot.snapshot_hash;
-      msg.utxo_subset_index = 0;
-      msg.utxo_subset_count = MAX_UTXO_SET_COUNT;
-
-      {
-        LOCK(cs_snapshot);
-        std::unique_ptr<const Indexer> indexer = Indexer::Open(node.m_best_snapshot.snapshot_hash);
-        if (indexer) {
-          msg.utxo_subset_index = indexer->GetSnapshotHeader().total_utxo_subsets;
-        }
-      }
-
-      SendGetSnapshot(node, msg, msg_maker);
+    // ask it for the chunks which aren't requested from other peers
+    if (node_best_snapshot == m_downloading_snapshot) {
+      RequestChunks(node, msg_maker);
     }
   }
 
@@ -379,7 +469,7 @@ void P2PState::ProcessSnapshotParentBlock(const CBlock &parent_block,
     snapshot_block_index->stake_modifier = idx->GetSnapshotHeader().stake_modifier;
     snapshot_block_index->nChainWork = UintToArith256(idx->GetSnapshotHeader().chain_work);
 
-    if (!pcoinsTip->ApplySnapshot(std::move(idx))) {
+    if (!pcoinsTip->ApplySnapshot(std::move(idx), nCoinCacheUsage)) {
       // if we can't write the snapshot, we have an issue with the DB
       // and most likely we can't recover.
       return regular_processing();
@@ -509,7 +599,13 @@ SnapshotHeader P2PState::NodeBestSnapshot(CNode &node, const CBlockIndex &last_f
   const auto now = steady_clock::now();
   const auto diff = now - node.m_requested_snapshot_at;
   const auto diff_sec = std::chrono::duration_cast<std::chrono::seconds>(diff);
-  if (diff_sec.count() > m_params.snapshot_chunk_timeout_sec) {
+  if (diff_sec.count() > m_params.snapshot_chunk_timeout_sec &&
+      (node.m_best_snapshot != m_downloading_snapshot ||
+       m_chunk_scheduler.InFlight(node.GetId()) > 0)) {
+    // let other peers download chunks requested from this one
+    if (node.m_best_snapshot == m_downloading_snapshot) {
+      m_chunk_scheduler.RemovePeer(node.GetId());
+    }
     node.m_best_snapshot.SetNull();
     return {};
   }
@@ -611,6 +707,11 @@ void P2PState::DeleteUnlinkedSnapshot() {
   }
 }
 
+void P2PState::FinalizeNode(const NodeId node_id) {
+  AssertLockHeld(cs_main);
+  m_disconnected_peers.emplace_back(node_id);
+}
+
 P2PState g_p2p_state;
 
 void InitP2P(const Params &params) {
@@ -659,4 +760,8 @@ void ProcessSnapshotParentBlock(const CBlock &parent_block,
   g_p2p_state.ProcessSnapshotParentBlock(parent_block, std::move(regular_processing));
 }
 
+void FinalizeNode(const NodeId node_id) {
+  g_p2p_state.FinalizeNode(node_id);
+}
+
 }  // namespace snapshot
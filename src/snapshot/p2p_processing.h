@@ -15,6 +15,7 @@
 #include <chain.h>
 #include <net.h>
 #include <netmessagemaker.h>
+#include <snapshot/chunk_scheduler.h>
 #include <snapshot/indexer.h>
 #include <snapshot/messages.h>
 #include <streams.h>
@@ -22,8 +23,6 @@
 
 namespace snapshot {
 
-constexpr uint16_t MAX_UTXO_SET_COUNT = 10000;
-
 class P2PState {
   using steady_clock = std::chrono::steady_clock;
   using time_point = steady_clock::time_point;
@@ -42,13 +41,13 @@ class P2PState {
   bool ProcessGetSnapshot(CNode &node, CDataStream &data,
                           const CNetMsgMaker &msg_maker);
 
-  //! saves the received snapshot chunk.
-  //! if it wasn't the last chunk, request the following one
+  //! saves the received snapshot chunk once all preceding ones are received.
+  //! if it wasn't the last chunk, requests more chunks from the peer
   //! if it was the last chunk, finishes snapshot downloading processed
   bool ProcessSnapshot(CNode &node, CDataStream &data,
                        const CNetMsgMaker &msg_maker);
 
-  //! requests the snapshot from the node if it has the best one
+  //! requests the snapshot chunks from the node if it has the best one
   //! can request the second best snapshot if previous one was detected broken
   void StartInitialSnapshotDownload(CNode &node, size_t node_index, size_t total_nodes,
                                     const CNetMsgMaker &msg_maker,
@@ -68,6 +67,10 @@ class P2PState {
   //! Is called when the node is stopped
   void DeleteUnlinkedSnapshot();
 
+  //! Remembers that the peer disconnected so its chunks are requested from
+  //! other peers. Is called from the network thread with cs_main held
+  void FinalizeNode(NodeId node_id);
+
  protected:
   // used to detect the timeout after which node gives up
   // and switching to IBD
@@ -87,9 +90,30 @@ class P2PState {
   // the decision of which snapshot to download shouldn't be made in this iteration
   bool m_in_flight_snapshot_discovery = false;
 
+  // distributes chunks of m_downloading_snapshot across peers
+  ChunkScheduler m_chunk_scheduler;
+
+  // peers which disconnected since the scheduler was last updated, guarded by
+  // cs_main as they are added from the network thread
+  std::vector<NodeId> m_disconnected_peers;
+
+  // multiset of the UTXOs of m_downloading_snapshot written so far. Is used
+  // only when m_hashed_utxo_subsets equals the number of stored subsets.
+  SnapshotHash m_downloading_hash;
+  uint64_t m_hashed_utxo_subsets = 0;
+
   bool SendGetSnapshot(CNode &node, GetSnapshot &msg,
                        const CNetMsgMaker &msg_maker);
 
+  //! returns the scheduler of m_downloading_snapshot
+  ChunkScheduler &GetChunkScheduler();
+
+  //! releases the chunks requested from the peers which disconnected
+  void RemoveDisconnectedPeers();
+
+  //! requests from the node the chunks which the scheduler assigns to it
+  void RequestChunks(CNode &node, const CNetMsgMaker &msg_maker);
+
   //! returns node's best_snapshot if it points to finalized epoch
   //! and downloading process hasn't timed out
   SnapshotHeader NodeBestSnapshot(CNode &node, const CBlockIndex &last_finalized_checkpoint);
@@ -130,6 +154,9 @@ bool FindNextBlocksToDownload(NodeId node_id,
 // proxy to g_p2p_state.ProcessSnapshotParentBlock
 void ProcessSnapshotParentBlock(const CBlock &parent_block,
                                 std::function<void()> regular_processing);
+
+// proxy to g_p2p_state.FinalizeNode
+void FinalizeNode(NodeId node_id);
 }  // namespace snapshot
 
 #endif  // UNITE_SNAPSHOT_P2P_PROCESSING_H
@@ -4,10 +4,14 @@
 
 #include <staking/proof_of_stake.h>
 
+#include <crypto/common.h>
+#include <hash.h>
 #include <script/script.h>
 #include <script/standard.h>
 #include <streams.h>
 
+#include <algorithm>
+
 namespace staking {
 
 std::vector<CPubKey> ExtractP2WPKHKeys(const CScriptWitness &witness) {
@@ -118,6 +122,24 @@ uint256 ComputeKernelHash(const uint256 &previous_block_stake_modifier,
   return Hash(s.begin(), s.end());
 }
 
+KernelHasher::KernelHasher(const uint256 &previous_block_stake_modifier,
+                           const blockchain::Time target_block_time) {
+  std::copy(previous_block_stake_modifier.begin(), previous_block_stake_modifier.end(), m_preimage);
+  WriteLE32(m_preimage + PREIMAGE_SIZE - 4, target_block_time);
+}
+
+uint256 KernelHasher::operator()(const blockchain::Time stake_block_time,
+                                 const uint256 &stake_txid,
+                                 const std::uint32_t stake_out_index) {
+  WriteLE32(m_preimage + 32, stake_block_time);
+  std::copy(stake_txid.begin(), stake_txid.end(), m_preimage + 36);
+  WriteLE32(m_preimage + 68, stake_out_index);
+
+  uint256 result;
+  CHash256().Write(m_preimage, PREIMAGE_SIZE).Finalize(result.begin());
+  return result;
+}
+
 uint256 ComputeStakeModifier(const uint256 &stake_transaction_hash,
                              const uint256 &previous_blocks_stake_modifier) {
 
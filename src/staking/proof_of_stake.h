@@ -9,7 +9,10 @@
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <pubkey.h>
+#include <uint256.h>
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 namespace staking {
@@ -78,6 +81,27 @@ uint256 ComputeKernelHash(const uint256 &previous_block_stake_modifier,
                           std::uint32_t stake_out_index,
                           blockchain::Time target_block_time);
 
+//! \brief Computes kernel hashes of many stakes against the same previous block and time.
+//!
+//! The result is the same as of ComputeKernelHash. The stake modifier and
+//! the target time are serialized once, only the stake specific fields are
+//! overwritten for every coin, and no stream is allocated per hash.
+class KernelHasher {
+ public:
+  KernelHasher(const uint256 &previous_block_stake_modifier,
+               blockchain::Time target_block_time);
+
+  uint256 operator()(blockchain::Time stake_block_time,
+                     const uint256 &stake_txid,
+                     std::uint32_t stake_out_index);
+
+ private:
+  //! stake modifier, stake block time, stake txid, stake out index, target time
+  static constexpr std::size_t PREIMAGE_SIZE = 32 + 4 + 32 + 4 + 4;
+
+  unsigned char m_preimage[PREIMAGE_SIZE];
+};
+
 //! \brief Computes the stake modifier which is used to make the next kernel unpredictable.
 //!
 //! The stake modifier relies on the transaction hash of the coin staked and
@@ -168,6 +168,22 @@ class StakeValidatorImpl : public StakeValidator {
         target_block_time);
   }
 
+  std::vector<uint256> ComputeKernelHashes(const CBlockIndex *previous_block,
+                                           const std::vector<const staking::Coin *> &coins,
+                                           const blockchain::Time target_block_time) const override {
+    if (!previous_block) {
+      // see ComputeKernelHash
+      return std::vector<uint256>(coins.size(), uint256::zero);
+    }
+    staking::KernelHasher hasher(previous_block->stake_modifier, target_block_time);
+    std::vector<uint256> kernel_hashes;
+    kernel_hashes.reserve(coins.size());
+    for (const staking::Coin *coin : coins) {
+      kernel_hashes.emplace_back(hasher(coin->GetBlockTime(), coin->GetTransactionId(), coin->GetOutputIndex()));
+    }
+    return kernel_hashes;
+  }
+
   bool CheckKernel(const CAmount stake_amount,
                    const uint256 &kernel_hash,
                    const blockchain::Difficulty target_difficulty) const override {
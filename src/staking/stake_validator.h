@@ -18,6 +18,7 @@
 #include <validation_flags.h>
 
 #include <memory>
+#include <vector>
 
 namespace staking {
 
@@ -47,6 +48,16 @@ class StakeValidator {
       blockchain::Time block_time      //!< [in] The time of this block
       ) const = 0;
 
+  //! \brief Computes the kernel hashes of many coins at once.
+  //!
+  //! The result is the same as calling ComputeKernelHash for each coin, in
+  //! order, but the data shared by all coins is only prepared once.
+  virtual std::vector<uint256> ComputeKernelHashes(
+      const CBlockIndex *block_index,                 //!< [in] The previous block to draw entropy from
+      const std::vector<const staking::Coin *> &coins,  //!< [in] The stakes to compute the kernels for
+      blockchain::Time block_time                     //!< [in] The time of this block
+      ) const = 0;
+
   //! \brief Computes the stake modifier for a block.
   //!
   //! The stake modifier is not stored in a block on chain, but it is used
@@ -7,6 +7,7 @@
 #include <amount.h>
 #include <miner.h>
 #include <script/script.h>
+#include <validation.h>
 
 namespace staking {
 
@@ -56,6 +57,10 @@ class BlockAssemblerAdapter final : public TransactionPicker {
     }
     return result;
   };
+
+  unsigned int GetTransactionsUpdated() const override {
+    return mempool.GetTransactionsUpdated();
+  }
 };
 
 std::unique_ptr<TransactionPicker>
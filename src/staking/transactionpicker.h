@@ -70,6 +70,13 @@ class TransactionPicker {
   virtual PickTransactionsResult PickTransactions(
       const PickTransactionsParameters &) = 0;
 
+  //! \brief a counter which changes whenever the candidate transactions change
+  //!
+  //! The result of PickTransactions stays a valid choice for as long as
+  //! neither this counter nor the active chain's tip changes, which allows
+  //! the proposer to pick transactions ahead of time.
+  virtual unsigned int GetTransactionsUpdated() const = 0;
+
   virtual ~TransactionPicker() = default;
 
   //! \brief Factory method for creating a BlockAssemblerAdapter
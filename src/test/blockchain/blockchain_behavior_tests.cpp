@@ -19,6 +19,19 @@ constexpr std::size_t size(const T (&array)[N]) noexcept {
   return N;
 }
 
+class FakeChain : public blockchain::ChainAccess {
+ public:
+  std::vector<std::unique_ptr<CBlockIndex>> blocks;
+
+  const CBlockIndex *AtDepth(const blockchain::Depth depth) const override {
+    return blocks[blocks.size() - depth].get();
+  }
+
+  const CBlockIndex *AtHeight(const blockchain::Height height) const override {
+    return blocks[height].get();
+  }
+};
+
 }  // namespace
 
 BOOST_FIXTURE_TEST_SUITE(blockchain_behavior_test, ReducedTestingSetup)
@@ -138,4 +151,44 @@ BOOST_AUTO_TEST_CASE(GetTransactionInputWeight_test) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(CalculateDifficulty_test) {
+  static int calls = 0;
+  blockchain::Parameters parameters = blockchain::Parameters::RegTest();
+  parameters.difficulty_function = [](const blockchain::Parameters &p, blockchain::Height h,
+                                      blockchain::ChainAccess &chain) -> blockchain::Difficulty {
+    ++calls;
+    return chain.AtDepth(1)->nBits + h;
+  };
+  const auto b = blockchain::Behavior::NewFromParameters(parameters);
+
+  const uint256 hash1 = uint256S("1");
+  const uint256 hash2 = uint256S("2");
+
+  FakeChain chain;
+  chain.blocks.emplace_back(MakeUnique<CBlockIndex>());
+  chain.blocks.back()->nBits = 10;
+  chain.blocks.back()->phashBlock = &hash1;
+
+  BOOST_CHECK_EQUAL(b->CalculateDifficulty(1, chain), 11);
+  BOOST_CHECK_EQUAL(b->CalculateDifficulty(1, chain), 11);
+  BOOST_CHECK_EQUAL(calls, 1);
+
+  // Another height on the same tip
+  BOOST_CHECK_EQUAL(b->CalculateDifficulty(2, chain), 12);
+  BOOST_CHECK_EQUAL(calls, 2);
+
+  // A new tip, e.g. after a reorg
+  chain.blocks.emplace_back(MakeUnique<CBlockIndex>());
+  chain.blocks.back()->nBits = 20;
+  chain.blocks.back()->phashBlock = &hash2;
+  BOOST_CHECK_EQUAL(b->CalculateDifficulty(2, chain), 22);
+  BOOST_CHECK_EQUAL(b->CalculateDifficulty(2, chain), 22);
+  BOOST_CHECK_EQUAL(calls, 3);
+
+  // Blocks without a hash are not cached
+  chain.blocks.back()->phashBlock = nullptr;
+  BOOST_CHECK_EQUAL(b->CalculateDifficulty(2, chain), 22);
+  BOOST_CHECK_EQUAL(calls, 4);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
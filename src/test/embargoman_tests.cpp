@@ -40,8 +40,9 @@ class SideEffectsMock : public p2p::EmbargoManSideEffects {
     return false;
   }
 
-  void SendTxInvToAll(const uint256 &txHash) override {
-    txs_sent_to_all.emplace(txHash);
+  void SendTxInvToAll(const std::vector<uint256> &tx_hashes) override {
+    txs_sent_to_all.insert(tx_hashes.begin(), tx_hashes.end());
+    ++inv_batches;
   }
 
   std::set<p2p::NodeId> outbounds;
@@ -49,6 +50,7 @@ class SideEffectsMock : public p2p::EmbargoManSideEffects {
   EmbargoTime next_embargo_time = 10;
   std::map<uint256, p2p::NodeId> txs_sent_to_node;
   std::set<uint256> txs_sent_to_all;
+  size_t inv_batches = 0;
 };
 
 CTransactionRef CreateNewTx() {
@@ -335,4 +337,40 @@ BOOST_AUTO_TEST_CASE(test_child_never_fluffs_before_parent) {
   BOOST_CHECK_EQUAL(1, side_effects->txs_sent_to_all.count(parent_tx.GetHash()));
 }
 
+BOOST_AUTO_TEST_CASE(test_due_embargoes_are_fluffed_together) {
+  const auto side_effects = new SideEffectsMock();
+  auto u_ptr = std::unique_ptr<p2p::EmbargoManSideEffects>(side_effects);
+
+  side_effects->outbounds = {17};
+
+  p2p::EmbargoMan instance(1000, std::move(u_ptr));
+
+  std::vector<uint256> txs;
+  for (p2p::EmbargoManSideEffects::EmbargoTime time : {30, 10, 20, 40}) {
+    const auto tx = CreateNewTx();
+    side_effects->next_embargo_time = time;
+    instance.SendTransactionAndEmbargo(*tx);
+    txs.emplace_back(tx->GetHash());
+  }
+
+  // nothing is due
+  side_effects->now = 5;
+  instance.FluffPendingEmbargoes();
+  BOOST_CHECK_EQUAL(side_effects->inv_batches, 0);
+
+  side_effects->now = 35;
+  instance.FluffPendingEmbargoes();
+  BOOST_CHECK_EQUAL(side_effects->inv_batches, 1);
+  BOOST_CHECK_EQUAL(side_effects->txs_sent_to_all.size(), 3);
+  BOOST_CHECK_EQUAL(side_effects->txs_sent_to_all.count(txs[3]), 0);
+
+  instance.FluffPendingEmbargoes();
+  BOOST_CHECK_EQUAL(side_effects->inv_batches, 1);
+
+  side_effects->now = 45;
+  instance.FluffPendingEmbargoes();
+  BOOST_CHECK_EQUAL(side_effects->inv_batches, 2);
+  BOOST_CHECK_EQUAL(side_effects->txs_sent_to_all.count(txs[3]), 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,90 @@
+// Copyright (c) 2019 The Unit-e developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <esperanza/checkpoint.h>
+#include <streams.h>
+#include <test/test_unite.h>
+#include <version.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <map>
+#include <set>
+
+BOOST_FIXTURE_TEST_SUITE(checkpoint_tests, ReducedTestingSetup)
+
+BOOST_AUTO_TEST_CASE(add_vote) {
+  esperanza::Checkpoint checkpoint;
+  const uint160 a = uint160S("aa");
+  const uint160 b = uint160S("bb");
+
+  BOOST_CHECK(!checkpoint.HasVoted(b));
+  BOOST_CHECK(checkpoint.AddVote(b));
+  BOOST_CHECK(checkpoint.AddVote(a));
+  BOOST_CHECK(!checkpoint.AddVote(b));
+  BOOST_CHECK(checkpoint.HasVoted(a));
+  BOOST_CHECK(checkpoint.HasVoted(b));
+  BOOST_CHECK_EQUAL(checkpoint.m_vote_set.size(), 2);
+  BOOST_CHECK(checkpoint.m_vote_set[0] == a);
+}
+
+BOOST_AUTO_TEST_CASE(dynasty_votes) {
+  esperanza::Checkpoint checkpoint;
+
+  BOOST_CHECK_EQUAL(checkpoint.GetCurDynastyVotes(5), 0);
+  checkpoint.GetCurDynastyVotes(5) += 10;
+  checkpoint.GetCurDynastyVotes(3) += 7;
+  checkpoint.GetCurDynastyVotes(5) += 1;
+
+  const esperanza::Checkpoint::VoteTally expected{{3, 7}, {5, 11}};
+  BOOST_CHECK(checkpoint.m_cur_dynasty_votes == expected);
+  BOOST_CHECK(checkpoint.m_prev_dynasty_votes.empty());
+}
+
+// The flat containers must serialize like the std::map and std::set which
+// were used before, finalization states are persisted in this format.
+BOOST_AUTO_TEST_CASE(serialization_is_compatible) {
+  esperanza::Checkpoint checkpoint;
+  checkpoint.m_is_justified = true;
+  checkpoint.m_cur_dynasty_deposits = 100;
+  checkpoint.m_prev_dynasty_deposits = 200;
+  checkpoint.GetCurDynastyVotes(4) = 40;
+  checkpoint.GetCurDynastyVotes(2) = 20;
+  checkpoint.GetPrevDynastyVotes(3) = 30;
+  checkpoint.AddVote(uint160S("cc"));
+  checkpoint.AddVote(uint160S("aa"));
+
+  CDataStream expected(SER_DISK, PROTOCOL_VERSION);
+  expected << true << false << uint64_t{100} << uint64_t{200};
+  expected << std::map<uint32_t, uint64_t>{{4, 40}, {2, 20}};
+  expected << std::map<uint32_t, uint64_t>{{3, 30}};
+  expected << std::set<uint160>{uint160S("cc"), uint160S("aa")};
+
+  CDataStream stream(SER_DISK, PROTOCOL_VERSION);
+  stream << checkpoint;
+  BOOST_CHECK_EQUAL(HexStr(stream), HexStr(expected));
+
+  esperanza::Checkpoint deserialized;
+  stream >> deserialized;
+  BOOST_CHECK(deserialized == checkpoint);
+}
+
+BOOST_AUTO_TEST_CASE(deserialization_restores_order) {
+  CDataStream stream(SER_DISK, PROTOCOL_VERSION);
+  stream << false << false << uint64_t{0} << uint64_t{0};
+  stream << std::vector<std::pair<uint32_t, uint64_t>>{{4, 40}, {2, 20}, {4, 41}};
+  stream << std::vector<std::pair<uint32_t, uint64_t>>{};
+  stream << std::vector<uint160>{uint160S("cc"), uint160S("aa"), uint160S("cc")};
+
+  esperanza::Checkpoint checkpoint;
+  stream >> checkpoint;
+
+  const esperanza::Checkpoint::VoteTally expected{{2, 20}, {4, 40}};
+  BOOST_CHECK(checkpoint.m_cur_dynasty_votes == expected);
+  BOOST_CHECK_EQUAL(checkpoint.m_vote_set.size(), 2);
+  BOOST_CHECK(checkpoint.HasVoted(uint160S("aa")));
+  BOOST_CHECK(checkpoint.HasVoted(uint160S("cc")));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -9,6 +9,7 @@
 #include <keystore.h>
 #include <random.h>
 #include <script/script.h>
+#include <script/sigcache.h>
 #include <test/esperanza/finalization_utils.h>
 #include <test/esperanza/finalizationstate_utils.h>
 #include <test/test_unite.h>
@@ -623,7 +624,7 @@ BOOST_AUTO_TEST_CASE(CheckVoteTx_test) {
     Vote vote_out;
     std::vector<unsigned char> vote_sig_out;
 
-    bool ok = CheckVoteTx(tx, err_state, &vote_out, &vote_sig_out);
+    bool ok = CheckVoteTx(tx, err_state, &vote_out, &vote_sig_out, false);
     BOOST_CHECK(!ok);
     BOOST_CHECK_EQUAL(err_state.GetRejectReason(), "bad-vote-malformed");
 
@@ -641,7 +642,7 @@ BOOST_AUTO_TEST_CASE(CheckVoteTx_test) {
     Vote vote_out;
     std::vector<unsigned char> vote_sig_out;
 
-    bool ok = CheckVoteTx(tx, err_state, &vote_out, &vote_sig_out);
+    bool ok = CheckVoteTx(tx, err_state, &vote_out, &vote_sig_out, false);
     BOOST_CHECK(!ok);
     BOOST_CHECK_EQUAL(err_state.GetRejectReason(), "bad-vote-malformed");
 
@@ -659,7 +660,7 @@ BOOST_AUTO_TEST_CASE(CheckVoteTx_test) {
     Vote vote_out;
     std::vector<unsigned char> vote_sig_out;
 
-    bool ok = CheckVoteTx(tx, err_state, &vote_out, &vote_sig_out);
+    bool ok = CheckVoteTx(tx, err_state, &vote_out, &vote_sig_out, false);
     BOOST_CHECK(!ok);
     BOOST_CHECK_EQUAL(err_state.GetRejectReason(), "bad-vote-vout-script");
 
@@ -677,7 +678,7 @@ BOOST_AUTO_TEST_CASE(CheckVoteTx_test) {
     Vote vote_out;
     std::vector<unsigned char> vote_sig_out;
 
-    bool ok = CheckVoteTx(tx, err_state, &vote_out, &vote_sig_out);
+    bool ok = CheckVoteTx(tx, err_state, &vote_out, &vote_sig_out, false);
     BOOST_CHECK(!ok);
     BOOST_CHECK_EQUAL(err_state.GetRejectReason(), "bad-vote-data-format");
 
@@ -700,7 +701,7 @@ BOOST_AUTO_TEST_CASE(CheckVoteTx_test) {
     Vote vote_out;
     std::vector<unsigned char> vote_sig_out;
 
-    bool ok = CheckVoteTx(tx, err_state, &vote_out, &vote_sig_out);
+    bool ok = CheckVoteTx(tx, err_state, &vote_out, &vote_sig_out, false);
     BOOST_CHECK(!ok);
     BOOST_CHECK_EQUAL(err_state.GetRejectReason(), "bad-vote-signature");
 
@@ -726,12 +727,65 @@ BOOST_AUTO_TEST_CASE(CheckVoteTx_test) {
     CTransaction tx = CreateVoteTx(prev_tx, key, vote_out, vote_sig_out);
     CValidationState err_state;
 
-    bool ok = CheckVoteTx(tx, err_state, &vote_out, &vote_sig_out);
+    bool ok = CheckVoteTx(tx, err_state, &vote_out, &vote_sig_out, false);
     BOOST_CHECK(ok);
     BOOST_CHECK(err_state.IsValid());
   }
 }
 
+BOOST_AUTO_TEST_CASE(CachingCheckVoteSignature_test) {
+  CBasicKeyStore keystore;
+  CKey key;
+  InsecureNewKey(key, true);
+  keystore.AddKey(key);
+  const CPubKey pub_key = key.GetPubKey();
+
+  const Vote vote{pub_key.GetID(), GetRandHash(), 10, 100};
+  std::vector<unsigned char> vote_sig;
+  BOOST_CHECK(CreateVoteSignature(&keystore, vote, vote_sig));
+
+  // the signature is valid whether it's stored in the cache or not
+  BOOST_CHECK(CachingCheckVoteSignature(pub_key, vote, vote_sig, false));
+  BOOST_CHECK(CachingCheckVoteSignature(pub_key, vote, vote_sig, true));
+  BOOST_CHECK(CachingCheckVoteSignature(pub_key, vote, vote_sig, true));
+  BOOST_CHECK(CachingCheckVoteSignature(pub_key, vote, vote_sig, false));
+  BOOST_CHECK(CachingCheckVoteSignature(pub_key, vote, vote_sig, false));
+
+  // a cached signature is only valid for the vote it signs
+  BOOST_CHECK(CachingCheckVoteSignature(pub_key, vote, vote_sig, true));
+  const Vote other_vote{pub_key.GetID(), vote.m_target_hash, 10, 101};
+  BOOST_CHECK(!CachingCheckVoteSignature(pub_key, other_vote, vote_sig, true));
+  BOOST_CHECK(!CachingCheckVoteSignature(pub_key, other_vote, vote_sig, false));
+
+  CKey other_key;
+  InsecureNewKey(other_key, true);
+  BOOST_CHECK(!CachingCheckVoteSignature(other_key.GetPubKey(), vote, vote_sig, true));
+
+  std::vector<unsigned char> bad_sig = vote_sig;
+  bad_sig.back() ^= 1;
+  BOOST_CHECK(!CachingCheckVoteSignature(pub_key, vote, bad_sig, true));
+  BOOST_CHECK(!CachingCheckVoteSignature(pub_key, vote, {}, true));
+}
+
+BOOST_AUTO_TEST_CASE(TransactionSignatureChecker_CheckVoteSig_test) {
+  CKey key;
+  InsecureNewKey(key, true);
+  const CPubKey pub_key = key.GetPubKey();
+
+  const Vote vote{pub_key.GetID(), GetRandHash(), 10, 100};
+  std::vector<unsigned char> vote_sig;
+  BOOST_CHECK(key.Sign(vote.GetHash(), vote_sig));
+
+  const CTransaction tx;
+  const TransactionSignatureChecker checker(&tx, 0, 0);
+  BOOST_CHECK(checker.CheckVoteSig(vote, vote_sig, pub_key));
+  BOOST_CHECK(!checker.CheckVoteSig(vote, {}, pub_key));
+  BOOST_CHECK(!checker.CheckVoteSig(vote, vote_sig, CPubKey()));
+
+  const Vote other_vote{pub_key.GetID(), vote.m_target_hash, 10, 101};
+  BOOST_CHECK(!checker.CheckVoteSig(other_vote, vote_sig, pub_key));
+}
+
 BOOST_AUTO_TEST_CASE(ContextualCheckVoteTx_test) {
   uint256 target_hash = GetRandHash();
 
@@ -770,7 +824,7 @@ BOOST_AUTO_TEST_CASE(ContextualCheckVoteTx_test) {
 
     spy.CreateAndActivateDeposit(validator_address, deposit_size);
 
-    bool ok = ContextualCheckVoteTx(tx, err_state, spy, view);
+    bool ok = ContextualCheckVoteTx(tx, err_state, spy, view, false);
     BOOST_CHECK(!ok);
     BOOST_CHECK_EQUAL(err_state.GetRejectReason(), "bad-vote-no-prev-tx-found");
 
@@ -807,7 +861,7 @@ BOOST_AUTO_TEST_CASE(ContextualCheckVoteTx_test) {
     CTransaction tx = CreateVoteTx(*prev_tx, other_key, vote_from_other_validator, vote_sig);
     CValidationState err_state;
 
-    bool ok = ContextualCheckVoteTx(tx, err_state, spy, view);
+    bool ok = ContextualCheckVoteTx(tx, err_state, spy, view, false);
     BOOST_CHECK(!ok);
     BOOST_CHECK_EQUAL(err_state.GetRejectReason(), "bad-vote-not-from-validator");
 
@@ -836,14 +890,14 @@ BOOST_AUTO_TEST_CASE(ContextualCheckVoteTx_test) {
     CTransaction tx = CreateVoteTx(*prev_tx, key, vote_out, vote_sig_out);
     CValidationState err_state;
 
-    bool ok = ContextualCheckVoteTx(tx, err_state, spy, view);
+    bool ok = ContextualCheckVoteTx(tx, err_state, spy, view, false);
     BOOST_CHECK(ok);
     BOOST_CHECK(err_state.IsValid());
 
     spy.ProcessVote(vote_out);
 
     // Duplicate vote
-    ok = ContextualCheckVoteTx(tx, err_state, spy, view);
+    ok = ContextualCheckVoteTx(tx, err_state, spy, view, false);
     BOOST_CHECK(!ok);
     BOOST_CHECK_EQUAL(err_state.GetRejectReason(), "bad-vote-invalid");
 
@@ -870,7 +924,7 @@ BOOST_AUTO_TEST_CASE(ContextualCheckVoteTx_test) {
     CTransaction tx = CreateVoteTx(*prev_tx, key, vote_out, vote_sig_out);
     CValidationState err_state;
 
-    bool ok = ContextualCheckVoteTx(tx, err_state, spy, view);
+    bool ok = ContextualCheckVoteTx(tx, err_state, spy, view, false);
     BOOST_CHECK(ok);
     BOOST_CHECK(err_state.IsValid());
   }
@@ -1004,8 +1058,9 @@ BOOST_AUTO_TEST_CASE(ContextualCheckWithdrawTx_test) {
     BOOST_CHECK_EQUAL(spy.ValidateLogout(validator_address), +Result::SUCCESS);
     spy.ProcessLogout(validator_address);
 
-    Validator *validator = &(*spy.pValidators())[validator_address];
-    validator->m_end_dynasty = 0;
+    spy.ModifyValidator(validator_address, [](Validator &validator) {
+      validator.m_end_dynasty = 0;
+    });
 
     CTransaction tx = CreateWithdrawTx(*prev_tx, key, 1);
     CValidationState err_state;
@@ -1064,7 +1119,7 @@ BOOST_AUTO_TEST_CASE(CheckVoteTransaction_malformed_vote) {
   CTransaction invalidVote(mutedTx);
   CValidationState err_state;
 
-  bool ok = ContextualCheckVoteTx(invalidVote, err_state, spy, view);
+  bool ok = ContextualCheckVoteTx(invalidVote, err_state, spy, view, false);
   BOOST_CHECK(!ok);
   BOOST_CHECK_EQUAL(err_state.GetRejectReason(), "bad-vote-data-format");
 
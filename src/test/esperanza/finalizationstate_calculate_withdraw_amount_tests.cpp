@@ -207,7 +207,7 @@ BOOST_AUTO_TEST_CASE(calculate_withdraw_amount_sometimes_voting) {
 
     uint160 finalizer_address = RandValidatorAddr();
     state.CreateAndActivateDeposit(finalizer_address, test_case.deposit_amount);
-    BOOST_REQUIRE_EQUAL(state.GetActiveFinalizers().size(), 2);
+    BOOST_REQUIRE_EQUAL(state.GetActiveFinalizersCount(), 2);
 
     // vote before logout
     uint32_t end = state.GetCurrentEpoch() + test_case.epochs_before_logout;
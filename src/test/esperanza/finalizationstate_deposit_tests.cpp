@@ -47,17 +47,16 @@ BOOST_AUTO_TEST_CASE(process_deposit_tx) {
   spy.ProcessDeposit(validatorAddress, depositSize);
   spy.ProcessDeposit(validatorAddress2, depositSize);
 
-  std::map<uint160, Validator> validators = spy.Validators();
-  auto it = validators.find(validatorAddress2);
-  BOOST_CHECK(it != validators.end());
+  const auto &validators = spy.Validators();
+  BOOST_CHECK(validators.Get(validatorAddress2) != nullptr);
 
-  it = validators.find(validatorAddress);
-  BOOST_CHECK(it != validators.end());
+  const Validator *it = validators.Get(validatorAddress);
+  BOOST_REQUIRE(it != nullptr);
 
-  Validator validator = it->second;
+  Validator validator = *it;
   BOOST_CHECK_EQUAL(validator.m_start_dynasty, 2);  // assuming we start from 0
   BOOST_CHECK(validator.m_deposit > 0);
-  BOOST_CHECK_EQUAL(it->first.GetHex(), validatorAddress.GetHex());
+  BOOST_CHECK_EQUAL(validator.m_validator_address.GetHex(), validatorAddress.GetHex());
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -72,8 +72,8 @@ BOOST_AUTO_TEST_CASE(process_logout_end_dynasty) {
   BOOST_CHECK_EQUAL(spy.ValidateLogout(validatorAddress), +Result::SUCCESS);
   spy.ProcessLogout(validatorAddress);
 
-  std::map<uint160, Validator> validators = spy.Validators();
-  Validator validator = validators.find(validatorAddress)->second;
+  const auto &validators = spy.Validators();
+  Validator validator = *validators.Get(validatorAddress);
   BOOST_CHECK_EQUAL(7, validator.m_end_dynasty);
 }
 
@@ -41,16 +41,16 @@ void FinalizationStateSpy::shuffle() {
     m_checkpoints[i].m_prev_dynasty_deposits = Rand<uint64_t>();
     {
       for (size_t j = 0; j < ConstRand(5); ++j) {
-        m_checkpoints[j].m_cur_dynasty_votes[j] = Rand<uint64_t>();
+        m_checkpoints[j].GetCurDynastyVotes(j) = Rand<uint64_t>();
       }
     }
     for (size_t j = 0; j < ConstRand(5); ++j) {
-      m_checkpoints[i].m_prev_dynasty_votes[j] = Rand<uint64_t>();
+      m_checkpoints[i].GetPrevDynastyVotes(j) = Rand<uint64_t>();
     }
     for (size_t j = 0; j < ConstRand(5); ++j) {
       uint160 hash;
       GetRandBytes((unsigned char *)&hash, sizeof(hash));
-      m_checkpoints[i].m_vote_set.emplace(hash);
+      m_checkpoints[i].AddVote(hash);
     }
   }
   for (size_t i = 0; i < ConstRand(5); ++i) {
@@ -59,13 +59,15 @@ void FinalizationStateSpy::shuffle() {
   for (size_t i = 0; i < ConstRand(5); ++i) {
     uint160 v;
     GetRandBytes((unsigned char *)&v, sizeof(v));
-    m_validators[v].m_validator_address = v;
-    m_validators[v].m_deposit = Rand<uint64_t>();
-    m_validators[v].m_start_dynasty = Rand<uint32_t>();
-    m_validators[v].m_end_dynasty = Rand<uint32_t>();
-    m_validators[v].m_is_slashed = Rand<bool>();
-    m_validators[v].m_deposits_at_logout = Rand<uint64_t>();
-    m_validators[v].m_last_transaction_hash = GetRandHash();
+    Validator validator;
+    validator.m_validator_address = v;
+    validator.m_deposit = Rand<uint64_t>();
+    validator.m_start_dynasty = Rand<uint32_t>();
+    validator.m_end_dynasty = Rand<uint32_t>();
+    validator.m_is_slashed = Rand<bool>();
+    validator.m_deposits_at_logout = Rand<uint64_t>();
+    validator.m_last_transaction_hash = GetRandHash();
+    m_validators.Upsert(validator);
   }
   for (size_t i = 0; i < ConstRand(5); ++i) {
     m_dynasty_deltas[i] = Rand<CAmount>();
@@ -100,7 +102,7 @@ void FinalizationStateSpy::CreateAndActivateDeposit(const uint160 &validator_add
   CreateDeposit(validator_address, deposit_size);
 
   for (uint32_t i = 1; i < 4 * EpochLength() + 1; i += EpochLength()) {
-    BOOST_REQUIRE_EQUAL(GetActiveFinalizers().size(), 0);
+    BOOST_REQUIRE_EQUAL(GetActiveFinalizersCount(), 0);
 
     // recommended target epoch in ProcessNewCommits
     // when checkpoint is being processed
@@ -114,7 +116,7 @@ void FinalizationStateSpy::CreateAndActivateDeposit(const uint160 &validator_add
   BOOST_REQUIRE_EQUAL(GetCurrentEpoch(), 4);
   BOOST_REQUIRE_EQUAL(GetLastJustifiedEpoch(), 2);
   BOOST_REQUIRE_EQUAL(GetLastFinalizedEpoch(), 2);
-  BOOST_REQUIRE(!GetActiveFinalizers().empty());
+  BOOST_REQUIRE(HasActiveFinalizers());
   BOOST_REQUIRE_EQUAL(m_expected_source_epoch, 2);
   BOOST_REQUIRE_EQUAL(m_recommended_target_epoch, 3);
 }
@@ -22,9 +22,12 @@ class FinalizationStateSpy : public FinalizationState {
   CAmount *CurDynDeposits() { return &m_cur_dyn_deposits; }
   CAmount *PrevDynDeposits() { return &m_prev_dyn_deposits; }
   uint64_t *RewardFactor() { return &m_reward_factor; }
-  std::map<uint160, Validator> &Validators() { return m_validators; }
-  std::map<uint160, Validator> *pValidators() { return &m_validators; }
-  std::map<uint32_t, Checkpoint> &Checkpoints() { return m_checkpoints; }
+  const ValidatorSet &Validators() const { return m_validators; }
+  template <typename Modifier>
+  void ModifyValidator(const uint160 &validator_address, Modifier modify) {
+    m_validators.Modify(m_validators.GetId(validator_address), modify);
+  }
+  util::PersistentMap<uint32_t, Checkpoint> &Checkpoints() { return m_checkpoints; }
   void SetRecommendedTarget(const CBlockIndex &block_index) {
     m_recommended_target_hash = block_index.GetBlockHash();
     m_recommended_target_epoch = GetEpoch(block_index);
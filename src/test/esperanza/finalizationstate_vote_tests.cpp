@@ -212,7 +212,8 @@ BOOST_AUTO_TEST_CASE(process_vote_tx_success_with_reward_no_consensus) {
   BOOST_CHECK_EQUAL(spy.InitializeEpoch(1 + 1 * spy.EpochLength()), +Result::SUCCESS);
   BOOST_CHECK_EQUAL(spy.InitializeEpoch(1 + 2 * spy.EpochLength()), +Result::SUCCESS);
   BOOST_CHECK_EQUAL(spy.InitializeEpoch(1 + 3 * spy.EpochLength()), +Result::SUCCESS);
-  BOOST_CHECK_EQUAL(spy.GetActiveFinalizers().size(), 2);
+  BOOST_CHECK_EQUAL(spy.GetActiveFinalizersCount(), 2);
+  BOOST_CHECK(spy.HasActiveFinalizers());
 
   Vote vote{validatorAddress_1, targetHash, 2, 3};
 
@@ -248,7 +249,7 @@ BOOST_AUTO_TEST_CASE(process_vote_tx_success_with_finalization) {
   BOOST_CHECK_EQUAL(spy.InitializeEpoch(1 + 1 * spy.EpochLength()), +Result::SUCCESS);
   BOOST_CHECK_EQUAL(spy.InitializeEpoch(1 + 2 * spy.EpochLength()), +Result::SUCCESS);
   BOOST_CHECK_EQUAL(spy.InitializeEpoch(1 + 3 * spy.EpochLength()), +Result::SUCCESS);
-  BOOST_CHECK_EQUAL(spy.GetActiveFinalizers().size(), 2);
+  BOOST_CHECK_EQUAL(spy.GetActiveFinalizersCount(), 2);
   BOOST_CHECK_EQUAL(spy.InitializeEpoch(1 + 4 * spy.EpochLength()), +Result::SUCCESS);
 
   Vote vote{validatorAddress_2, targetHash, 2, 4};
@@ -50,8 +50,6 @@ BOOST_AUTO_TEST_CASE(process_withdraw_too_early) {
   spy.ProcessLogout(validatorAddress);
   BOOST_CHECK_EQUAL(spy.GetCurrentEpoch(), 4);
 
-  Validator *validator = &(*spy.pValidators())[validatorAddress];
-
   // Logout delay is set in dynasties but since we have finalization
   // every epoch, it's equal to number of epochs.
   uint32_t end_logout = spy.GetCurrentEpoch() + static_cast<uint32_t>(spy.DynastyLogoutDelay());
@@ -63,7 +61,7 @@ BOOST_AUTO_TEST_CASE(process_withdraw_too_early) {
   BOOST_CHECK_EQUAL(end_withdraw, 20);
 
   for (uint32_t i = spy.GetCurrentEpoch(); i < end_withdraw; ++i) {
-    if (spy.GetCurrentDynasty() <= validator->m_end_dynasty) {
+    if (spy.GetCurrentDynasty() <= spy.GetValidator(validatorAddress)->m_end_dynasty) {
       Vote vote{validatorAddress, targetHash, i - 2, i - 1};
 
       BOOST_CHECK_EQUAL(spy.ValidateVote(vote), +Result::SUCCESS);
@@ -98,8 +96,6 @@ BOOST_AUTO_TEST_CASE(process_withdraw_completely_slashed) {
 
   spy.CreateAndActivateDeposit(validatorAddress, depositSize);
 
-  Validator *validator = &(*spy.pValidators())[validatorAddress];
-
   BOOST_CHECK_EQUAL(spy.ValidateLogout(validatorAddress), +Result::SUCCESS);
   spy.ProcessLogout(validatorAddress);
 
@@ -111,7 +107,7 @@ BOOST_AUTO_TEST_CASE(process_withdraw_completely_slashed) {
   uint32_t endEpoch = spy.DynastyLogoutDelay() + spy.WithdrawalEpochDelay() + 10;
 
   for (uint32_t i = 4; i < endEpoch; ++i) {
-    if (spy.GetCurrentDynasty() <= validator->m_end_dynasty) {
+    if (spy.GetCurrentDynasty() <= spy.GetValidator(validatorAddress)->m_end_dynasty) {
       Vote vote{validatorAddress, targetHash, i - 2, i - 1};
 
       BOOST_CHECK_EQUAL(spy.ValidateVote(vote), +Result::SUCCESS);
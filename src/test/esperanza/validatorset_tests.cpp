@@ -0,0 +1,280 @@
+// Copyright (c) 2019 The Unit-e developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <esperanza/validatorset.h>
+
+#include <streams.h>
+#include <util/persistent_map.h>
+#include <version.h>
+
+#include <test/test_unite.h>
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+#include <map>
+
+using esperanza::Validator;
+using esperanza::ValidatorSet;
+
+BOOST_FIXTURE_TEST_SUITE(validatorset_tests, ReducedTestingSetup)
+
+namespace {
+
+uint160 MakeAddress(const uint32_t n) {
+  uint160 address;
+  std::memcpy(address.begin(), &n, sizeof(n));
+  return address;
+}
+
+Validator MakeValidator(const uint32_t n) {
+  return Validator(InsecureRand32(), InsecureRandRange(10), MakeAddress(n));
+}
+
+template <typename T>
+std::string Serialized(const T &value) {
+  CDataStream stream(SER_DISK, PROTOCOL_VERSION);
+  stream << value;
+  return stream.str();
+}
+
+void CheckSame(const ValidatorSet &set, const std::map<uint160, Validator> &expected) {
+  BOOST_REQUIRE_EQUAL(set.size(), expected.size());
+  for (const auto &entry : expected) {
+    const Validator *validator = set.Get(entry.first);
+    BOOST_REQUIRE(validator != nullptr);
+    BOOST_CHECK(*validator == entry.second);
+  }
+  BOOST_CHECK(Serialized(set) == Serialized(expected));
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(basic_operations) {
+  ValidatorSet set;
+  BOOST_CHECK(set.empty());
+  BOOST_CHECK_EQUAL(set.Find(MakeAddress(1)), ValidatorSet::NO_ID);
+  BOOST_CHECK(set.Get(MakeAddress(1)) == nullptr);
+  BOOST_CHECK_THROW(set.GetId(MakeAddress(1)), std::out_of_range);
+
+  for (uint32_t i = 0; i < 100; ++i) {
+    BOOST_CHECK(set.Insert(Validator(i, 0, MakeAddress(i))));
+  }
+  BOOST_CHECK(!set.Insert(Validator(1000, 0, MakeAddress(5))));
+  BOOST_CHECK_EQUAL(set.size(), 100);
+  BOOST_CHECK_EQUAL(set.Get(MakeAddress(5))->m_deposit, 5);
+
+  const ValidatorSet::Id id = set.GetId(MakeAddress(42));
+  BOOST_CHECK_EQUAL(set.Get(id).m_deposit, 42);
+  set.Modify(id, [](Validator &validator) { validator.m_deposit = 4242; });
+  BOOST_CHECK_EQUAL(set.Get(MakeAddress(42))->m_deposit, 4242);
+
+  set.Upsert(Validator(55, 0, MakeAddress(42)));
+  BOOST_CHECK_EQUAL(set.Get(MakeAddress(42))->m_deposit, 55);
+  BOOST_CHECK_EQUAL(set.GetId(MakeAddress(42)), id);
+
+  // The ids of removed validators are reused, the others stay the same.
+  const ValidatorSet::Id other_id = set.GetId(MakeAddress(43));
+  BOOST_CHECK(set.Erase(MakeAddress(42)));
+  BOOST_CHECK(!set.Erase(MakeAddress(42)));
+  BOOST_CHECK(set.Get(MakeAddress(42)) == nullptr);
+  BOOST_CHECK_EQUAL(set.size(), 99);
+  BOOST_CHECK(set.Insert(Validator(1, 0, MakeAddress(1000))));
+  BOOST_CHECK_EQUAL(set.GetId(MakeAddress(1000)), id);
+  BOOST_CHECK_EQUAL(set.GetId(MakeAddress(43)), other_id);
+
+  set.clear();
+  BOOST_CHECK(set.empty());
+  BOOST_CHECK(set.Get(MakeAddress(43)) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(copies_are_independent) {
+  ValidatorSet parent;
+  for (uint32_t i = 0; i < 1000; ++i) {
+    parent.Insert(Validator(i, 0, MakeAddress(i)));
+  }
+  ValidatorSet child = parent;
+  BOOST_CHECK(child == parent);
+
+  child.Modify(child.GetId(MakeAddress(500)), [](Validator &validator) { validator.m_deposit = 0; });
+  child.Erase(MakeAddress(10));
+  child.Insert(Validator(2000, 0, MakeAddress(2000)));
+  BOOST_CHECK(child != parent);
+
+  BOOST_CHECK_EQUAL(parent.size(), 1000);
+  BOOST_CHECK_EQUAL(parent.Get(MakeAddress(500))->m_deposit, 500);
+  BOOST_CHECK(parent.Get(MakeAddress(10)) != nullptr);
+  BOOST_CHECK(parent.Get(MakeAddress(2000)) == nullptr);
+
+  BOOST_CHECK_EQUAL(child.size(), 1000);
+  BOOST_CHECK_EQUAL(child.Get(MakeAddress(500))->m_deposit, 0);
+  BOOST_CHECK(child.Get(MakeAddress(10)) == nullptr);
+  BOOST_CHECK(child.Get(MakeAddress(2000)) != nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(random_operations) {
+  // Apply the same operations on a std::map and on a chain of sets and check
+  // that every generation still holds what it held when copied.
+  std::vector<std::map<uint160, Validator>> expected(1);
+  std::vector<ValidatorSet> generations(1);
+
+  for (int generation = 0; generation < 30; ++generation) {
+    std::map<uint160, Validator> next_expected = expected.back();
+    ValidatorSet next = generations.back();
+    for (int i = 0; i < 100; ++i) {
+      const Validator validator = MakeValidator(InsecureRandRange(300));
+      const uint160 &address = validator.m_validator_address;
+      switch (InsecureRandRange(3)) {
+        case 0:
+          next.Upsert(validator);
+          next_expected[address] = validator;
+          break;
+        case 1:
+          BOOST_CHECK_EQUAL(next.Erase(address), next_expected.erase(address) == 1);
+          break;
+        case 2:
+          BOOST_CHECK_EQUAL(next.Insert(validator), next_expected.emplace(address, validator).second);
+          break;
+      }
+    }
+    expected.emplace_back(std::move(next_expected));
+    generations.emplace_back(std::move(next));
+  }
+
+  for (size_t i = 0; i < generations.size(); ++i) {
+    CheckSame(generations[i], expected[i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(voting_finalizers) {
+  ValidatorSet set;
+  for (uint32_t i = 0; i < 500; ++i) {
+    Validator validator = MakeValidator(i);
+    validator.m_end_dynasty = InsecureRandBool() ? esperanza::MAX_END_DYNASTY
+                                                 : validator.m_start_dynasty + InsecureRandRange(5);
+    set.Insert(validator);
+  }
+
+  const auto check = [&set](const uint32_t dynasty) {
+    size_t expected = 0;
+    for (uint32_t i = 0; i < 500; ++i) {
+      const ValidatorSet::Id id = set.Find(MakeAddress(i));
+      if (id == ValidatorSet::NO_ID) {
+        continue;
+      }
+      const Validator &validator = set.Get(id);
+      const bool voting = ValidatorSet::IsInDynasty(validator, dynasty) ||
+                          ValidatorSet::IsInDynasty(validator, dynasty - 1);
+      BOOST_CHECK_EQUAL(set.IsVoting(id, dynasty), voting);
+      expected += voting ? 1 : 0;
+    }
+    BOOST_CHECK_EQUAL(set.CountVoting(dynasty), expected);
+    BOOST_CHECK_EQUAL(set.AnyVoting(dynasty), expected > 0);
+  };
+
+  for (uint32_t dynasty = 0; dynasty < 15; ++dynasty) {
+    set.SetDynasty(dynasty);
+    check(dynasty);
+    // Other dynasties than the one of the bitsets are answered too.
+    check(dynasty + 3);
+
+    // Logouts and removals are reflected in the bitsets.
+    const ValidatorSet::Id id = set.Find(MakeAddress(InsecureRandRange(500)));
+    if (id != ValidatorSet::NO_ID) {
+      set.Modify(id, [dynasty](Validator &validator) { validator.m_end_dynasty = dynasty + 1; });
+    }
+    set.Erase(MakeAddress(InsecureRandRange(500)));
+    check(dynasty);
+  }
+
+  set.SetDynasty(3);
+  check(3);
+
+  // A copy shares the bitsets, modifying it leaves the original alone.
+  ValidatorSet copy = set;
+  for (uint32_t i = 0; i < 500; ++i) {
+    copy.Erase(MakeAddress(i));
+  }
+  BOOST_CHECK(!copy.AnyVoting(3));
+  check(3);
+}
+
+BOOST_AUTO_TEST_CASE(diff_and_apply) {
+  ValidatorSet base;
+  util::PersistentMap<uint160, Validator> base_map;
+  for (uint32_t i = 0; i < 1000; ++i) {
+    const Validator validator = MakeValidator(i);
+    base.Insert(validator);
+    base_map[validator.m_validator_address] = validator;
+  }
+  BOOST_CHECK(base.Diff(base).empty());
+
+  ValidatorSet target = base;
+  util::PersistentMap<uint160, Validator> target_map = base_map;
+  const auto modify = [&target, &target_map](const uint32_t n, const uint64_t deposit) {
+    target.Modify(target.GetId(MakeAddress(n)), [deposit](Validator &validator) { validator.m_deposit = deposit; });
+    target_map.at(MakeAddress(n)).m_deposit = deposit;
+  };
+  modify(10, 0);
+  modify(20, target.Get(MakeAddress(20))->m_deposit);
+  target.Erase(MakeAddress(500));
+  target_map.erase(MakeAddress(500));
+  // Removed and added again, the validator gets another id.
+  target.Erase(MakeAddress(30));
+  target.Insert(MakeValidator(2000));
+  target.Insert(MakeValidator(30));
+  target_map[MakeAddress(2000)] = *target.Get(MakeAddress(2000));
+  target_map[MakeAddress(30)] = *target.Get(MakeAddress(30));
+
+  const ValidatorSet::Delta delta = base.Diff(target);
+  BOOST_CHECK_EQUAL(delta.upserts.size(), 3);
+  BOOST_CHECK_EQUAL(delta.erasures.size(), 1);
+
+  // The delta is the same as the one of a map with the same entries.
+  BOOST_CHECK(Serialized(delta) == Serialized(base_map.Diff(target_map)));
+
+  CDataStream stream(SER_DISK, PROTOCOL_VERSION);
+  stream << delta;
+  ValidatorSet::Delta deserialized;
+  stream >> deserialized;
+
+  ValidatorSet applied = base;
+  applied.Apply(deserialized);
+  BOOST_CHECK(applied == target);
+  BOOST_CHECK(applied.Diff(target).empty());
+
+  // Unrelated sets with the same content have no differences either.
+  ValidatorSet copy;
+  for (const auto &entry : target_map) {
+    copy.Insert(entry.second);
+  }
+  BOOST_CHECK(copy.Diff(target).empty());
+  BOOST_CHECK(target.Diff(copy).empty());
+}
+
+BOOST_AUTO_TEST_CASE(serialization) {
+  ValidatorSet set;
+  std::map<uint160, Validator> map;
+  for (uint32_t i = 0; i < 100; ++i) {
+    const Validator validator = MakeValidator(InsecureRand32());
+    set.Upsert(validator);
+    map[validator.m_validator_address] = validator;
+  }
+  BOOST_CHECK(Serialized(set) == Serialized(map));
+
+  CDataStream stream(SER_DISK, PROTOCOL_VERSION);
+  stream << map;
+  ValidatorSet deserialized;
+  deserialized.Insert(MakeValidator(1));
+  stream >> deserialized;
+  BOOST_CHECK(deserialized == set);
+  CheckSame(deserialized, map);
+
+  // The key of every entry must be the address of its validator.
+  std::map<uint160, Validator> mismatch;
+  mismatch[MakeAddress(1)] = MakeValidator(2);
+  stream << mismatch;
+  BOOST_CHECK_THROW(stream >> deserialized, std::ios_base::failure);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
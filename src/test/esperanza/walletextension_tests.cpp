@@ -15,6 +15,7 @@
 #include <primitives/txtype.h>
 #include <proposer/block_builder.h>
 #include <proposer/eligible_coin.h>
+#include <script/ismine.h>
 #include <script/script.h>
 #include <staking/coin.h>
 #include <test/esperanza/finalization_utils.h>
@@ -68,6 +69,49 @@ BOOST_FIXTURE_TEST_CASE(vote_signature2, TestingSetup) {
   BOOST_CHECK(CreateVoteSignature(&keystore, vote, voteSig));
 }
 
+BOOST_FIXTURE_TEST_CASE(send_vote_checks_for_votes_cast_while_signing, WalletTestingSetup) {
+
+  esperanza::WalletExtension &wallet_ext = m_wallet->GetWalletExtension();
+
+  CKey key;
+  InsecureNewKey(key, true);
+  const CPubKey pub_key = key.GetPubKey();
+  {
+    LOCK(m_wallet->cs_wallet);
+    BOOST_REQUIRE(m_wallet->AddKeyPubKey(key, pub_key));
+  }
+
+  CMutableTransaction deposit;
+  deposit.SetType(TxType::DEPOSIT);
+  deposit.vin.emplace_back(GetRandHash(), 0);
+  deposit.vout.emplace_back(10000 * UNIT, CScript::CreateFinalizerCommitScript(pub_key));
+  const CTransactionRef prev_tx = MakeTransactionRef(deposit);
+
+  const esperanza::Vote vote{pub_key.GetID(), GetRandHash(), 1, 2};
+
+  // SendVote signs without cs_main, the same vote was cast in the meantime
+  wallet_ext.validatorState.emplace();
+  wallet_ext.validatorState->m_validator_address = pub_key.GetID();
+  wallet_ext.validatorState->m_vote_map[vote.m_target_epoch] = vote;
+
+  CTransactionRef vote_tx;
+  BOOST_CHECK(!wallet_ext.SendVote(prev_tx, vote, vote_tx));
+
+  // the vote got signed
+  BOOST_REQUIRE(vote_tx);
+  BOOST_CHECK(vote_tx->IsVote());
+  esperanza::Vote signed_vote;
+  std::vector<unsigned char> vote_sig;
+  BOOST_REQUIRE(CScript::ExtractVoteFromVoteSignature(vote_tx->vin[0].scriptSig, signed_vote, vote_sig));
+  BOOST_CHECK(signed_vote == vote);
+  BOOST_CHECK(CheckVoteSignature(pub_key, signed_vote, vote_sig));
+
+  // but it was not committed a second time
+  LOCK(m_wallet->cs_wallet);
+  BOOST_CHECK(m_wallet->GetWalletTx(vote_tx->GetHash()) == nullptr);
+  BOOST_CHECK_EQUAL(wallet_ext.validatorState->m_vote_map.size(), 1);
+}
+
 BOOST_FIXTURE_TEST_CASE(sign_coinbase_transaction, WalletTestingSetup) {
 
   const key::mnemonic::Seed seed("stizzoso atavico inodore srotolato birra stupendo velina incendio copione pietra alzare privato folata madama gemmato");
@@ -326,6 +370,140 @@ BOOST_FIXTURE_TEST_CASE(get_stakeable_coins, TestChain100Setup) {
     BOOST_CHECK(stakeable_coins.begin()->GetTransactionId() != stakeable.GetHash());
     BOOST_CHECK(stakeable_coins.begin()->GetOutputIndex() != 0);
   }
+
+  // The stakeable coins follow new blocks without rescanning the wallet
+  for (int i = 0; i < 3; ++i) {
+    CreateAndProcessBlock({}, coinbase_script, boost::none, &processed);
+    BOOST_CHECK(processed);
+
+    LOCK2(cs_main, m_wallet->cs_wallet);
+    const staking::CoinSet stakeable_coins = wallet_ext.GetStakeableCoins();
+    BOOST_CHECK(!stakeable_coins.empty());
+
+    CAmount total = 0;
+    for (const staking::Coin &coin : stakeable_coins) {
+      total += coin.GetAmount();
+    }
+    BOOST_CHECK_EQUAL(wallet_ext.GetStakeableBalance(), total);
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE(stakeable_coins_follow_the_chain, TestChain100Setup) {
+
+  const auto &wallet_ext = m_wallet->GetWalletExtension();
+
+  // The stakeable coins as they were found by scanning the whole wallet
+  const auto scan_wallet = [&]() {
+    AssertLockHeld(cs_main);
+    AssertLockHeld(m_wallet->cs_wallet);
+    std::set<COutPoint> out_points;
+    CCoinsViewCache view(pcoinsTip.get());
+    for (const auto &it : m_wallet->mapWallet) {
+      const CWalletTx &tx = it.second;
+      const CBlockIndex *containing_block = nullptr;
+      if (tx.GetDepthInMainChain(containing_block) <= 0 || !containing_block) {
+        continue;
+      }
+      if (!stake_validator_mock.IsStakeMature(static_cast<blockchain::Height>(containing_block->nHeight))) {
+        continue;
+      }
+      const bool skip_reward = tx.IsCoinBase() && tx.GetBlocksToRewardMaturity() > 0;
+      for (std::uint32_t i = skip_reward ? 1 : 0; i < tx.tx->vout.size(); ++i) {
+        const COutPoint out_point(tx.GetHash(), i);
+        const CTxOut &out = tx.tx->vout[i];
+        if (m_wallet->IsSpent(out_point.hash, i) || !view.HaveCoin(out_point) ||
+            m_wallet->IsLockedCoin(out_point.hash, i) ||
+            out.nValue <= 0 || !IsStakeableByMe(*m_wallet, out.scriptPubKey)) {
+          continue;
+        }
+        out_points.emplace(out_point);
+      }
+    }
+    return out_points;
+  };
+
+  const auto stakeable_coins = [&]() {
+    std::set<COutPoint> out_points;
+    for (const staking::Coin &coin : wallet_ext.GetStakeableCoins()) {
+      out_points.emplace(coin.GetOutPoint());
+    }
+    return out_points;
+  };
+
+  const CScript coinbase_script = GetScriptForDestination(WitnessV0KeyHash(coinbaseKey.GetPubKey().GetID()));
+
+  // Spent coins leave the stakeable coins: every block spends its stake
+  for (int i = 0; i < 5; ++i) {
+    boost::optional<staking::Coin> stake;
+    {
+      LOCK2(cs_main, m_wallet->cs_wallet);
+      const staking::CoinSet coins = wallet_ext.GetStakeableCoins();
+      BOOST_REQUIRE(!coins.empty());
+      stake.emplace(*coins.begin());
+    }
+    CreateAndProcessBlock({}, coinbase_script, stake);
+
+    LOCK2(cs_main, m_wallet->cs_wallet);
+    const std::set<COutPoint> coins = stakeable_coins();
+    BOOST_CHECK_EQUAL(coins.count(stake->GetOutPoint()), 0);
+    BOOST_CHECK(coins == scan_wallet());
+  }
+
+  // Coins at the last mature height are stakeable, the ones above are not
+  {
+    LOCK2(cs_main, m_wallet->cs_wallet);
+    blockchain::Height top = 0;
+    for (const staking::Coin &coin : wallet_ext.GetStakeableCoins()) {
+      top = std::max(top, coin.GetHeight());
+    }
+    BOOST_REQUIRE(top > 0);
+
+    blockchain::Height last_mature = top;
+    stake_validator_mock.mock_IsStakeMature.SetStub([&last_mature](const blockchain::Height height) {
+      return height <= last_mature;
+    });
+    staking::CoinSet coins = wallet_ext.GetStakeableCoins();
+    BOOST_CHECK(std::any_of(coins.begin(), coins.end(), [top](const staking::Coin &coin) {
+      return coin.GetHeight() == top;
+    }));
+    BOOST_CHECK(stakeable_coins() == scan_wallet());
+
+    last_mature = top - 1;
+    coins = wallet_ext.GetStakeableCoins();
+    BOOST_CHECK(std::none_of(coins.begin(), coins.end(), [top](const staking::Coin &coin) {
+      return coin.GetHeight() >= top;
+    }));
+    BOOST_CHECK(stakeable_coins() == scan_wallet());
+
+    stake_validator_mock.mock_IsStakeMature.Reset();
+  }
+
+  // Reorg to a chain which is one block shorter: the stakes spent by the
+  // disconnected blocks become stakeable again
+  int old_height;
+  {
+    CValidationState state;
+    {
+      LOCK(cs_main);
+      old_height = chainActive.Height();
+      BOOST_REQUIRE(InvalidateBlock(state, Params(), chainActive[old_height - 1]));
+    }
+    BOOST_REQUIRE(ActivateBestChain(state, Params()));
+    SyncWithValidationInterfaceQueue();
+
+    LOCK2(cs_main, m_wallet->cs_wallet);
+    BOOST_CHECK_EQUAL(chainActive.Height(), old_height - 2);
+    const std::set<COutPoint> coins = stakeable_coins();
+    BOOST_CHECK(!coins.empty());
+    BOOST_CHECK(coins == scan_wallet());
+  }
+
+  CreateAndProcessBlock({}, GetScriptForDestination(coinbaseKey.GetPubKey().GetID()));
+  {
+    LOCK2(cs_main, m_wallet->cs_wallet);
+    BOOST_CHECK_EQUAL(chainActive.Height(), old_height - 1);
+    BOOST_CHECK(stakeable_coins() == scan_wallet());
+  }
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -4,6 +4,7 @@
 
 #include <finalization/state_db.h>
 
+#include <dbwrapper.h>
 #include <finalization/params.h>
 
 #include <test/esperanza/finalizationstate_utils.h>
@@ -230,4 +231,121 @@ BOOST_AUTO_TEST_CASE(load_best_states) {
   }
 }
 
+BOOST_FIXTURE_TEST_CASE(save_and_load_deltas, BasicTestingSetup) {
+  Settings settings;
+  settings.data_dir = SetDataDir("state_db_deltas");
+  finalization::StateDBParams params;
+  params.snapshot_interval = 2;
+  finalization::Params finalization_params;
+
+  mocks::ActiveChainMock active_chain;
+  blocktools::BlockIndexFake block_index_fake;
+  mocks::BlockIndexMapMock block_index_map;
+  block_index_map.mock_Lookup.SetStub([&](const uint256 &block_hash) -> CBlockIndex * {
+    auto result = block_index_fake.block_indexes.find(block_hash);
+    if (result == block_index_fake.block_indexes.end()) {
+      return nullptr;
+    }
+    return &result->second;
+  });
+
+  LOCK(block_index_map.GetLock());
+
+  // Every state derives from the state of the parent block by a single deposit,
+  // with checkpoints of every second epoch stored in full.
+  std::map<const CBlockIndex *, esperanza::FinalizationState> original;
+  const std::vector<CBlockIndex *> chain = block_index_fake.GetChain(block_index_fake.Generate(30));
+  {
+    std::unique_ptr<FinalizationStateSpy> state = MakeUnique<FinalizationStateSpy>(finalization_params);
+    for (CBlockIndex *block_index : chain) {
+      std::unique_ptr<FinalizationStateSpy> next = MakeUnique<FinalizationStateSpy>(*state);
+      next->ProcessDeposit(RandValidatorAddr(), next->MinDepositSize());
+      original.emplace(block_index, FinalizationState(*next, FinalizationState::COMPLETED));
+      state = std::move(next);
+    }
+  }
+  BOOST_REQUIRE_EQUAL(original.size(), 30);
+
+  {
+    std::unique_ptr<finalization::StateDB> db = finalization::StateDB::NewFromParams(
+        params, &settings, &finalization_params, &block_index_map, &active_chain);
+    BOOST_CHECK(db->Save(original));
+
+    // The state of block 12 is a base of the delta of block 13.
+    BOOST_CHECK(db->Erase(*chain[12]));
+    std::map<const CBlockIndex *, esperanza::FinalizationState> restored;
+    BOOST_CHECK(!db->Load(*chain[12], &restored));
+    BOOST_CHECK(db->Load(*chain[13], &restored));
+    BOOST_CHECK_EQUAL(restored.at(chain[13]), original.at(chain[13]));
+
+    original.erase(chain[12]);
+    FinalizationState &modified = original.at(chain[20]);
+    modified.ProcessDeposit(RandValidatorAddr(), finalization_params.min_deposit_size);
+    BOOST_CHECK(db->Save(original));
+  }
+
+  // Load everything with a fresh database, so that all the deltas are read from disk.
+  std::unique_ptr<finalization::StateDB> db = finalization::StateDB::NewFromParams(
+      params, &settings, &finalization_params, &block_index_map, &active_chain);
+  std::map<const CBlockIndex *, esperanza::FinalizationState> restored;
+  BOOST_CHECK(db->Load(&restored));
+  BOOST_CHECK_EQUAL(restored, original);
+  for (const auto &kv : restored) {
+    BOOST_CHECK_EQUAL(kv.second.GetInitStatus(), FinalizationState::COMPLETED);
+  }
+
+  restored.clear();
+  BOOST_CHECK(db->Load(*chain[29], &restored));
+  BOOST_CHECK_EQUAL(restored.at(chain[29]), original.at(chain[29]));
+}
+
+BOOST_FIXTURE_TEST_CASE(migrate_legacy_states, BasicTestingSetup) {
+  Settings settings;
+  settings.data_dir = SetDataDir("state_db_legacy");
+  finalization::StateDBParams params;
+  finalization::Params finalization_params;
+
+  mocks::ActiveChainMock active_chain;
+  blocktools::BlockIndexFake block_index_fake;
+  mocks::BlockIndexMapMock block_index_map;
+  block_index_map.mock_Lookup.SetStub([&](const uint256 &block_hash) -> CBlockIndex * {
+    auto result = block_index_fake.block_indexes.find(block_hash);
+    if (result == block_index_fake.block_indexes.end()) {
+      return nullptr;
+    }
+    return &result->second;
+  });
+
+  LOCK(block_index_map.GetLock());
+
+  // Older versions stored every state in full under its bare block hash.
+  std::map<const CBlockIndex *, esperanza::FinalizationState> original;
+  const std::vector<CBlockIndex *> chain = block_index_fake.GetChain(block_index_fake.Generate(10));
+  {
+    CDBWrapper legacy_db(settings.data_dir / "finalization", 0);
+    CDBBatch batch(legacy_db);
+    for (CBlockIndex *block_index : chain) {
+      FinalizationStateSpy state(finalization_params);
+      state.shuffle();
+      FinalizationState completed(state, FinalizationState::COMPLETED);
+      batch.Write(block_index->GetBlockHash(), completed);
+      original.emplace(block_index, std::move(completed));
+    }
+    BOOST_REQUIRE(legacy_db.WriteBatch(batch, true));
+  }
+
+  {
+    std::unique_ptr<finalization::StateDB> db = finalization::StateDB::NewFromParams(
+        params, &settings, &finalization_params, &block_index_map, &active_chain);
+    std::map<const CBlockIndex *, esperanza::FinalizationState> restored;
+    BOOST_CHECK(db->Load(&restored));
+    BOOST_CHECK_EQUAL(restored, original);
+  }
+
+  CDBWrapper legacy_db(settings.data_dir / "finalization", 0);
+  for (CBlockIndex *block_index : chain) {
+    BOOST_CHECK(!legacy_db.Exists(block_index->GetBlockHash()));
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -192,4 +192,80 @@ BOOST_AUTO_TEST_CASE(record_surrounding_vote_outer_passed) {
   UnregisterValidationInterface(&listener);
 }
 
+BOOST_AUTO_TEST_CASE(vote_history_find_surrounding) {
+
+  const uint160 validatorAddress = RandValidatorAddr();
+  VoteHistory history(2);
+
+  BOOST_CHECK(history.Insert(VoteRecord{{validatorAddress, GetRandHash(), 2, 3}, {}}));
+  BOOST_CHECK(history.Insert(VoteRecord{{validatorAddress, GetRandHash(), 3, 4}, {}}));
+  BOOST_CHECK(history.Insert(VoteRecord{{validatorAddress, GetRandHash(), 4, 8}, {}}));
+
+  // Only one vote per target epoch and none before the base epoch
+  BOOST_CHECK(!history.Insert(VoteRecord{{validatorAddress, GetRandHash(), 2, 4}, {}}));
+  BOOST_CHECK(!history.Insert(VoteRecord{{validatorAddress, GetRandHash(), 0, 1}, {}}));
+  BOOST_CHECK(history.Find(1) == nullptr);
+
+  BOOST_CHECK(history.FindSurrounding(3, 4) == nullptr);
+  BOOST_CHECK(history.FindSurrounding(8, 9) == nullptr);
+  BOOST_CHECK(history.FindSurrounding(4, 7) == nullptr);
+
+  // Surrounds 3 -> 4
+  const VoteRecord *record = history.FindSurrounding(2, 5);
+  BOOST_REQUIRE(record != nullptr);
+  BOOST_CHECK_EQUAL(record->vote.m_target_epoch, 4);
+
+  // Surrounded by 4 -> 8
+  record = history.FindSurrounding(5, 7);
+  BOOST_REQUIRE(record != nullptr);
+  BOOST_CHECK_EQUAL(record->vote.m_target_epoch, 8);
+
+  history.Prune(4);
+  BOOST_CHECK_EQUAL(history.GetBaseEpoch(), 4);
+  BOOST_CHECK(history.Find(3) == nullptr);
+  BOOST_CHECK(history.Find(4) != nullptr);
+  record = history.FindSurrounding(5, 7);
+  BOOST_REQUIRE(record != nullptr);
+  BOOST_CHECK_EQUAL(record->vote.m_target_epoch, 8);
+}
+
+BOOST_AUTO_TEST_CASE(record_votes_before_finalized_epoch) {
+
+  finalization::Params params = finalization::Params::TestNet();
+  FinalizationStateSpy spy(params);
+  SlashListener listener;
+  RegisterValidationInterface(&listener);
+  auto recorder = VoteRecorder::GetVoteRecorder();
+
+  uint160 validatorAddress = RandValidatorAddr();
+  spy.ProcessDeposit(validatorAddress, 1000000);
+  spy.InitializeEpoch(1);
+  spy.InitializeEpoch(1 + 1 * 50);
+  spy.InitializeEpoch(1 + 2 * 50);
+  spy.InitializeEpoch(1 + 3 * 50);
+  spy.InitializeEpoch(1 + 4 * 50);
+  spy.InitializeEpoch(1 + 5 * 50);
+
+  esperanza::Vote outerVote{validatorAddress, GetRandHash(), 1, 10};
+  esperanza::Vote innerVote{validatorAddress, GetRandHash(), 2, 9};
+
+  recorder->RecordVote(outerVote, ToByteVector(GetRandHash()), spy);
+  BOOST_CHECK(!listener.slashingDetected);
+
+  // The vote is pruned from memory but still known
+  spy.SetLastFinalizedEpoch(11);
+  recorder->RecordVote(esperanza::Vote{validatorAddress, GetRandHash(), 11, 12},
+                       ToByteVector(GetRandHash()), spy);
+  BOOST_CHECK(!listener.slashingDetected);
+  BOOST_CHECK_EQUAL(outerVote.GetHash(),
+                    recorder->GetVote(validatorAddress, 10)->vote.GetHash());
+
+  recorder->RecordVote(innerVote, ToByteVector(GetRandHash()), spy);
+  BOOST_CHECK_EQUAL(innerVote.GetHash(),
+                    recorder->GetVote(validatorAddress, 9)->vote.GetHash());
+  BOOST_CHECK(listener.slashingDetected);
+
+  UnregisterValidationInterface(&listener);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -8,8 +8,10 @@
 #include <test/test_unite_mocks.h>
 #include <test/esperanza/finalizationstate_utils.h>
 
+#include <chainparams.h>
 #include <finalization/state_processor.h>
 #include <finalization/state_repository.h>
+#include <net.h>
 #include <p2p/finalizer_commits_handler_impl.h>
 
 template <typename Os>
@@ -34,6 +36,13 @@ public:
   using p2p::FinalizerCommitsHandlerImpl::FindMostRecentStart;
   using p2p::FinalizerCommitsHandlerImpl::FindStop;
   using p2p::FinalizerCommitsHandlerImpl::IsSameFork;
+  using p2p::FinalizerCommitsHandlerImpl::GetResponseSize;
+
+  void SendCommits(CNode &, p2p::FinalizerCommitsResponse &&response) const override {
+    sent.emplace_back(std::move(response));
+  }
+
+  mutable std::vector<p2p::FinalizerCommitsResponse> sent;
 };
 
 class RepoMock : public finalization::StateRepository {
@@ -632,4 +641,92 @@ BOOST_AUTO_TEST_CASE(is_same_fork_test) {
   }
 }
 
+
+BOOST_AUTO_TEST_CASE(get_response_size) {
+  using p2p::FinalizerCommitsResponse;
+
+  // The count of items takes more bytes from 253 items on
+  FinalizerCommitsResponse response;
+  size_t data_size = 0;
+  for (size_t i = 0; i < 300; ++i) {
+    BOOST_CHECK_EQUAL(FinalizerCommitsHandlerSpy::GetResponseSize(response.data.size(), data_size),
+                      GetSerializeSize(response, SER_NETWORK, PROTOCOL_VERSION));
+    p2p::HeaderAndFinalizerCommits item;
+    item.header.nTime = i;
+    item.commits.resize(i % 3, MakeTransactionRef(CMutableTransaction()));
+    data_size += GetSerializeSize(item, SER_NETWORK, PROTOCOL_VERSION);
+    response.data.emplace_back(std::move(item));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(on_get_commits_length_exceeded) {
+  using p2p::FinalizerCommitsResponse;
+
+  Fixture fixture;
+  fixture.AddBlocks(1);  // add genesis
+
+  staking::ActiveChain &chain = fixture.active_chain;
+  FinalizerCommitsHandlerSpy &commits = fixture.commits;
+
+  // Commits of about 15kB per block, a message takes more than 253 of them
+  // before it reaches the length limit.
+  std::vector<CTransactionRef> txs;
+  for (size_t i = 0; i < 7; ++i) {
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    const std::vector<unsigned char> data(15000 + i * 100, 0);
+    tx.vin[0].scriptSig = CScript(data.begin(), data.end());
+    txs.emplace_back(MakeTransactionRef(tx));
+  }
+  const blockchain::Height tip_height = 600;
+  for (blockchain::Height h = 1; h <= tip_height; ++h) {
+    CBlockIndex &index = fixture.CreateBlockIndex();
+    index.commits = std::vector<CTransactionRef>{txs[h % txs.size()]};
+  }
+
+  // The split of a response which is serialized again with every item
+  std::vector<FinalizerCommitsResponse> expected;
+  {
+    FinalizerCommitsResponse response;
+    for (blockchain::Height h = 1; h <= tip_height; ++h) {
+      const CBlockIndex *index = chain.AtHeight(h);
+      p2p::HeaderAndFinalizerCommits item(index->GetBlockHeader());
+      item.commits = *index->commits;
+
+      FinalizerCommitsResponse response_copy = response;
+      response_copy.data.emplace_back(std::move(item));
+      if (GetSerializeSize(response_copy, SER_NETWORK, PROTOCOL_VERSION) >= MAX_PROTOCOL_MESSAGE_LENGTH) {
+        response.status = FinalizerCommitsResponse::Status::LengthExceeded;
+        expected.emplace_back(std::move(response));
+        response = FinalizerCommitsResponse();
+      } else {
+        response = std::move(response_copy);
+      }
+    }
+    response.status = FinalizerCommitsResponse::Status::TipReached;
+    expected.emplace_back(std::move(response));
+  }
+  BOOST_REQUIRE_EQUAL(expected.size(), 3U);
+  BOOST_REQUIRE_GT(expected[0].data.size(), 253U);
+
+  CNode node(0, ServiceFlags(NODE_NETWORK), 0, INVALID_SOCKET, CAddress(), 0, 0, CAddress(), "", /*fInboundIn=*/ false);
+  commits.OnGetCommits(node, p2p::FinalizerCommitsLocator{{chain.AtHeight(0)->GetBlockHash()}, uint256()},
+                       Params().GetConsensus());
+
+  BOOST_REQUIRE_EQUAL(commits.sent.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    const FinalizerCommitsResponse &sent = commits.sent[i];
+    BOOST_CHECK(sent.status == expected[i].status);
+    BOOST_REQUIRE_EQUAL(sent.data.size(), expected[i].data.size());
+    size_t data_size = 0;
+    for (size_t j = 0; j < sent.data.size(); ++j) {
+      BOOST_CHECK_EQUAL(sent.data[j].header.GetHash(), expected[i].data[j].header.GetHash());
+      data_size += GetSerializeSize(sent.data[j], SER_NETWORK, PROTOCOL_VERSION);
+    }
+    const size_t size = GetSerializeSize(sent, SER_NETWORK, PROTOCOL_VERSION);
+    BOOST_CHECK_EQUAL(FinalizerCommitsHandlerSpy::GetResponseSize(sent.data.size(), data_size), size);
+    BOOST_CHECK_LT(size, MAX_PROTOCOL_MESSAGE_LENGTH);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -43,8 +43,13 @@ class MempoolMock : public ::TxPool {
     return txs.size();
   }
 
-  std::vector<CTransactionRef> GetTxs() const override {
-    return txs;
+  void ForEachTx(const std::function<bool(const uint256 &)> &filter,
+                 const std::function<void(const CTransactionRef &)> &visit) const override {
+    for (const CTransactionRef &tx : txs) {
+      if (filter(tx->GetWitnessHash())) {
+        visit(tx);
+      }
+    }
   }
 
   std::vector<CTransactionRef> txs;
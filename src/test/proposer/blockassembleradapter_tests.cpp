@@ -52,4 +52,15 @@ BOOST_AUTO_TEST_CASE(pick_transactions_removes_bitcoin_coinbase) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(transactions_updated_follows_mempool) {
+
+  const auto blockAssemblerAdapter = staking::TransactionPicker::New();
+
+  const unsigned int before = blockAssemblerAdapter->GetTransactionsUpdated();
+  BOOST_CHECK_EQUAL(before, mempool.GetTransactionsUpdated());
+
+  mempool.AddTransactionsUpdated(1);
+  BOOST_CHECK_EQUAL(blockAssemblerAdapter->GetTransactionsUpdated(), before + 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -80,7 +80,7 @@ BOOST_AUTO_TEST_CASE(propose) {
   });
   const boost::optional<proposer::EligibleCoin> coin = [&] {
     LOCK(f.active_chain_mock.GetLock());
-    return logic->TryPropose(coins);
+    return logic->TryPropose(coins, f.tip);
   }();
   BOOST_REQUIRE(static_cast<bool>(coin));
   const proposer::EligibleCoin eligible_coin = *coin;
@@ -88,4 +88,53 @@ BOOST_AUTO_TEST_CASE(propose) {
   BOOST_CHECK_EQUAL(eligible_coin.utxo.GetTransactionId(), t2);
 }
 
+BOOST_AUTO_TEST_CASE(propose_searches_past_first_batch) {
+  Fixture f;
+  auto logic = f.GetProposerLogic();
+  const CBlockIndex block = [] {
+    CBlockIndex index;
+    index.nHeight = 100;
+    return index;
+  }();
+  std::vector<uint256> txids;
+  const staking::CoinSet coins = [&] {
+    staking::CoinSet coins;
+    for (std::uint32_t i = 0; i < 200; ++i) {
+      txids.emplace_back(GetRandHash());
+      coins.emplace(&block, COutPoint{txids.back(), i}, CTxOut{1000 - i, CScript()});
+    }
+    return coins;
+  }();
+  const uint256 winner = txids[150];
+  f.active_chain_mock.mock_GetTip.SetResult(&f.tip);
+  f.stake_validator_mock.mock_ComputeKernelHash.SetStub([&](const CBlockIndex *, const staking::Coin &coin, blockchain::Time) {
+    return coin.GetTransactionId();
+  });
+  f.stake_validator_mock.mock_CheckKernel.SetStub([&](CAmount, const uint256 &kernel, blockchain::Difficulty) {
+    return kernel == winner;
+  });
+  const boost::optional<proposer::EligibleCoin> coin = logic->TryPropose(coins, f.tip);
+  BOOST_REQUIRE(static_cast<bool>(coin));
+  BOOST_CHECK_EQUAL(coin->kernel_hash, winner);
+  BOOST_CHECK_EQUAL(coin->utxo.GetTransactionId(), winner);
+  BOOST_CHECK_EQUAL(f.stake_validator_mock.mock_ComputeKernelHash.CountInvocations(), 192);
+}
+
+BOOST_AUTO_TEST_CASE(propose_on_stale_tip) {
+  Fixture f;
+  auto logic = f.GetProposerLogic();
+  const CBlockIndex block;
+  const staking::CoinSet coins = [&] {
+    staking::CoinSet coins;
+    coins.emplace(&block, COutPoint{GetRandHash(), 0}, CTxOut{1000, CScript()});
+    return coins;
+  }();
+  f.active_chain_mock.mock_GetTip.SetResult(&f.tip);
+  f.stake_validator_mock.mock_CheckKernel.SetResult(true);
+  // the coins were picked on top of at_depth_1, which is no longer the tip
+  BOOST_CHECK(!logic->TryPropose(coins, f.at_depth_1));
+  BOOST_CHECK_EQUAL(f.stake_validator_mock.mock_ComputeKernelHash.CountInvocations(), 0);
+  BOOST_CHECK(static_cast<bool>(logic->TryPropose(coins, f.tip)));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -14,10 +14,15 @@
 #include <staking/transactionpicker.h>
 #include <test/test_unite.h>
 #include <test/test_unite_mocks.h>
+#include <validation.h>
 #include <wallet/wallet.h>
 
 #include <boost/test/unit_test.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
 #include <thread>
 
 namespace {
@@ -42,33 +47,64 @@ struct Fixture {
   MultiWalletMock multi_wallet_mock;
   mocks::StakeValidatorMock stake_validator;
 
+  //! The wallets need cs_main to be held when looking up their stakeable coins.
+  struct ActiveChainMock : public mocks::ActiveChainMock {
+    CCriticalSection &GetLock() const override {
+      return cs_main;
+    }
+  };
+
   Fixture(std::initializer_list<std::string> args)
-      : args_manager([&] {
-          std::unique_ptr<::ArgsManager> argsman = MakeUnique<::ArgsManager>();
-          const char **argv = new const char *[args.size() + 1];
-          argv[0] = "executable-name";
-          std::size_t i = 1;
-          for (const auto &arg : args) {
-            argv[i++] = arg.c_str();
-          }
-          std::string error;
-          argsman->ParseParameters(static_cast<int>(i), argv, error);
-          delete[] argv;
-          return argsman;
-        }()),
+      : args_manager(MakeUnique<mocks::ArgsManagerMock>(args)),
         settings(Settings::New(args_manager.get(), behavior.get())),
-        wallet(new CWallet("mock", WalletDatabase::CreateMock(), [&] {
-          esperanza::WalletExtensionDeps deps(settings.get(), &stake_validator);
-          return deps;
-        }())),
+        wallet(MakeWallet("mock")),
         multi_wallet_mock([&] {
           MultiWalletMock mock;
           mock.wallets.emplace_back(wallet);
           return mock;
         }()) {}
 
+  std::shared_ptr<CWallet> MakeWallet(const std::string &name) {
+    return std::make_shared<CWallet>(name, WalletDatabase::CreateMock(), [&] {
+      esperanza::WalletExtensionDeps deps(settings.get(), &stake_validator);
+      return deps;
+    }());
+  }
+
+  //! \brief Gives the wallet a coin which it can stake.
+  //!
+  //! The coin is included in the genesis block, so this requires a
+  //! TestingSetup. Returns the id of the transaction which created it.
+  static uint256 AddStakeableCoin(CWallet &wallet) {
+    CKey key;
+    key.MakeNewKey(true);
+    CMutableTransaction mtx;
+    mtx.vin.emplace_back(GetRandHash(), 0);
+    mtx.vout.emplace_back(10000 * UNIT, GetScriptForDestination(key.GetPubKey().GetID()));
+    CWalletTx wtx(&wallet, MakeTransactionRef(mtx));
+    LOCK2(cs_main, wallet.cs_wallet);
+    BOOST_REQUIRE(wallet.AddKeyPubKey(key, key.GetPubKey()));
+    wtx.SetMerkleBranch(chainActive.Genesis(), 0);
+    wallet.LoadToWallet(wtx);
+    pcoinsTip->AddCoin(COutPoint(wtx.GetHash(), 0), Coin(mtx.vout[0], 0, TxType::REGULAR), false);
+    return wtx.GetHash();
+  }
+
+  //! \brief Waits until the condition holds, for at most ten seconds.
+  template <typename Condition>
+  static bool WaitFor(Condition condition) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!condition()) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        return false;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+  }
+
   mocks::NetworkMock network_mock;
-  mocks::ActiveChainMock chain_mock;
+  ActiveChainMock chain_mock;
   mocks::TransactionPickerMock transaction_picker_mock;
   mocks::BlockBuilderMock block_builder_mock;
   mocks::ProposerLogicMock logic_mock;
@@ -136,4 +172,178 @@ BOOST_AUTO_TEST_CASE(advance_to_blockchain_sync) {
   BOOST_CHECK_EQUAL(f.wallet->GetWalletExtension().GetProposerState().m_status, +proposer::Status::NOT_PROPOSING_SYNCING_BLOCKCHAIN);
 }
 
+BOOST_FIXTURE_TEST_CASE(lowest_kernel_hash_proposes, TestingSetup) {
+  // proposes without waiting in between rounds
+  Fixture f{"-proposing=1", "-customchainparams={\"block_stake_timestamp_interval_seconds\":0}"};
+  f.multi_wallet_mock.wallets.emplace_back(f.MakeWallet("second"));
+  const uint256 txid_1 = Fixture::AddStakeableCoin(*f.multi_wallet_mock.wallets[0]);
+  const uint256 txid_2 = Fixture::AddStakeableCoin(*f.multi_wallet_mock.wallets[1]);
+  // both wallets are eligible, the second one with the lower kernel hash
+  const uint256 kernel_1 = uint256S("02");
+  const uint256 kernel_2 = uint256S("01");
+
+  CBlockIndex tip;
+  f.network_mock.mock_GetNodeCount.SetResult(1);
+  f.chain_mock.mock_GetTip.SetResult(&tip);
+
+  // If there is more than one core the wallets are searched at the same
+  // time, so every search waits a bit for the other one to start.
+  const bool expect_concurrent_searches = GetNumCores() > 1;
+  std::atomic<int> searches_in_progress{0};
+  std::atomic<bool> searched_concurrently{false};
+  std::atomic<bool> searched_other_tip{false};
+  f.logic_mock.mock_TryPropose.SetStub([&](const staking::CoinSet &coins, const CBlockIndex &search_tip) {
+    if (&search_tip != &tip) {
+      searched_other_tip = true;
+    }
+    if (++searches_in_progress > 1) {
+      searched_concurrently = true;
+    }
+    if (expect_concurrent_searches) {
+      const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+      while (!searched_concurrently && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+    --searches_in_progress;
+    const staking::Coin &coin = *coins.begin();
+    const uint256 &kernel_hash = coin.GetTransactionId() == txid_1 ? kernel_1 : kernel_2;
+    return boost::optional<proposer::EligibleCoin>(proposer::EligibleCoin{coin, kernel_hash, 0, 1, 0, 0});
+  });
+  // only read once the proposer is stopped
+  uint256 proposed_kernel_hash;
+  uint256 proposed_txid;
+  f.block_builder_mock.mock_BuildBlock.SetStub(
+      [&](const CBlockIndex &, const uint256 &, const proposer::EligibleCoin &coin, const staking::CoinSet &,
+          const std::vector<CTransactionRef> &, CAmount, const boost::optional<CScript> &, staking::StakingWallet &) {
+        if (proposed_kernel_hash.IsNull()) {
+          proposed_kernel_hash = coin.kernel_hash;
+          proposed_txid = coin.utxo.GetTransactionId();
+        }
+        return std::shared_ptr<const CBlock>();
+      });
+
+  auto p = f.MakeProposer();
+  p->Start();
+  BOOST_CHECK(Fixture::WaitFor([&] { return f.block_builder_mock.mock_BuildBlock.CountInvocations() > 0; }));
+  p->Stop();
+
+  BOOST_CHECK_EQUAL(proposed_kernel_hash, kernel_2);
+  BOOST_CHECK_EQUAL(proposed_txid, txid_2);
+  BOOST_CHECK(f.logic_mock.mock_TryPropose.CountInvocations() >= 2);
+  BOOST_CHECK_EQUAL(searched_concurrently, expect_concurrent_searches);
+  BOOST_CHECK(!searched_other_tip);
+  for (const auto &wallet : f.multi_wallet_mock.wallets) {
+    esperanza::WalletExtension &wallet_ext = wallet->GetWalletExtension();
+    LOCK(wallet_ext.GetLock());
+    BOOST_CHECK_EQUAL(wallet_ext.GetProposerState().m_status, +proposer::Status::IS_PROPOSING);
+    BOOST_CHECK(wallet_ext.GetProposerState().m_number_of_searches > 0);
+  }
+}
+
+BOOST_FIXTURE_TEST_CASE(block_candidate_refreshed_only_when_stale, TestingSetup) {
+  // proposes without waiting in between rounds
+  Fixture f{"-proposing=1", "-customchainparams={\"block_stake_timestamp_interval_seconds\":0}"};
+  Fixture::AddStakeableCoin(*f.wallet);
+
+  CBlockIndex tip_1;
+  CBlockIndex tip_2;
+  std::atomic<const CBlockIndex *> tip{&tip_1};
+  std::atomic<unsigned int> transactions_updated{0};
+  f.network_mock.mock_GetNodeCount.SetResult(1);
+  f.chain_mock.mock_GetTip.SetStub([&] { return tip.load(); });
+  f.transaction_picker_mock.mock_GetTransactionsUpdated.SetStub([&] { return transactions_updated.load(); });
+
+  // Waits for two more searches. The second one started after the call, so
+  // a refresh due to a change made before has happened by then.
+  const auto wait_for_next_round = [&] {
+    const std::uint32_t searches = f.logic_mock.mock_TryPropose.CountInvocations();
+    BOOST_REQUIRE(Fixture::WaitFor([&] { return f.logic_mock.mock_TryPropose.CountInvocations() >= searches + 2; }));
+  };
+
+  auto p = f.MakeProposer();
+  p->Start();
+
+  // The first round finds the stakeable coin, the next one prepares the candidate.
+  wait_for_next_round();
+  BOOST_CHECK_EQUAL(f.transaction_picker_mock.mock_PickTransactions.CountInvocations(), 1);
+
+  // nothing changed
+  wait_for_next_round();
+  wait_for_next_round();
+  BOOST_CHECK_EQUAL(f.transaction_picker_mock.mock_PickTransactions.CountInvocations(), 1);
+
+  // the mempool changed
+  transactions_updated = 1;
+  wait_for_next_round();
+  BOOST_CHECK_EQUAL(f.transaction_picker_mock.mock_PickTransactions.CountInvocations(), 2);
+  wait_for_next_round();
+  BOOST_CHECK_EQUAL(f.transaction_picker_mock.mock_PickTransactions.CountInvocations(), 2);
+
+  // the tip changed
+  tip = &tip_2;
+  wait_for_next_round();
+  BOOST_CHECK_EQUAL(f.transaction_picker_mock.mock_PickTransactions.CountInvocations(), 3);
+  wait_for_next_round();
+  BOOST_CHECK_EQUAL(f.transaction_picker_mock.mock_PickTransactions.CountInvocations(), 3);
+
+  p->Stop();
+  BOOST_CHECK_EQUAL(f.block_builder_mock.mock_BuildBlock.CountInvocations(), 0);
+}
+
+BOOST_FIXTURE_TEST_CASE(block_candidate_used_as_is_after_a_win, TestingSetup) {
+  // proposes without waiting in between rounds
+  Fixture f{"-proposing=1", "-customchainparams={\"block_stake_timestamp_interval_seconds\":0}"};
+  Fixture::AddStakeableCoin(*f.wallet);
+
+  CBlockIndex tip;
+  std::atomic<unsigned int> transactions_updated{0};
+  f.network_mock.mock_GetNodeCount.SetResult(1);
+  f.chain_mock.mock_GetTip.SetResult(&tip);
+  f.transaction_picker_mock.mock_GetTransactionsUpdated.SetStub([&] { return transactions_updated.load(); });
+
+  // Every search wins, and the mempool changes while it's running.
+  std::mutex events_lock;
+  std::string events;
+  const auto record = [&](const char event) {
+    std::lock_guard<std::mutex> lock(events_lock);
+    events += event;
+  };
+  f.logic_mock.mock_TryPropose.SetStub([&](const staking::CoinSet &coins, const CBlockIndex &) {
+    record('S');
+    ++transactions_updated;
+    return boost::optional<proposer::EligibleCoin>(proposer::EligibleCoin{*coins.begin(), uint256S("01"), 0, 1, 0, 0});
+  });
+  f.transaction_picker_mock.mock_PickTransactions.SetStub([&](const staking::TransactionPicker::PickTransactionsParameters &) {
+    record('P');
+    return staking::TransactionPicker::PickTransactionsResult{"", {}, {}};
+  });
+  f.block_builder_mock.mock_BuildBlock.SetStub(
+      [&](const CBlockIndex &, const uint256 &, const proposer::EligibleCoin &, const staking::CoinSet &,
+          const std::vector<CTransactionRef> &, CAmount, const boost::optional<CScript> &, staking::StakingWallet &) {
+        record('B');
+        return std::shared_ptr<const CBlock>();
+      });
+
+  auto p = f.MakeProposer();
+  p->Start();
+  BOOST_CHECK(Fixture::WaitFor([&] { return f.block_builder_mock.mock_BuildBlock.CountInvocations() >= 5; }));
+  p->Stop();
+
+  // Only the first round, which had no candidate yet, picks transactions
+  // after its win. The later rounds pick the changed mempool before the
+  // search and propose right after winning.
+  std::lock_guard<std::mutex> lock(events_lock);
+  BOOST_CHECK_EQUAL(events.substr(0, 3), "SPB");
+  size_t picks_after_search = 0;
+  for (size_t i = 1; i < events.size(); ++i) {
+    if (events[i - 1] == 'S') {
+      BOOST_CHECK_EQUAL(events[i], i == 1 ? 'P' : 'B');
+      picks_after_search += events[i] == 'P' ? 1 : 0;
+    }
+  }
+  BOOST_CHECK_EQUAL(picks_after_search, 1);
+  BOOST_CHECK(f.transaction_picker_mock.mock_PickTransactions.CountInvocations() >= 2);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
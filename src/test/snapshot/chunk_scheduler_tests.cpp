@@ -0,0 +1,195 @@
+// Copyright (c) 2019 The Unit-e developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <snapshot/chunk_scheduler.h>
+
+#include <test/test_unite.h>
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(chunk_scheduler_tests, ReducedTestingSetup)
+
+namespace {
+
+using Request = snapshot::ChunkScheduler::Request;
+
+const uint256 snapshot_hash = uint256S("aa");
+
+std::vector<snapshot::UTXOSubset> Subsets(const Request &request) {
+  std::vector<snapshot::UTXOSubset> subsets(request.count);
+  for (uint16_t i = 0; i < request.count; ++i) {
+    subsets[i].height = static_cast<uint32_t>(request.index + i);
+  }
+  return subsets;
+}
+
+void CheckReady(const std::vector<snapshot::UTXOSubset> &subsets, const uint64_t from,
+                const uint64_t count) {
+  BOOST_REQUIRE_EQUAL(subsets.size(), count);
+  for (uint64_t i = 0; i < count; ++i) {
+    BOOST_CHECK_EQUAL(subsets[i].height, from + i);
+  }
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(distributes_chunks_across_peers) {
+  snapshot::ChunkScheduler scheduler(snapshot_hash, 500, 100000);
+  const auto now = std::chrono::steady_clock::now();
+
+  const std::vector<Request> first = scheduler.NextRequests(1, now);
+  const std::vector<Request> second = scheduler.NextRequests(2, now);
+  BOOST_REQUIRE_EQUAL(first.size(), snapshot::MAX_CHUNKS_IN_FLIGHT_PER_PEER);
+  BOOST_REQUIRE_EQUAL(second.size(), snapshot::MAX_CHUNKS_IN_FLIGHT_PER_PEER);
+  BOOST_CHECK_EQUAL(scheduler.InFlight(1), 2);
+
+  BOOST_CHECK_EQUAL(first[0].index, 500);
+  BOOST_CHECK_EQUAL(first[1].index, 500 + snapshot::INITIAL_UTXO_SET_COUNT);
+  BOOST_CHECK_EQUAL(second[0].index, 500 + 2 * snapshot::INITIAL_UTXO_SET_COUNT);
+  BOOST_CHECK_EQUAL(second[1].index, 500 + 3 * snapshot::INITIAL_UTXO_SET_COUNT);
+  for (const Request &request : first) {
+    BOOST_CHECK_EQUAL(request.count, snapshot::INITIAL_UTXO_SET_COUNT);
+  }
+
+  // peers with all requests in flight get nothing new
+  BOOST_CHECK(scheduler.NextRequests(1, now).empty());
+}
+
+BOOST_AUTO_TEST_CASE(writes_chunks_in_order) {
+  snapshot::ChunkScheduler scheduler(snapshot_hash, 0, 2500);
+  const auto now = std::chrono::steady_clock::now();
+
+  const std::vector<Request> first = scheduler.NextRequests(1, now);
+  const std::vector<Request> second = scheduler.NextRequests(2, now);
+  BOOST_REQUIRE_EQUAL(first.size(), 2);
+  BOOST_REQUIRE_EQUAL(second.size(), 1);
+  BOOST_CHECK_EQUAL(second[0].index, 2000);
+  BOOST_CHECK_EQUAL(second[0].count, 500);
+
+  // chunks received ahead wait for the preceding ones
+  BOOST_CHECK(scheduler.Receive(2, second[0].index, Subsets(second[0]), now));
+  BOOST_CHECK(scheduler.TakeReady().empty());
+  BOOST_CHECK(scheduler.Receive(1, first[1].index, Subsets(first[1]), now));
+  BOOST_CHECK(scheduler.TakeReady().empty());
+
+  // duplicates are rejected
+  BOOST_CHECK(!scheduler.Receive(2, second[0].index, Subsets(second[0]), now));
+
+  BOOST_CHECK(scheduler.Receive(1, first[0].index, Subsets(first[0]), now));
+  CheckReady(scheduler.TakeReady(), 0, 2500);
+  BOOST_CHECK(scheduler.IsComplete());
+  BOOST_CHECK(scheduler.NextRequests(1, now).empty());
+}
+
+BOOST_AUTO_TEST_CASE(adapts_chunk_size) {
+  snapshot::ChunkScheduler scheduler(snapshot_hash, 0, 1000000);
+  const auto now = std::chrono::steady_clock::now();
+
+  // 1000 subsets within 100ms
+  std::vector<Request> fast = scheduler.NextRequests(1, now);
+  BOOST_CHECK(scheduler.Receive(1, fast[0].index, Subsets(fast[0]), now + std::chrono::milliseconds(100)));
+  BOOST_CHECK_EQUAL(scheduler.ChunkSize(1), snapshot::MAX_UTXO_SET_COUNT);
+
+  // 1000 subsets within 5 seconds
+  std::vector<Request> slow = scheduler.NextRequests(2, now);
+  BOOST_CHECK(scheduler.Receive(2, slow[0].index, Subsets(slow[0]), now + std::chrono::seconds(5)));
+  BOOST_CHECK_EQUAL(scheduler.ChunkSize(2), 400);
+
+  // 1000 subsets within 100 seconds
+  std::vector<Request> slowest = scheduler.NextRequests(3, now);
+  BOOST_CHECK(scheduler.Receive(3, slowest[0].index, Subsets(slowest[0]), now + std::chrono::seconds(100)));
+  BOOST_CHECK_EQUAL(scheduler.ChunkSize(3), snapshot::MIN_UTXO_SET_COUNT);
+
+  const std::vector<Request> next = scheduler.NextRequests(2, now);
+  BOOST_REQUIRE_EQUAL(next.size(), 1);
+  BOOST_CHECK_EQUAL(next[0].count, 400);
+}
+
+BOOST_AUTO_TEST_CASE(re_requests_stragglers) {
+  snapshot::ChunkScheduler scheduler(snapshot_hash, 0, 2000);
+  auto now = std::chrono::steady_clock::now();
+
+  const std::vector<Request> slow = scheduler.NextRequests(1, now);
+  BOOST_REQUIRE_EQUAL(slow.size(), 2);
+  BOOST_CHECK(scheduler.NextRequests(2, now).empty());
+
+  // peer 2 is asked for the chunks of peer 1 once they are late
+  now += snapshot::MIN_STRAGGLER_TIMEOUT + std::chrono::seconds(1);
+  const std::vector<Request> retry = scheduler.NextRequests(2, now);
+  BOOST_REQUIRE_EQUAL(retry.size(), 2);
+  BOOST_CHECK_EQUAL(retry[0].index, slow[0].index);
+  BOOST_CHECK_EQUAL(retry[1].index, slow[1].index);
+
+  // whoever replies first wins
+  BOOST_CHECK(scheduler.Receive(2, retry[0].index, Subsets(retry[0]), now));
+  BOOST_CHECK(scheduler.Receive(1, slow[1].index, Subsets(slow[1]), now));
+  BOOST_CHECK(!scheduler.Receive(1, slow[0].index, Subsets(slow[0]), now));
+  BOOST_CHECK(!scheduler.Receive(2, retry[1].index, Subsets(retry[1]), now));
+  BOOST_CHECK_EQUAL(scheduler.InFlight(1), 0);
+  BOOST_CHECK_EQUAL(scheduler.InFlight(2), 0);
+
+  CheckReady(scheduler.TakeReady(), 0, 2000);
+  BOOST_CHECK(scheduler.IsComplete());
+}
+
+BOOST_AUTO_TEST_CASE(releases_chunks_of_removed_peers) {
+  snapshot::ChunkScheduler scheduler(snapshot_hash, 0, 2000);
+  const auto now = std::chrono::steady_clock::now();
+
+  const std::vector<Request> removed = scheduler.NextRequests(1, now);
+  BOOST_REQUIRE_EQUAL(removed.size(), 2);
+  scheduler.RemovePeer(1);
+  BOOST_CHECK_EQUAL(scheduler.InFlight(1), 0);
+
+  const std::vector<Request> requests = scheduler.NextRequests(2, now);
+  BOOST_REQUIRE_EQUAL(requests.size(), 2);
+  BOOST_CHECK_EQUAL(requests[0].index, removed[0].index);
+  BOOST_CHECK_EQUAL(requests[1].index, removed[1].index);
+}
+
+BOOST_AUTO_TEST_CASE(re_requests_partial_replies) {
+  snapshot::ChunkScheduler scheduler(snapshot_hash, 0, 1000);
+  const auto now = std::chrono::steady_clock::now();
+
+  const std::vector<Request> requests = scheduler.NextRequests(1, now);
+  BOOST_REQUIRE_EQUAL(requests.size(), 1);
+
+  std::vector<snapshot::UTXOSubset> subsets = Subsets(requests[0]);
+  subsets.resize(300);
+  BOOST_CHECK(scheduler.Receive(1, 0, std::move(subsets), now));
+  CheckReady(scheduler.TakeReady(), 0, 300);
+
+  const std::vector<Request> rest = scheduler.NextRequests(1, now);
+  BOOST_REQUIRE_EQUAL(rest.size(), 1);
+  BOOST_CHECK_EQUAL(rest[0].index, 300);
+  BOOST_CHECK_EQUAL(rest[0].count, 700);
+}
+
+BOOST_AUTO_TEST_CASE(limits_subsets_in_flight) {
+  snapshot::ChunkScheduler scheduler(snapshot_hash, 0, 1000000);
+  const auto now = std::chrono::steady_clock::now();
+
+  uint64_t requested = 0;
+  for (NodeId node_id = 0; node_id < 100; ++node_id) {
+    for (const Request &request : scheduler.NextRequests(node_id, now)) {
+      requested += request.count;
+    }
+  }
+  BOOST_CHECK_EQUAL(requested, snapshot::MAX_UTXO_SUBSETS_IN_FLIGHT);
+}
+
+BOOST_AUTO_TEST_CASE(accepts_unrequested_continuation) {
+  snapshot::ChunkScheduler scheduler(snapshot_hash, 0, 10);
+  const auto now = std::chrono::steady_clock::now();
+
+  BOOST_CHECK(!scheduler.Receive(1, 5, Subsets(Request{5, 2}), now));
+  BOOST_CHECK(scheduler.Receive(1, 0, Subsets(Request{0, 2}), now));
+  CheckReady(scheduler.TakeReady(), 0, 2);
+
+  const std::vector<Request> requests = scheduler.NextRequests(1, now);
+  BOOST_REQUIRE_EQUAL(requests.size(), 1);
+  BOOST_CHECK_EQUAL(requests[0].index, 2);
+  BOOST_CHECK_EQUAL(requests[0].count, 8);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -5,6 +5,7 @@
 
 #include <algorithm>
 
+#include <random.h>
 #include <snapshot/indexer.h>
 #include <snapshot/iterator.h>
 #include <snapshot/snapshot_index.h>
@@ -121,6 +122,95 @@ BOOST_AUTO_TEST_CASE(snapshot_creator) {
   UnloadBlockIndex();
 }
 
+BOOST_AUTO_TEST_CASE(snapshot_creator_workers) {
+  SetDataDir("snapshot_creator_workers");
+  fs::remove_all(GetDataDir() / snapshot::SNAPSHOT_FOLDER);
+  assert(snapshot::GetSnapshotCheckpoints().empty());
+
+  uint256 bestBlock = uint256S("aa");
+  auto bi = new CBlockIndex();
+  bi->nTime = 1269211443;
+  bi->nBits = 246;
+  bi->phashBlock = &mapBlockIndex.emplace(bestBlock, bi).first->first;
+
+  auto viewDB = MakeUnique<CCoinsViewDB>(0, false, true);
+  auto viewCache = MakeUnique<CCoinsViewCache>(viewDB.get());
+  viewCache->SetBestBlock(bestBlock);
+
+  const uint32_t totalTX = 100;
+  const uint32_t coinsPerTX = 2;
+
+  {
+    // generate Coins in chainstate
+    for (uint32_t i = 0; i < totalTX * coinsPerTX; ++i) {
+      COutPoint point;
+      point.n = i;
+      CDataStream s(SER_DISK, PROTOCOL_VERSION);
+      s << i / coinsPerTX;
+      point.hash.SetHex(HexStr(s));
+
+      Coin coin(CTxOut(i, CScript() << i), 1, TxType::REGULAR);
+      viewCache->AddCoin(point, std::move(coin), false);
+    }
+    BOOST_CHECK(viewCache->Flush());
+  }
+
+  const auto read_file = [](const fs::path &path) {
+    fs::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  };
+
+  // snapshots created with and without workers must have the same content
+  std::vector<snapshot::CreationInfo> infos;
+  for (const uint32_t workers : {0, 1, 3}) {
+    // update stake modifier to trigger different snapshot hash
+    // and height to keep the previous snapshot
+    mapBlockIndex[bestBlock]->stake_modifier = GetRandHash();
+    mapBlockIndex[bestBlock]->nHeight = static_cast<int>(infos.size());
+
+    snapshot::Creator creator(viewDB.get());
+    creator.m_step = 3;
+    creator.m_steps_per_file = 2;
+    creator.m_workers = workers;
+    infos.emplace_back(creator.Create());
+
+    const snapshot::CreationInfo &info = infos.back();
+    BOOST_CHECK_EQUAL(info.status, +snapshot::Status::OK);
+    BOOST_CHECK_EQUAL(info.snapshot_header.total_utxo_subsets, totalTX);
+    BOOST_CHECK_EQUAL(info.total_outputs, static_cast<int>(totalTX * coinsPerTX));
+  }
+
+  const fs::path dir = GetDataDir() / snapshot::SNAPSHOT_FOLDER;
+  const fs::path expected = dir / infos[0].snapshot_header.snapshot_hash.GetHex();
+  for (size_t i = 1; i < infos.size(); ++i) {
+    const fs::path actual = dir / infos[i].snapshot_header.snapshot_hash.GetHex();
+    BOOST_CHECK(read_file(actual / "index.dat") == read_file(expected / "index.dat"));
+    for (uint32_t file_id = 0; file_id < (totalTX + 5) / 6; ++file_id) {
+      const std::string name = "utxo" + std::to_string(file_id) + ".dat";
+      BOOST_CHECK(!read_file(expected / name).empty());
+      BOOST_CHECK(read_file(actual / name) == read_file(expected / name));
+    }
+  }
+
+  {
+    // stop in the middle of the batch
+    mapBlockIndex[bestBlock]->stake_modifier = GetRandHash();
+    mapBlockIndex[bestBlock]->nHeight = static_cast<int>(infos.size());
+
+    snapshot::Creator creator(viewDB.get());
+    creator.m_step = 3;
+    creator.m_workers = 2;
+    creator.m_max_utxo_subsets = 10;
+    snapshot::CreationInfo info = creator.Create();
+    BOOST_CHECK_EQUAL(info.status, +snapshot::Status::OK);
+    BOOST_CHECK_EQUAL(info.snapshot_header.total_utxo_subsets, 10);
+    BOOST_CHECK_EQUAL(info.total_outputs, static_cast<int>(10 * coinsPerTX));
+  }
+
+  // cleanup as this test has side effects
+  UnloadBlockIndex();
+}
+
 BOOST_AUTO_TEST_CASE(snapshot_creator_concurrent_read) {
   SetDataDir("snapshot_creator_multithreading");
   fs::remove_all(GetDataDir() / snapshot::SNAPSHOT_FOLDER);
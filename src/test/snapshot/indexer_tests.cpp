@@ -169,4 +169,71 @@ BOOST_AUTO_TEST_CASE(snapshot_indexer_open) {
   BOOST_CHECK_EQUAL(opened_idx->GetSnapshotHeader().total_utxo_subsets, total_msgs);
 }
 
+BOOST_AUTO_TEST_CASE(snapshot_indexer_serialized_subsets) {
+  SetDataDir("snapshot_indexer_serialized_subsets");
+  fs::remove_all(GetDataDir() / snapshot::SNAPSHOT_FOLDER);
+
+  uint32_t step = 3;
+  uint32_t steps_per_file = 2;
+  uint256 snapshot_hash = uint256S("aa");
+  snapshot::SnapshotHeader snapshot_header;
+  snapshot_header.snapshot_hash = snapshot_hash;
+  auto indexer = MakeUnique<snapshot::Indexer>(snapshot_header, step, steps_per_file);
+
+  // subsets of different sizes
+  uint64_t total_msgs = (step * steps_per_file) * 2 + step + 1;
+  std::vector<snapshot::UTXOSubset> subsets;
+  for (uint64_t i = 0; i < total_msgs; ++i) {
+    snapshot::UTXOSubset subset;
+    subset.height = static_cast<uint32_t>(i);
+    for (uint32_t n = 0; n < i % 4; ++n) {
+      subset.outputs.emplace_back(n, CTxOut(n, CScript() << n));
+    }
+    subsets.push_back(subset);
+    BOOST_CHECK(indexer->WriteUTXOSubset(subset));
+    if (i % 5 == 0) {
+      BOOST_CHECK(indexer->Flush());
+    }
+  }
+  BOOST_CHECK(indexer->Flush());
+
+  LOCK(snapshot::cs_snapshot);
+  indexer = snapshot::Indexer::Open(snapshot_hash);
+  BOOST_REQUIRE(indexer);
+
+  for (uint64_t index = 0; index < total_msgs; ++index) {
+    for (uint16_t count = 1; count <= total_msgs; count += 4) {
+      snapshot::SerializedUTXOSubsets serialized;
+      BOOST_CHECK(indexer->ReadSerializedUTXOSubsets(index, count, serialized));
+
+      const uint64_t end = std::min<uint64_t>(index + count, total_msgs);
+      std::vector<snapshot::UTXOSubset> expected(subsets.begin() + index, subsets.begin() + end);
+      CDataStream expected_stream(SER_NETWORK, PROTOCOL_VERSION);
+      expected_stream << expected;
+      CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+      stream << serialized;
+
+      BOOST_CHECK_EQUAL(serialized.Count(), end - index);
+      BOOST_CHECK_EQUAL(HexStr(stream), HexStr(expected_stream));
+    }
+  }
+
+  snapshot::SerializedUTXOSubsets serialized;
+  BOOST_CHECK(!indexer->ReadSerializedUTXOSubsets(total_msgs, 1, serialized));
+
+  // the file without the offset table is read using the step index
+  fs::path dir = GetDataDir() / "snapshots" / snapshot_hash.GetHex();
+  fs::remove(dir / "utxo1.idx");
+  indexer = snapshot::Indexer::Open(snapshot_hash);
+  BOOST_REQUIRE(indexer);
+  BOOST_CHECK(indexer->ReadSerializedUTXOSubsets(0, 3, serialized));
+  BOOST_CHECK(!indexer->ReadSerializedUTXOSubsets(4, 3, serialized));
+
+  snapshot::Iterator iter(std::move(indexer));
+  for (uint64_t i = 0; i < total_msgs; ++i) {
+    BOOST_CHECK(iter.MoveCursorTo(i));
+    BOOST_CHECK_EQUAL(iter.GetUTXOSubset().height, i);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -28,7 +28,7 @@ BOOST_AUTO_TEST_CASE(snapshot_iterator) {
 
       CTxOut out;
       out.nValue = 1000 + i;
-      subset.outputs[i] = out;
+      subset.outputs.emplace_back(i, out);
       idx.WriteUTXOSubset(subset);
       snapshotHash.AddUTXO(
           snapshot::UTXO(COutPoint(subset.tx_id, i), Coin(out, 0, TxType::REGULAR)));
@@ -62,7 +62,8 @@ BOOST_AUTO_TEST_CASE(snapshot_iterator) {
     uint32_t count = 0;
     while (iter.Valid()) {
       uint32_t value = 1000 + count;
-      BOOST_CHECK_EQUAL(iter.GetUTXOSubset().outputs.at(count).nValue, value);
+      BOOST_CHECK_EQUAL(iter.GetUTXOSubset().outputs.at(0).first, count);
+      BOOST_CHECK_EQUAL(iter.GetUTXOSubset().outputs.at(0).second.nValue, value);
       iter.Next();
       ++count;
     }
@@ -72,7 +73,7 @@ BOOST_AUTO_TEST_CASE(snapshot_iterator) {
     for (uint32_t i = 0; i < msgsToGenerate; ++i) {
       BOOST_CHECK(iter.MoveCursorTo(i));
       int value = 1000 + i;
-      BOOST_CHECK_EQUAL(iter.GetUTXOSubset().outputs.at(i).nValue, value);
+      BOOST_CHECK_EQUAL(iter.GetUTXOSubset().outputs.at(0).second.nValue, value);
     }
 
     // iterate via cursor moving backward
@@ -80,7 +81,7 @@ BOOST_AUTO_TEST_CASE(snapshot_iterator) {
       BOOST_CHECK(iter.MoveCursorTo(i - 1));
 
       uint32_t value = 1000 + i - 1;
-      BOOST_CHECK_EQUAL(iter.GetUTXOSubset().outputs.at(i - 1).nValue, value);
+      BOOST_CHECK_EQUAL(iter.GetUTXOSubset().outputs.at(0).second.nValue, value);
     }
   }
 }
@@ -39,7 +39,7 @@ BOOST_AUTO_TEST_CASE(utxo_subset_serializer) {
                       "expected: " << HexStr(s) << " got: " << exp);
   s.clear();
 
-  subset.outputs[2] = CTxOut();
+  subset.outputs.emplace_back(2, CTxOut());
   s << subset;
   exp =
       "aa000000000000000000000000000000"  // tx id
@@ -56,7 +56,7 @@ BOOST_AUTO_TEST_CASE(utxo_subset_serializer) {
   auto out = CTxOut();
   out.nValue = 0xcc;
   out.scriptPubKey << OP_RETURN;
-  subset.outputs[2] = out;
+  subset.outputs[0].second = out;
   s << subset;
   exp =
       "aa000000000000000000000000000000"  // tx id
@@ -177,7 +177,7 @@ BOOST_AUTO_TEST_CASE(snapshot_serialization) {
   subset.tx_id.SetHex("bb");
   CScript script;
   script << OP_RETURN;
-  subset.outputs[5] = CTxOut(5, script);
+  subset.outputs.emplace_back(5, CTxOut(5, script));
   msg.utxo_subsets.emplace_back(subset);
 
   stream.clear();
@@ -406,4 +406,56 @@ BOOST_AUTO_TEST_CASE(snapshot_hash) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(snapshot_hash_apply_batch) {
+  std::vector<snapshot::UTXO> utxos(2000);
+  for (size_t i = 0; i < utxos.size(); ++i) {
+    utxos[i].out_point.hash.SetHex(std::to_string(i + 1));
+    utxos[i].out_point.n = static_cast<uint32_t>(i);
+  }
+
+  {
+    // small batches are applied on the calling thread
+    snapshot::SnapshotHash hash1;
+    hash1.AddUTXO(utxos[0]);
+    hash1.AddUTXO(utxos[1]);
+    hash1.SubtractUTXO(utxos[2]);
+
+    snapshot::UTXOBatch batch;
+    batch.AddUTXO(utxos[0]);
+    batch.AddUTXO(utxos[1]);
+    batch.SubtractUTXO(utxos[2]);
+    BOOST_CHECK_EQUAL(batch.Size(), 3);
+
+    snapshot::SnapshotHash hash2;
+    hash2.Apply(batch);
+    BOOST_CHECK_EQUAL(hash1.GetHash(uint256(), uint256()).GetHex(),
+                      hash2.GetHash(uint256(), uint256()).GetHex());
+
+    batch.Clear();
+    BOOST_CHECK(batch.IsEmpty());
+  }
+
+  {
+    // large batches are split between threads and give the same hash
+    // as adding UTXOs one by one
+    snapshot::SnapshotHash hash1;
+    snapshot::UTXOBatch batch;
+    for (size_t i = 0; i < utxos.size(); ++i) {
+      hash1.AddUTXO(utxos[i]);
+      batch.AddUTXO(utxos[i]);
+      if (i % 3 == 0) {
+        hash1.SubtractUTXO(utxos[i / 2]);
+        batch.SubtractUTXO(utxos[i / 2]);
+      }
+    }
+
+    snapshot::SnapshotHash hash2;
+    hash2.AddUTXO(utxos[0]);
+    hash2.Apply(batch);
+    hash2.SubtractUTXO(utxos[0]);
+    BOOST_CHECK_EQUAL(hash1.GetHash(uint256(), uint256()).GetHex(),
+                      hash2.GetHash(uint256(), uint256()).GetHex());
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -45,13 +45,13 @@ class MockP2PState : public snapshot::P2PState {
   }
 };
 
-std::unique_ptr<CNode> MockNode() {
+std::unique_ptr<CNode> MockNode(const NodeId id = 0) {
   uint32_t ip = 0xa0b0c001;
   in_addr s{ip};
   CService service(CNetAddr(s), 7182);
   CAddress addr(service, NODE_NONE);
 
-  auto node = MakeUnique<CNode>(0, ServiceFlags(NODE_NETWORK | NODE_WITNESS), 0,
+  auto node = MakeUnique<CNode>(id, ServiceFlags(NODE_NETWORK | NODE_WITNESS), 0,
                                 INVALID_SOCKET, addr, 0, 0, CAddress(),
                                 "", /*fInboundIn=*/
                                 false);
@@ -61,6 +61,23 @@ std::unique_ptr<CNode> MockNode() {
   return node;
 }
 
+//! returns GetSnapshot requests sent to the node and clears its messages
+std::vector<snapshot::GetSnapshot> TakeGetSnapshot(CNode &node) {
+  std::vector<snapshot::GetSnapshot> requests;
+  BOOST_REQUIRE(node.vSendMsg.size() % 2 == 0);  // header + body
+  for (size_t i = 0; i < node.vSendMsg.size(); i += 2) {
+    CMessageHeader header(Params().MessageStart());
+    CDataStream(node.vSendMsg[i], SER_NETWORK, PROTOCOL_VERSION) >> header;
+    BOOST_CHECK_EQUAL(header.GetCommand(), "getsnapshot");
+
+    snapshot::GetSnapshot get;
+    CDataStream(node.vSendMsg[i + 1], SER_NETWORK, PROTOCOL_VERSION) >> get;
+    requests.emplace_back(get);
+  }
+  node.vSendMsg.clear();
+  return requests;
+}
+
 uint256 uint256FromUint64(uint64_t n) {
   CDataStream s(SER_DISK, PROTOCOL_VERSION);
   s << n;
@@ -104,8 +121,8 @@ BOOST_AUTO_TEST_CASE(process_snapshot) {
     snapshot::UTXOSubset subset2;
     subset1.tx_id = uint256FromUint64(i * 2);
     subset2.tx_id = uint256FromUint64(i * 2 + 1);
-    subset1.outputs[0] = CTxOut();
-    subset2.outputs[0] = CTxOut();
+    subset1.outputs.emplace_back(0, CTxOut());
+    subset2.outputs.emplace_back(0, CTxOut());
     snap.utxo_subsets.emplace_back(subset1);
     snap.utxo_subsets.emplace_back(subset2);
     snap.snapshot_hash = best_snapshot.snapshot_hash;
@@ -129,7 +146,7 @@ BOOST_AUTO_TEST_CASE(process_snapshot) {
 
       uint64_t expSize = snap.utxo_subsets.size() + (i * 2);
       BOOST_CHECK_EQUAL(get.utxo_subset_index, expSize);
-      BOOST_CHECK(get.utxo_subset_count == snapshot::MAX_UTXO_SET_COUNT);
+      BOOST_CHECK_EQUAL(get.utxo_subset_count, best_snapshot.total_utxo_subsets - expSize);
       node->vSendMsg.clear();
     } else {  // finish snapshot downloading
       BOOST_CHECK(node->vSendMsg.empty());
@@ -174,15 +191,17 @@ BOOST_AUTO_TEST_CASE(start_initial_snapshot_download) {
   snapshot::SnapshotHeader best;
   best.snapshot_hash = uint256S("a2");
   best.block_hash = b2->GetBlockHash();
+  best.total_utxo_subsets = 100000;
 
   snapshot::SnapshotHeader second_best;
   second_best.snapshot_hash = uint256S("a1");
   second_best.block_hash = b1->GetBlockHash();
+  second_best.total_utxo_subsets = 100000;
 
-  std::unique_ptr<CNode> node1(MockNode());  // no snapshot
-  std::unique_ptr<CNode> node2(MockNode());  // second best
-  std::unique_ptr<CNode> node3(MockNode());  // best
-  std::unique_ptr<CNode> node4(MockNode());  // best
+  std::unique_ptr<CNode> node1(MockNode(1));  // no snapshot
+  std::unique_ptr<CNode> node2(MockNode(2));  // second best
+  std::unique_ptr<CNode> node3(MockNode(3));  // best
+  std::unique_ptr<CNode> node4(MockNode(4));  // best
   std::vector<CNode *> nodes{node1.get(), node2.get(), node3.get(), node4.get()};
 
   // test that discovery message was sent
@@ -237,19 +256,26 @@ BOOST_AUTO_TEST_CASE(start_initial_snapshot_download) {
     BOOST_CHECK(nodes[0]->vSendMsg.empty());
     BOOST_CHECK(nodes[1]->vSendMsg.empty());
 
+    // peers download different chunks
+    uint64_t index = 0;
     std::vector<CNode *> best_nodes{nodes[2], nodes[3]};
     for (CNode *node : best_nodes) {
       BOOST_CHECK(node->m_requested_snapshot_at >= now);
-      BOOST_CHECK_EQUAL(node->vSendMsg.size(), 2);
-      CDataStream(node->vSendMsg[0], SER_NETWORK, PROTOCOL_VERSION) >> header;
-      BOOST_CHECK(header.GetCommand() == "getsnapshot");
-      snapshot::GetSnapshot get;
-      CDataStream(node->vSendMsg[1], SER_NETWORK, PROTOCOL_VERSION) >> get;
-      BOOST_CHECK_EQUAL(get.snapshot_hash.GetHex(), best.snapshot_hash.GetHex());
-      BOOST_CHECK_EQUAL(get.utxo_subset_index, 0);
-      BOOST_CHECK_EQUAL(get.utxo_subset_count, 10000);
+      const std::vector<snapshot::GetSnapshot> requests = TakeGetSnapshot(*node);
+      BOOST_CHECK_EQUAL(requests.size(), snapshot::MAX_CHUNKS_IN_FLIGHT_PER_PEER);
+      for (const snapshot::GetSnapshot &get : requests) {
+        BOOST_CHECK_EQUAL(get.snapshot_hash.GetHex(), best.snapshot_hash.GetHex());
+        BOOST_CHECK_EQUAL(get.utxo_subset_index, index);
+        BOOST_CHECK_EQUAL(get.utxo_subset_count, snapshot::INITIAL_UTXO_SET_COUNT);
+        index += get.utxo_subset_count;
+      }
+    }
 
-      node->vSendMsg.clear();
+    // no more requests while the previous ones are in flight
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      CNode &node = *nodes[i];
+      p2p_state.StartInitialSnapshotDownload(node, i, nodes.size(), msg_maker, *b2);
+      BOOST_CHECK(node.vSendMsg.empty());
     }
   }
 
@@ -277,23 +303,24 @@ BOOST_AUTO_TEST_CASE(start_initial_snapshot_download) {
     BOOST_CHECK(nodes[2]->vSendMsg.empty());
     BOOST_CHECK(nodes[3]->vSendMsg.empty());
 
-    BOOST_CHECK_EQUAL(nodes[1]->vSendMsg.size(), 2);
-    CDataStream(nodes[1]->vSendMsg[0], SER_NETWORK, PROTOCOL_VERSION) >> header;
-    BOOST_CHECK(header.GetCommand() == "getsnapshot");
-    snapshot::GetSnapshot get;
-    CDataStream(nodes[1]->vSendMsg[1], SER_NETWORK, PROTOCOL_VERSION) >> get;
-    BOOST_CHECK_EQUAL(get.snapshot_hash.GetHex(), second_best.snapshot_hash.GetHex());
-    BOOST_CHECK_EQUAL(get.utxo_subset_index, 0);
-    BOOST_CHECK_EQUAL(get.utxo_subset_count, 10000);
+    const std::vector<snapshot::GetSnapshot> requests = TakeGetSnapshot(*nodes[1]);
+    BOOST_REQUIRE(!requests.empty());
+    BOOST_CHECK_EQUAL(requests[0].snapshot_hash.GetHex(), second_best.snapshot_hash.GetHex());
+    BOOST_CHECK_EQUAL(requests[0].utxo_subset_index, 0);
+    BOOST_CHECK_EQUAL(requests[0].utxo_subset_count, snapshot::INITIAL_UTXO_SET_COUNT);
 
     // restore state
-    nodes[1]->vSendMsg.clear();
     nodes[1]->m_requested_snapshot_at = std::chrono::steady_clock::time_point::min();
     nodes[2]->m_requested_snapshot_at = std::chrono::steady_clock::now();
     nodes[3]->m_requested_snapshot_at = std::chrono::steady_clock::now();
     nodes[2]->m_best_snapshot = best;
     nodes[3]->m_best_snapshot = best;
     p2p_state.MockBestSnapshot(best);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      CNode &node = *nodes[i];
+      p2p_state.StartInitialSnapshotDownload(node, i, nodes.size(), msg_maker, *b2);
+      node.vSendMsg.clear();
+    }
   }
 
   // test that node fallbacks to second best snapshot
@@ -318,23 +345,24 @@ BOOST_AUTO_TEST_CASE(start_initial_snapshot_download) {
     BOOST_CHECK(nodes[2]->vSendMsg.empty());
     BOOST_CHECK(nodes[3]->vSendMsg.empty());
 
-    BOOST_CHECK_EQUAL(nodes[1]->vSendMsg.size(), 2);
-    CDataStream(nodes[1]->vSendMsg[0], SER_NETWORK, PROTOCOL_VERSION) >> header;
-    BOOST_CHECK(header.GetCommand() == "getsnapshot");
-    snapshot::GetSnapshot get;
-    CDataStream(nodes[1]->vSendMsg[1], SER_NETWORK, PROTOCOL_VERSION) >> get;
-    BOOST_CHECK_EQUAL(get.snapshot_hash.GetHex(), second_best.snapshot_hash.GetHex());
-    BOOST_CHECK_EQUAL(get.utxo_subset_index, 0);
-    BOOST_CHECK_EQUAL(get.utxo_subset_count, 10000);
+    const std::vector<snapshot::GetSnapshot> requests = TakeGetSnapshot(*nodes[1]);
+    BOOST_REQUIRE(!requests.empty());
+    BOOST_CHECK_EQUAL(requests[0].snapshot_hash.GetHex(), second_best.snapshot_hash.GetHex());
+    BOOST_CHECK_EQUAL(requests[0].utxo_subset_index, 0);
+    BOOST_CHECK_EQUAL(requests[0].utxo_subset_count, snapshot::INITIAL_UTXO_SET_COUNT);
 
     // restore state
-    nodes[1]->vSendMsg.clear();
     nodes[1]->m_requested_snapshot_at = std::chrono::steady_clock::time_point::min();
     nodes[2]->m_requested_snapshot_at = std::chrono::steady_clock::now();
     nodes[3]->m_requested_snapshot_at = std::chrono::steady_clock::now();
     nodes[2]->m_best_snapshot = best;
     nodes[3]->m_best_snapshot = best;
     p2p_state.MockBestSnapshot(best);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      CNode &node = *nodes[i];
+      p2p_state.StartInitialSnapshotDownload(node, i, nodes.size(), msg_maker, *b2);
+      node.vSendMsg.clear();
+    }
   }
 
   // test that node does't disable ISD until timeout elapsed
@@ -261,4 +261,17 @@ BOOST_AUTO_TEST_CASE(extract_block_signing_key_p2wsh_witness_script_malformed_mi
   });
 }
 
+BOOST_AUTO_TEST_CASE(kernel_hasher_matches_compute_kernel_hash) {
+  const uint256 stake_modifier = uint256S("d0c1b0d3f0d9e6c3a8c5e1b8a1f2e3d4c5b6a798877665544332211000ffeedd");
+  const blockchain::Time target_time = 1548316816;
+  staking::KernelHasher hasher(stake_modifier, target_time);
+
+  for (std::uint32_t i = 0; i < 10; ++i) {
+    const uint256 txid = GetRandHash();
+    const blockchain::Time stake_time = target_time - 1000 * i;
+    BOOST_CHECK_EQUAL(hasher(stake_time, txid, i),
+                      staking::ComputeKernelHash(stake_modifier, stake_time, txid, i, target_time));
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -249,6 +249,13 @@ class StakeValidatorMock : public staking::StakeValidator, public Mock {
   uint256 ComputeKernelHash(const CBlockIndex *blockindex, const staking::Coin &coin, blockchain::Time time) const override {
     return mock_ComputeKernelHash(blockindex, coin, time);
   }
+  std::vector<uint256> ComputeKernelHashes(const CBlockIndex *blockindex, const std::vector<const staking::Coin *> &coins, blockchain::Time time) const override {
+    std::vector<uint256> kernel_hashes;
+    for (const staking::Coin *coin : coins) {
+      kernel_hashes.emplace_back(mock_ComputeKernelHash(blockindex, *coin, time));
+    }
+    return kernel_hashes;
+  }
   uint256 ComputeStakeModifier(const CBlockIndex *blockindex, const staking::Coin &coin) const override {
     return mock_ComputeStakeModifier(blockindex, coin);
   }
@@ -371,8 +378,8 @@ class ProposerLogicMock : public proposer::Logic, public Mock {
  public:
   MethodMock<decltype(&proposer::Logic::TryPropose)> mock_TryPropose{this, boost::none};
 
-  boost::optional<proposer::EligibleCoin> TryPropose(const staking::CoinSet &coin_set) override {
-    return mock_TryPropose(coin_set);
+  boost::optional<proposer::EligibleCoin> TryPropose(const staking::CoinSet &coin_set, const CBlockIndex &tip) override {
+    return mock_TryPropose(coin_set, tip);
   }
 };
 
@@ -380,10 +387,14 @@ class TransactionPickerMock : public staking::TransactionPicker, public Mock {
 
  public:
   MethodMock<decltype(&staking::TransactionPicker::PickTransactions)> mock_PickTransactions{this, {"", {}, {}}};
+  MethodMock<decltype(&staking::TransactionPicker::GetTransactionsUpdated)> mock_GetTransactionsUpdated{this, 0};
 
   PickTransactionsResult PickTransactions(const PickTransactionsParameters &parameters) override {
     return mock_PickTransactions(parameters);
   }
+  unsigned int GetTransactionsUpdated() const override {
+    return mock_GetTransactionsUpdated();
+  }
 };
 
 class BlockBuilderMock : public proposer::BlockBuilder, public Mock {
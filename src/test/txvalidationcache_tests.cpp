@@ -13,11 +13,15 @@
 #include <core_io.h>
 #include <keystore.h>
 #include <policy/policy.h>
+#include <injector.h>
+#include <finalization/state_repository.h>
+#include <script/sigcache.h>
 
 #include <boost/test/unit_test.hpp>
 #include <wallet/test/wallet_test_fixture.h>
 
 bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsViewCache &inputs, bool fScriptChecks, unsigned int flags, bool cacheSigStore, bool cacheFullScriptStore, PrecomputedTransactionData& txdata, std::vector<CScriptCheck> *pvChecks);
+bool CheckVoteScripts(const CBlock& block, CValidationState& state, const CCoinsViewCache& view, unsigned int flags, bool fJustCheck, std::vector<bool>& scripts_checked);
 
 BOOST_AUTO_TEST_SUITE(tx_validationcache_tests)
 
@@ -425,4 +429,99 @@ BOOST_FIXTURE_TEST_CASE(checkinputs_test, TestChain100Setup)
     }
 }
 
+
+// Whether the signature of the single input of vote_tx is in the signature cache
+static bool IsVoteInputSigCached(const CTransaction &vote_tx, const CTxOut &prev_out, const CPubKey &pubkey)
+{
+    CScript::const_iterator pc = vote_tx.vin[0].scriptSig.begin();
+    opcodetype opcode;
+    std::vector<unsigned char> tx_sig;
+    BOOST_REQUIRE(vote_tx.vin[0].scriptSig.GetOp(pc, opcode, tx_sig) && !tx_sig.empty());
+    const uint256 sighash = SignatureHash(prev_out.scriptPubKey, vote_tx, 0, tx_sig.back(), prev_out.nValue, SigVersion::BASE);
+    tx_sig.pop_back();
+    return IsSignatureCached(sighash, tx_sig, pubkey);
+}
+
+// Whether the vote signature of vote_tx is in the signature cache
+static bool IsVoteSigCached(const CTransaction &vote_tx, const CPubKey &pubkey)
+{
+    esperanza::Vote vote;
+    std::vector<unsigned char> vote_sig;
+    BOOST_REQUIRE(CScript::ExtractVoteFromVoteSignature(vote_tx.vin[0].scriptSig, vote, vote_sig));
+    return IsSignatureCached(vote.GetHash(), vote_sig, pubkey);
+}
+
+BOOST_FIXTURE_TEST_CASE(connect_block_checks_votes_ahead, TestChain100Setup)
+{
+    // ConnectBlock runs the script checks of votes on the script check threads
+    // before the finalizer commit checks. These must only leave the vote
+    // signature in the signature cache, the votes must not be checked again
+    // with the rest of the block, and nothing of the vote must stay cached
+    // once the block is connected.
+    BOOST_REQUIRE(nScriptCheckThreads > 0);
+
+    const CScript coinbase_script = GetScriptForDestination(WitnessV0KeyHash(coinbaseKey.GetPubKey().GetID()));
+    const CPubKey finalizer_pubkey = coinbaseKey.GetPubKey();
+    esperanza::WalletExtension &wallet_ext = m_wallet->GetWalletExtension();
+    {
+        LOCK(m_wallet->cs_wallet);
+        wallet_ext.nIsValidatorEnabled = true;
+        wallet_ext.validatorState.emplace();
+    }
+
+    CTransactionRef deposit;
+    BOOST_REQUIRE(wallet_ext.SendDeposit(finalizer_pubkey.GetID(), 1500 * UNIT, deposit));
+    CreateAndProcessBlock({CMutableTransaction(*deposit)}, coinbase_script);
+
+    // Wait for the deposit to become active and the finalizer to vote
+    esperanza::Vote vote;
+    CTransactionRef prev_tx;
+    bool vote_due = false;
+    for (int i = 0; i < 50 && !vote_due; ++i) {
+        CreateAndProcessBlock({}, coinbase_script);
+        auto repo = GetComponent<finalization::StateRepository>();
+        LOCK2(cs_main, m_wallet->cs_wallet);
+        LOCK(repo->GetLock());
+        vote_due = wallet_ext.PrepareVote(*repo->GetTipState(), *chainActive.Tip(), vote, prev_tx);
+    }
+    BOOST_REQUIRE(vote_due);
+    BOOST_REQUIRE(prev_tx->GetHash() == deposit->GetHash());
+
+    CTransactionRef vote_tx;
+    BOOST_REQUIRE(wallet_ext.SignVote(prev_tx, vote, vote_tx));
+    const CTxOut &prev_out = prev_tx->vout[0];
+    BOOST_CHECK(!IsVoteSigCached(*vote_tx, finalizer_pubkey));
+    BOOST_CHECK(!IsVoteInputSigCached(*vote_tx, prev_out, finalizer_pubkey));
+
+    const std::shared_ptr<const CBlock> block = CreateBlock({CMutableTransaction(*vote_tx)}, coinbase_script);
+    {
+        LOCK(cs_main);
+        BOOST_REQUIRE(!IsInitialBlockDownload());
+
+        CCoinsViewCache view(pcoinsTip.get());
+        BOOST_REQUIRE(view.HaveInputs(*vote_tx));
+
+        std::vector<bool> scripts_checked(block->vtx.size(), false);
+        CValidationState state;
+        const unsigned int flags = SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_DERSIG | SCRIPT_VERIFY_WITNESS | SCRIPT_VERIFY_NULLDUMMY;
+        BOOST_CHECK(CheckVoteScripts(*block, state, view, flags, /* fJustCheck */ false, scripts_checked));
+
+        // Only the vote is checked ahead, ConnectBlock leaves it out of the
+        // script checks of the other transactions.
+        for (size_t i = 0; i < block->vtx.size(); ++i) {
+            BOOST_CHECK_EQUAL(scripts_checked[i], block->vtx[i]->GetHash() == vote_tx->GetHash());
+        }
+        BOOST_CHECK(IsVoteSigCached(*vote_tx, finalizer_pubkey));
+        BOOST_CHECK(!IsVoteInputSigCached(*vote_tx, prev_out, finalizer_pubkey));
+    }
+
+    BOOST_REQUIRE(ProcessBlock(block));
+    {
+        LOCK(cs_main);
+        BOOST_CHECK(chainActive.Tip()->GetBlockHash() == block->GetHash());
+    }
+    BOOST_CHECK(!IsVoteSigCached(*vote_tx, finalizer_pubkey));
+    BOOST_CHECK(!IsVoteInputSigCached(*vote_tx, prev_out, finalizer_pubkey));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
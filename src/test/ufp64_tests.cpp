@@ -4,11 +4,46 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <arith_uint256.h>
+#include <random.h>
 #include <ufp64.h>
 #include <util.h>
 
 using namespace ufp64;
 
+namespace {
+
+//! The arith_uint256 based implementation ufp64 used to have, as a reference.
+namespace reference
+{
+const int SCALE = 100000000;
+
+ufp64_t mul(ufp64_t x, ufp64_t y) { return ((arith_uint256(x) * arith_uint256(y)) / SCALE).GetLow64(); }
+ufp64_t mul_by_uint(ufp64_t x, uint64_t y) { return (arith_uint256(x) * arith_uint256(y)).GetLow64(); }
+ufp64_t div_2uint(uint64_t x, uint64_t y) { return ((arith_uint256(x) * SCALE) / y).GetLow64(); }
+ufp64_t div_by_uint(ufp64_t x, uint64_t y) { return (arith_uint256(x) / y).GetLow64(); }
+ufp64_t div_uint(uint64_t x, ufp64_t y) { return (arith_uint256(x) * SCALE * SCALE / y).GetLow64(); }
+ufp64_t div(ufp64_t x, ufp64_t y) { return (arith_uint256(x) * SCALE / y).GetLow64(); }
+
+ufp64_t sqrt_uint(uint64_t x)
+{
+    const arith_uint256 y = arith_uint256(x) * SCALE * SCALE;
+    arith_uint256 sqrt = y / 2;
+    for (int i = 0; i < 60; i++) {
+        sqrt = (sqrt + (y / sqrt)) / 2;
+    }
+    return sqrt.GetLow64();
+}
+} // namespace reference
+
+//! Random values of all magnitudes, so that small and overflowing results are both covered.
+uint64_t RandValue(FastRandomContext& random)
+{
+    return random.rand64() >> random.randrange(64);
+}
+
+} // namespace
+
 BOOST_AUTO_TEST_SUITE(ufp64_tests)
 
 BOOST_AUTO_TEST_CASE(to_str_test)
@@ -162,4 +197,46 @@ BOOST_AUTO_TEST_CASE(sqrt_uint_test)
     BOOST_CHECK_EQUAL("1000000000", to_str(sqrt_uint(1000000000000000000)));
 }
 
+BOOST_AUTO_TEST_CASE(same_as_uint256_test)
+{
+    FastRandomContext random(true);
+    for (int i = 0; i < 100000; ++i) {
+        const uint64_t x = RandValue(random);
+        const uint64_t y = RandValue(random) | 1;
+
+        BOOST_CHECK_EQUAL(reference::mul(x, y), mul(x, y));
+        BOOST_CHECK_EQUAL(reference::mul_by_uint(x, y), mul_by_uint(x, y));
+        BOOST_CHECK_EQUAL(reference::mul(x, y), mul_to_uint(x, y));
+        BOOST_CHECK_EQUAL(reference::div_2uint(x, y), div_2uint(x, y));
+        BOOST_CHECK_EQUAL(reference::div_by_uint(x, y), div_by_uint(x, y));
+        BOOST_CHECK_EQUAL(reference::div_uint(x, y), div_uint(x, y));
+        BOOST_CHECK_EQUAL(reference::div(x, y), div_to_uint(x, y));
+        BOOST_CHECK_EQUAL(reference::div(x, y), div(x, y));
+    }
+
+    BOOST_CHECK_THROW(div(1, 0), uint_error);
+    BOOST_CHECK_THROW(div_2uint(1, 0), uint_error);
+    BOOST_CHECK_THROW(div_by_uint(1, 0), uint_error);
+    BOOST_CHECK_THROW(div_uint(1, 0), uint_error);
+    BOOST_CHECK_THROW(div_to_uint(1, 0), uint_error);
+}
+
+BOOST_AUTO_TEST_CASE(sqrt_uint_same_as_uint256_test)
+{
+    // Small values exhaustively, then random ones of all magnitudes
+    for (uint64_t x = 1; x < 10000; ++x) {
+        BOOST_CHECK_EQUAL(reference::sqrt_uint(x), sqrt_uint(x));
+    }
+
+    FastRandomContext random(true);
+    for (int i = 0; i < 2000; ++i) {
+        const uint64_t x = RandValue(random) | 1;
+        BOOST_CHECK_EQUAL(reference::sqrt_uint(x), sqrt_uint(x));
+    }
+
+    const uint64_t max = std::numeric_limits<uint64_t>::max();
+    BOOST_CHECK_EQUAL(reference::sqrt_uint(max), sqrt_uint(max));
+    BOOST_CHECK_THROW(sqrt_uint(0), uint_error);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,184 @@
+// Copyright (c) 2019 The Unit-e developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <util/persistent_map.h>
+
+#include <random.h>
+#include <streams.h>
+#include <version.h>
+
+#include <test/test_unite.h>
+#include <boost/test/unit_test.hpp>
+
+#include <map>
+
+BOOST_FIXTURE_TEST_SUITE(persistent_map_tests, ReducedTestingSetup)
+
+namespace {
+
+using Map = util::PersistentMap<uint32_t, uint64_t>;
+
+void CheckSame(const Map &map, const std::map<uint32_t, uint64_t> &expected) {
+  BOOST_REQUIRE_EQUAL(map.size(), expected.size());
+  auto expected_it = expected.begin();
+  for (const auto &entry : map) {
+    BOOST_CHECK_EQUAL(entry.first, expected_it->first);
+    BOOST_CHECK_EQUAL(entry.second, expected_it->second);
+    ++expected_it;
+  }
+  BOOST_CHECK(expected_it == expected.end());
+}
+
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(basic_operations) {
+  Map map;
+  BOOST_CHECK(map.empty());
+  BOOST_CHECK(map.begin() == map.end());
+  BOOST_CHECK(map.find(1) == map.end());
+
+  map[5] = 50;
+  map[1] = 10;
+  BOOST_CHECK(map.emplace(3, 30).second);
+  BOOST_CHECK(!map.emplace(3, 31).second);
+  BOOST_CHECK(map.insert(std::make_pair(7, 70)).second);
+
+  CheckSame(map, {{1, 10}, {3, 30}, {5, 50}, {7, 70}});
+
+  BOOST_CHECK_EQUAL(map.at(3), 30);
+  BOOST_CHECK_THROW(map.at(4), std::out_of_range);
+  BOOST_CHECK(map.find_mutable(4) == nullptr);
+  *map.find_mutable(5) = 55;
+  map.at(7) = 77;
+
+  auto it = map.find(3);
+  BOOST_REQUIRE(it != map.end());
+  BOOST_CHECK_EQUAL(it->second, 30);
+  ++it;
+  BOOST_CHECK_EQUAL(it->first, 5);
+  BOOST_CHECK_EQUAL(it->second, 55);
+
+  BOOST_CHECK_EQUAL(map.erase(4), 0);
+  BOOST_CHECK_EQUAL(map.erase(1), 1);
+  BOOST_CHECK_EQUAL(map.count(1), 0);
+  CheckSame(map, {{3, 30}, {5, 55}, {7, 77}});
+
+  map.clear();
+  BOOST_CHECK(map.empty());
+}
+
+BOOST_AUTO_TEST_CASE(copies_are_independent) {
+  Map parent;
+  for (uint32_t i = 0; i < 1000; ++i) {
+    parent[i] = i;
+  }
+  Map child = parent;
+  BOOST_CHECK(child == parent);
+
+  child[500] = 0;
+  child.erase(10);
+  child[2000] = 2000;
+  parent[600] = 0;
+
+  BOOST_CHECK(child != parent);
+  BOOST_CHECK_EQUAL(parent.at(500), 500);
+  BOOST_CHECK_EQUAL(parent.count(10), 1);
+  BOOST_CHECK_EQUAL(parent.count(2000), 0);
+  BOOST_CHECK_EQUAL(child.at(500), 0);
+  BOOST_CHECK_EQUAL(child.at(600), 600);
+  BOOST_CHECK_EQUAL(child.count(10), 0);
+  BOOST_CHECK_EQUAL(parent.size(), 1000);
+  BOOST_CHECK_EQUAL(child.size(), 1000);
+}
+
+BOOST_AUTO_TEST_CASE(random_operations) {
+  // Apply the same operations on a std::map and on a chain of persistent maps
+  // and check that every generation still holds what it held when copied.
+  std::vector<std::map<uint32_t, uint64_t>> expected(1);
+  std::vector<Map> generations(1);
+
+  for (int generation = 0; generation < 50; ++generation) {
+    std::map<uint32_t, uint64_t> next_expected = expected.back();
+    Map next = generations.back();
+    for (int i = 0; i < 200; ++i) {
+      const uint32_t key = InsecureRandRange(500);
+      switch (InsecureRandRange(3)) {
+        case 0:
+          next[key] = InsecureRand32();
+          next_expected[key] = next.at(key);
+          break;
+        case 1:
+          BOOST_CHECK_EQUAL(next.erase(key), next_expected.erase(key));
+          break;
+        case 2:
+          BOOST_CHECK_EQUAL(next.emplace(key, i).second, next_expected.emplace(key, i).second);
+          break;
+      }
+    }
+    expected.emplace_back(std::move(next_expected));
+    generations.emplace_back(std::move(next));
+  }
+
+  for (size_t i = 0; i < generations.size(); ++i) {
+    CheckSame(generations[i], expected[i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(diff_and_apply) {
+  Map base;
+  for (uint32_t i = 0; i < 1000; ++i) {
+    base[i] = i;
+  }
+  BOOST_CHECK(base.Diff(base).empty());
+
+  Map target = base;
+  target[10] = 0;
+  target[2000] = 2000;
+  target.erase(500);
+  target[20] = 20;
+
+  const Map::Delta delta = base.Diff(target);
+  BOOST_CHECK_EQUAL(delta.upserts.size(), 2);
+  BOOST_CHECK_EQUAL(delta.erasures.size(), 1);
+
+  CDataStream stream(SER_DISK, PROTOCOL_VERSION);
+  stream << delta;
+  Map::Delta deserialized;
+  stream >> deserialized;
+
+  Map applied = base;
+  applied.Apply(deserialized);
+  BOOST_CHECK(applied == target);
+
+  // Unrelated maps with the same content have no differences either.
+  Map copy;
+  for (const auto &entry : target) {
+    copy[entry.first] = entry.second;
+  }
+  BOOST_CHECK(copy.Diff(target).empty());
+}
+
+BOOST_AUTO_TEST_CASE(serialization) {
+  Map map;
+  std::map<uint32_t, uint64_t> std_map;
+  for (uint32_t i = 0; i < 100; ++i) {
+    const uint32_t key = InsecureRand32();
+    map[key] = i;
+    std_map[key] = i;
+  }
+
+  CDataStream persistent_stream(SER_NETWORK, PROTOCOL_VERSION);
+  persistent_stream << map;
+  CDataStream std_stream(SER_NETWORK, PROTOCOL_VERSION);
+  std_stream << std_map;
+  BOOST_CHECK(persistent_stream.str() == std_stream.str());
+
+  Map deserialized;
+  deserialized[1] = 1;
+  persistent_stream >> deserialized;
+  BOOST_CHECK(deserialized == map);
+  CheckSame(deserialized, std_map);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -20,21 +20,24 @@ class TxPoolEnumeratorImpl : public TxPool {
     return mempool.size() + mapOrphanTransactions.size();
   }
 
-  std::vector<CTransactionRef> GetTxs() const override {
+  void ForEachTx(const std::function<bool(const uint256 &)> &filter,
+                 const std::function<void(const CTransactionRef &)> &visit) const override {
     LOCK2(g_cs_orphans, mempool.cs);
 
-    std::vector<CTransactionRef> result;
-    result.reserve(GetTxCount());
-
-    for (const auto &entry : mempool.mapTx) {
-      result.emplace_back(entry.GetSharedTx());
+    // vTxHashes keeps the witness hashes of mempool transactions contiguously
+    // so the ones which don't pass the filter are skipped without reading
+    // their entries
+    for (const auto &entry : mempool.vTxHashes) {
+      if (filter(entry.first)) {
+        visit(entry.second->GetSharedTx());
+      }
     }
 
     for (const auto &entry : mapOrphanTransactions) {
-      result.emplace_back(entry.second.tx);
+      if (filter(entry.second.tx->GetWitnessHash())) {
+        visit(entry.second.tx);
+      }
     }
-
-    return result;
   }
 };
 
@@ -6,12 +6,24 @@
 #define UNITE_TXPOOL_H
 
 #include <primitives/transaction.h>
+#include <uint256.h>
+
+#include <functional>
 
 //! \brief Interface that wraps access to both mempool and orphanpool
 class TxPool {
  public:
   virtual size_t GetTxCount() const = 0;
-  virtual std::vector<CTransactionRef> GetTxs() const = 0;
+
+  //! \brief Enumerates the transactions of the pool without copying them.
+  //!
+  //! \p filter is invoked with the witness hash of every transaction, which
+  //! is read without touching the transaction itself. \p visit is invoked only
+  //! with the transactions which passed the filter. The pool is locked while
+  //! enumerating so the callbacks must not access it.
+  virtual void ForEachTx(const std::function<bool(const uint256 &)> &filter,
+                         const std::function<void(const CTransactionRef &)> &visit) const = 0;
+
   virtual ~TxPool() = default;
 
   static std::unique_ptr<TxPool> New();
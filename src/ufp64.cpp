@@ -9,12 +9,38 @@ static const int SCALE = 100000000;
 /**
  * This namespace implements support for fixed-point arithmetics as ufp64 is a fixed-point number represented with 64
  * bits. Be aware that the precision for the decimal part is 10E8 and the integer part up 10E11. While all internal and
- * intermediate operation results make use of a uint256, the result can overflow nonetheless.
+ * intermediate operation results make use of a wider integer, the result can overflow nonetheless.
  */
 namespace ufp64
 {
 static const int SQRT_ITERATIONS = 60;
 
+// Intermediate results never exceed 128 bits (at most a 64 bit value times SCALE^2), so the native 128 bit integer is
+// used where the compiler has one. Results are the same as with arith_uint256, including the exception on a division
+// by zero.
+#ifdef __SIZEOF_INT128__
+typedef unsigned __int128 wide_t;
+
+static inline uint64_t low64(wide_t x)
+{
+    return static_cast<uint64_t>(x);
+}
+#else
+typedef arith_uint256 wide_t;
+
+static inline uint64_t low64(const wide_t& x)
+{
+    return x.GetLow64();
+}
+#endif
+
+static inline void check_divisor(uint64_t y)
+{
+    if (y == 0) {
+        throw uint_error("Division by zero");
+    }
+}
+
 ufp64_t add_uint(ufp64_t ufp, uint32_t uint)
 {
     return (uint * SCALE) + ufp;
@@ -22,53 +48,47 @@ ufp64_t add_uint(ufp64_t ufp, uint32_t uint)
 
 ufp64_t mul(ufp64_t x, ufp64_t y)
 {
-    arith_uint256 x1(x);
-    arith_uint256 y1(y);
-    return ((x1 * y1) / SCALE).GetLow64();
+    return low64(wide_t(x) * wide_t(y) / SCALE);
 }
 
 ufp64_t mul_by_uint(ufp64_t x, uint64_t y)
 {
-    arith_uint256 x1(x);
-    arith_uint256 y1(y);
-    return (x1 * y1).GetLow64();
+    return x * y;
 }
 
 uint64_t mul_to_uint(ufp64_t x, uint64_t y)
 {
-    arith_uint256 x1(x);
-    arith_uint256 y1(y);
-    return ((x1 * y1) / SCALE).GetLow64();
+    return low64(wide_t(x) * wide_t(y) / SCALE);
 }
 
 ufp64_t div_2uint(uint64_t x, uint64_t y)
 {
-    arith_uint256 x1(x);
-    return ((x1 * SCALE) / y).GetLow64();
+    check_divisor(y);
+    return low64(wide_t(x) * SCALE / wide_t(y));
 }
 
 ufp64_t div_by_uint(ufp64_t x, uint64_t y)
 {
-    arith_uint256 x1(x);
-    return (x1 / y).GetLow64();
+    check_divisor(y);
+    return x / y;
 }
 
 ufp64_t div_uint(uint64_t x, ufp64_t y)
 {
-    arith_uint256 x1(x);
-    return (x1 * SCALE * SCALE / y).GetLow64();
+    check_divisor(y);
+    return low64(wide_t(x) * SCALE * SCALE / wide_t(y));
 }
 
 ufp64_t div_to_uint(uint64_t x, ufp64_t y)
 {
-    arith_uint256 x1(x);
-    return (x1 * SCALE / y).GetLow64();
+    check_divisor(y);
+    return low64(wide_t(x) * SCALE / wide_t(y));
 }
 
 ufp64_t div(ufp64_t x, ufp64_t y)
 {
-    arith_uint256 x1(x);
-    return (x1 * SCALE / y).GetLow64();
+    check_divisor(y);
+    return low64(wide_t(x) * SCALE / wide_t(y));
 }
 
 ufp64_t add(ufp64_t x, ufp64_t y)
@@ -93,15 +113,23 @@ ufp64_t max(ufp64_t x, ufp64_t y)
 
 ufp64_t sqrt_uint(uint64_t x)
 {
-    arith_uint256 y(x);
-    y = y * SCALE * SCALE; //Since we are going to sqrt the input, we should scale it by SCALE^2
+    check_divisor(x);
+    const wide_t y = wide_t(x) * SCALE * SCALE; //Since we are going to sqrt the input, we should scale it by SCALE^2
 
-    //Using Babylonian algorithm to calculate the sqrt
-    arith_uint256 sqrt = y / 2;
+    //Using Babylonian algorithm to calculate the sqrt. The estimate decreases until it reaches the integer square root,
+    //from there on it either stays or alternates with the next integer, so the remaining iterations are skipped.
+    wide_t sqrt = y / 2;
     for (int i = 0; i < SQRT_ITERATIONS; i++) {
-        sqrt = (sqrt + (y / sqrt)) / 2;
+        const wide_t next = (sqrt + (y / sqrt)) / 2;
+        if (next == sqrt) {
+            break;
+        }
+        if (next > sqrt) {
+            return low64((SQRT_ITERATIONS - i) % 2 == 1 ? next : sqrt);
+        }
+        sqrt = next;
     }
-    return sqrt.GetLow64();
+    return low64(sqrt);
 }
 
 uint64_t to_uint(ufp64_t x)
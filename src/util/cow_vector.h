@@ -0,0 +1,98 @@
+// Copyright (c) 2019 The Unit-e developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef UNITE_UTIL_COW_VECTOR_H
+#define UNITE_UTIL_COW_VECTOR_H
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+//! \brief A vector whose copies share their elements until they are modified.
+//!
+//! The elements are stored in fixed size pages which are reference counted.
+//! Copying the vector copies the page pointers only, one per PAGE_SIZE
+//! elements. Modifying an element copies the page it is on if that page is
+//! still shared with another vector, pages owned exclusively are modified in
+//! place.
+//!
+//! Elements are accessed by index, the vector only grows at the end.
+//!
+//! Like std::vector the container is not thread safe. But, as shared pages are
+//! never modified, vectors which share pages can be used from different threads.
+template <typename T, std::size_t PAGE_SIZE = 64>
+class CowVector {
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+
+ private:
+  using Page = std::array<T, PAGE_SIZE>;
+  using PagePtr = std::shared_ptr<Page>;
+
+ public:
+  size_type size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+
+  const T &operator[](const size_type index) const {
+    assert(index < m_size);
+    return (*m_pages[index / PAGE_SIZE])[index % PAGE_SIZE];
+  }
+
+  //! \brief Returns a modifiable reference to the element at index.
+  //!
+  //! The page holding the element is detached from other vectors, so that the
+  //! modification is not visible to them. The reference is invalidated by the
+  //! next modification of the vector.
+  T &at_mutable(const size_type index) {
+    assert(index < m_size);
+    PagePtr &page = m_pages[index / PAGE_SIZE];
+    Detach(page);
+    return (*page)[index % PAGE_SIZE];
+  }
+
+  void push_back(T value) {
+    if (m_size % PAGE_SIZE == 0) {
+      m_pages.emplace_back(std::make_shared<Page>());
+    } else {
+      Detach(m_pages.back());
+    }
+    (*m_pages.back())[m_size % PAGE_SIZE] = std::move(value);
+    ++m_size;
+  }
+
+  void clear() {
+    m_pages.clear();
+    m_size = 0;
+  }
+
+  //! \brief Returns whether the element at index is on a page shared with other.
+  //!
+  //! Elements on shared pages are known to be equal, which allows to skip
+  //! whole pages when comparing vectors which have been copied from each other.
+  bool SharesPage(const CowVector &other, const size_type index) const {
+    const size_type page = index / PAGE_SIZE;
+    return page < m_pages.size() && page < other.m_pages.size() &&
+           m_pages[page] == other.m_pages[page];
+  }
+
+ private:
+  static void Detach(PagePtr &page) {
+    if (page.use_count() != 1) {
+      page = std::make_shared<Page>(*page);
+    }
+  }
+
+  std::vector<PagePtr> m_pages;
+  size_type m_size = 0;
+};
+
+}  // namespace util
+
+#endif  // UNITE_UTIL_COW_VECTOR_H
@@ -0,0 +1,478 @@
+// Copyright (c) 2019 The Unit-e developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef UNITE_UTIL_PERSISTENT_MAP_H
+#define UNITE_UTIL_PERSISTENT_MAP_H
+
+#include <serialize.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace util {
+
+//! \brief An ordered map whose copies share structure with each other.
+//!
+//! PersistentMap is an AVL tree with reference counted nodes. Copying a map is
+//! O(1): the copy just points to the same root. A modification copies only the
+//! nodes on the path from the root to the modified entry (O(log n)), every other
+//! node stays shared with all the maps it has been copied from or to. Nodes which
+//! are owned exclusively by one map are modified in place.
+//!
+//! The interface mirrors the subset of std::map which is needed to be a drop-in
+//! replacement. Iteration is read-only, values are modified through at(),
+//! operator[] or find_mutable() which take care of detaching the touched nodes.
+//!
+//! The serialized representation is the same as the one of std::map.
+//!
+//! Like std::map the container is not thread safe. But, as shared nodes are
+//! never modified, maps which share nodes can be used from different threads.
+template <typename K, typename V, typename Compare = std::less<K>>
+class PersistentMap {
+ public:
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = std::pair<const K, V>;
+  using size_type = std::size_t;
+
+ private:
+  struct Node;
+  using NodePtr = std::shared_ptr<Node>;
+
+  struct Node {
+    value_type value;
+    NodePtr left;
+    NodePtr right;
+    int height = 1;
+
+    Node(const K &key, V &&mapped) : value(key, std::move(mapped)) {}
+  };
+
+  //! An AVL tree with 2^32 entries is at most 46 levels deep.
+  static constexpr std::size_t MAX_DEPTH = 64;
+
+ public:
+  //! \brief In-order iterator over the entries of the map.
+  //!
+  //! Keeps the path to the current node on a fixed size stack, so that neither
+  //! creating nor advancing an iterator allocates. An iterator is invalidated by
+  //! any modification of the map it was obtained from.
+  class const_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = PersistentMap::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type *;
+    using reference = const value_type &;
+
+    const_iterator() = default;
+
+    reference operator*() const { return Top()->value; }
+    pointer operator->() const { return &Top()->value; }
+
+    const_iterator &operator++() {
+      const Node *node = Top();
+      --m_depth;
+      PushLeftSpine(node->right.get());
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    bool operator==(const const_iterator &other) const {
+      if (m_depth == 0 || other.m_depth == 0) {
+        return m_depth == other.m_depth;
+      }
+      return Top() == other.Top();
+    }
+    bool operator!=(const const_iterator &other) const { return !(*this == other); }
+
+   private:
+    friend class PersistentMap;
+
+    //! Advances past the right subtree of the current node without visiting it.
+    void SkipRightSubtree() {
+      assert(m_depth > 0);
+      --m_depth;
+    }
+
+    const Node *Top() const {
+      assert(m_depth > 0);
+      return m_stack[m_depth - 1];
+    }
+
+    void Push(const Node *node) {
+      assert(m_depth < MAX_DEPTH);
+      m_stack[m_depth++] = node;
+    }
+
+    void PushLeftSpine(const Node *node) {
+      for (; node != nullptr; node = node->left.get()) {
+        Push(node);
+      }
+    }
+
+    std::array<const Node *, MAX_DEPTH> m_stack;
+    std::size_t m_depth = 0;
+  };
+
+  using iterator = const_iterator;
+
+  //! \brief The changes which turn one map into another, see Diff() and Apply().
+  struct Delta {
+    std::vector<std::pair<K, V>> upserts;
+    std::vector<K> erasures;
+
+    bool empty() const { return upserts.empty() && erasures.empty(); }
+
+    ADD_SERIALIZE_METHODS
+
+    template <typename Stream, typename Operation>
+    void SerializationOp(Stream &s, Operation ser_action) {
+      READWRITE(upserts);
+      READWRITE(erasures);
+    }
+  };
+
+  PersistentMap() = default;
+  PersistentMap(const PersistentMap &) = default;
+  PersistentMap(PersistentMap &&other) noexcept
+      : m_root(std::move(other.m_root)), m_size(other.m_size) {
+    other.m_size = 0;
+  }
+  PersistentMap &operator=(const PersistentMap &) = default;
+  PersistentMap &operator=(PersistentMap &&other) noexcept {
+    m_root = std::move(other.m_root);
+    m_size = other.m_size;
+    other.m_size = 0;
+    return *this;
+  }
+
+  size_type size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+
+  const_iterator begin() const {
+    const_iterator it;
+    it.PushLeftSpine(m_root.get());
+    return it;
+  }
+  const_iterator end() const { return const_iterator(); }
+
+  const_iterator find(const K &key) const {
+    const_iterator it;
+    const Node *node = m_root.get();
+    while (node != nullptr) {
+      if (m_compare(key, node->value.first)) {
+        // This node is the successor of everything in its left subtree.
+        it.Push(node);
+        node = node->left.get();
+      } else if (m_compare(node->value.first, key)) {
+        node = node->right.get();
+      } else {
+        it.Push(node);
+        return it;
+      }
+    }
+    return end();
+  }
+
+  size_type count(const K &key) const { return FindNode(key) != nullptr ? 1 : 0; }
+
+  const V &at(const K &key) const {
+    const Node *node = FindNode(key);
+    if (node == nullptr) {
+      throw std::out_of_range("PersistentMap::at");
+    }
+    return node->value.second;
+  }
+
+  V &at(const K &key) {
+    V *value = find_mutable(key);
+    if (value == nullptr) {
+      throw std::out_of_range("PersistentMap::at");
+    }
+    return *value;
+  }
+
+  //! \brief Returns a modifiable pointer to the value stored for key or nullptr.
+  //!
+  //! The nodes on the path to the entry are detached from other maps, so that
+  //! the modification is not visible to them.
+  V *find_mutable(const K &key) {
+    if (FindNode(key) == nullptr) {
+      return nullptr;
+    }
+    NodePtr *slot = &m_root;
+    while (true) {
+      Detach(*slot);
+      Node &node = **slot;
+      if (m_compare(key, node.value.first)) {
+        slot = &node.left;
+      } else if (m_compare(node.value.first, key)) {
+        slot = &node.right;
+      } else {
+        return &node.value.second;
+      }
+    }
+  }
+
+  V &operator[](const K &key) {
+    if (V *value = find_mutable(key)) {
+      return *value;
+    }
+    V *value = nullptr;
+    Insert(m_root, key, V(), &value);
+    ++m_size;
+    return *value;
+  }
+
+  std::pair<const_iterator, bool> insert(const value_type &value) {
+    return emplace(value.first, value.second);
+  }
+
+  template <typename KArg, typename VArg>
+  std::pair<const_iterator, bool> emplace(KArg &&key_arg, VArg &&value_arg) {
+    K key(std::forward<KArg>(key_arg));
+    const_iterator it = find(key);
+    if (it != end()) {
+      return std::make_pair(it, false);
+    }
+    V *value = nullptr;
+    Insert(m_root, key, V(std::forward<VArg>(value_arg)), &value);
+    ++m_size;
+    return std::make_pair(find(key), true);
+  }
+
+  size_type erase(const K &key) {
+    if (FindNode(key) == nullptr) {
+      return 0;
+    }
+    Erase(m_root, key);
+    --m_size;
+    return 1;
+  }
+
+  void clear() {
+    m_root.reset();
+    m_size = 0;
+  }
+
+  bool operator==(const PersistentMap &other) const {
+    if (m_size != other.m_size) {
+      return false;
+    }
+    if (m_root == other.m_root) {
+      return true;
+    }
+    return std::equal(begin(), end(), other.begin());
+  }
+  bool operator!=(const PersistentMap &other) const { return !(*this == other); }
+
+  //! \brief Returns the changes which turn this map into target.
+  //!
+  //! Walks both maps side by side. Subtrees which the maps share are known to
+  //! be equal, once such a subtree is reached its right part is skipped.
+  Delta Diff(const PersistentMap &target) const {
+    Delta delta;
+    if (m_root == target.m_root) {
+      return delta;
+    }
+    const_iterator it = begin();
+    const_iterator target_it = target.begin();
+    while (it != end() || target_it != target.end()) {
+      if (target_it == target.end() ||
+          (it != end() && m_compare(it->first, target_it->first))) {
+        delta.erasures.push_back(it->first);
+        ++it;
+      } else if (it == end() || m_compare(target_it->first, it->first)) {
+        delta.upserts.emplace_back(target_it->first, target_it->second);
+        ++target_it;
+      } else if (it.Top() == target_it.Top()) {
+        it.SkipRightSubtree();
+        target_it.SkipRightSubtree();
+      } else {
+        if (!(it->second == target_it->second)) {
+          delta.upserts.emplace_back(target_it->first, target_it->second);
+        }
+        ++it;
+        ++target_it;
+      }
+    }
+    return delta;
+  }
+
+  //! \brief Applies changes obtained from Diff() on the map they were computed from.
+  void Apply(const Delta &delta) {
+    for (const K &key : delta.erasures) {
+      erase(key);
+    }
+    for (const std::pair<K, V> &entry : delta.upserts) {
+      (*this)[entry.first] = entry.second;
+    }
+  }
+
+  template <typename Stream>
+  void Serialize(Stream &s) const {
+    WriteCompactSize(s, m_size);
+    for (const value_type &entry : *this) {
+      ::Serialize(s, entry);
+    }
+  }
+
+  template <typename Stream>
+  void Unserialize(Stream &s) {
+    clear();
+    const uint64_t size = ReadCompactSize(s);
+    for (uint64_t i = 0; i < size; ++i) {
+      std::pair<K, V> entry;
+      ::Unserialize(s, entry);
+      (*this)[entry.first] = std::move(entry.second);
+    }
+  }
+
+ private:
+  const Node *FindNode(const K &key) const {
+    const Node *node = m_root.get();
+    while (node != nullptr) {
+      if (m_compare(key, node->value.first)) {
+        node = node->left.get();
+      } else if (m_compare(node->value.first, key)) {
+        node = node->right.get();
+      } else {
+        return node;
+      }
+    }
+    return nullptr;
+  }
+
+  //! Makes the node referenced by slot exclusively owned by slot.
+  //!
+  //! This is only meaningful if the node containing slot is exclusively owned
+  //! too, hence the tree must be detached top-down.
+  static void Detach(NodePtr &slot) {
+    if (slot && slot.use_count() != 1) {
+      slot = std::make_shared<Node>(*slot);
+    }
+  }
+
+  static int Height(const NodePtr &node) { return node ? node->height : 0; }
+
+  static void UpdateHeight(Node &node) {
+    node.height = 1 + std::max(Height(node.left), Height(node.right));
+  }
+
+  static void RotateRight(NodePtr &slot) {
+    Detach(slot);
+    Detach(slot->left);
+    NodePtr pivot = std::move(slot->left);
+    slot->left = std::move(pivot->right);
+    UpdateHeight(*slot);
+    pivot->right = std::move(slot);
+    UpdateHeight(*pivot);
+    slot = std::move(pivot);
+  }
+
+  static void RotateLeft(NodePtr &slot) {
+    Detach(slot);
+    Detach(slot->right);
+    NodePtr pivot = std::move(slot->right);
+    slot->right = std::move(pivot->left);
+    UpdateHeight(*slot);
+    pivot->left = std::move(slot);
+    UpdateHeight(*pivot);
+    slot = std::move(pivot);
+  }
+
+  //! Restores the AVL invariant of an exclusively owned node.
+  static void Rebalance(NodePtr &slot) {
+    Node &node = *slot;
+    const int balance = Height(node.left) - Height(node.right);
+    if (balance > 1) {
+      if (Height(node.left->left) < Height(node.left->right)) {
+        RotateLeft(node.left);
+      }
+      RotateRight(slot);
+    } else if (balance < -1) {
+      if (Height(node.right->right) < Height(node.right->left)) {
+        RotateRight(node.right);
+      }
+      RotateLeft(slot);
+    } else {
+      UpdateHeight(node);
+    }
+  }
+
+  //! Inserts a key which is not in the tree yet and stores the address of its value in value_out.
+  //!
+  //! Rotations only relink nodes, hence the address stays valid.
+  void Insert(NodePtr &slot, const K &key, V &&value, V **value_out) {
+    if (!slot) {
+      slot = std::make_shared<Node>(key, std::move(value));
+      *value_out = &slot->value.second;
+      return;
+    }
+    Detach(slot);
+    if (m_compare(key, slot->value.first)) {
+      Insert(slot->left, key, std::move(value), value_out);
+    } else {
+      Insert(slot->right, key, std::move(value), value_out);
+    }
+    Rebalance(slot);
+  }
+
+  //! Erases a key which is in the tree.
+  void Erase(NodePtr &slot, const K &key) {
+    Detach(slot);
+    if (m_compare(key, slot->value.first)) {
+      Erase(slot->left, key);
+    } else if (m_compare(slot->value.first, key)) {
+      Erase(slot->right, key);
+    } else if (!slot->left) {
+      slot = std::move(slot->right);
+      return;
+    } else if (!slot->right) {
+      slot = std::move(slot->left);
+      return;
+    } else {
+      NodePtr successor = TakeMin(slot->right);
+      successor->left = std::move(slot->left);
+      successor->right = std::move(slot->right);
+      slot = std::move(successor);
+    }
+    Rebalance(slot);
+  }
+
+  //! Unlinks the leftmost node of a non-empty subtree and returns it detached.
+  static NodePtr TakeMin(NodePtr &slot) {
+    Detach(slot);
+    if (!slot->left) {
+      NodePtr min = std::move(slot);
+      slot = std::move(min->right);
+      return min;
+    }
+    NodePtr min = TakeMin(slot->left);
+    Rebalance(slot);
+    return min;
+  }
+
+  NodePtr m_root;
+  size_type m_size = 0;
+  Compare m_compare;
+};
+
+}  // namespace util
+
+#endif  // UNITE_UTIL_PERSISTENT_MAP_H
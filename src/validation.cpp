@@ -599,18 +599,21 @@ static BCLog::LogFlags GetTransactionLogCategory(const CTransaction &tx) {
 static bool ContextualCheckFinalizerCommit(const CTransaction &tx, CValidationState &err_state,
                                            const esperanza::FinalizationState &fin_state,
                                            const esperanza::FinalizationState &tip_fin_state,
-                                           const CCoinsView &view) {
+                                           const CCoinsView &view,
+                                           const bool cache_sig_store) {
     const auto log_cat = GetTransactionLogCategory(tx);
     LogPrint(log_cat, "Checking %s with id %s\n", tx.GetType()._to_string(), tx.GetHash().GetHex());
     if (tx.IsVote()) {
-        if (!esperanza::CheckVoteTx(tx, err_state, /*vote_out=*/nullptr, /*vote_sig_out=*/nullptr)) {
+        // The vote signature is checked again by the contextual check below,
+        // so it's kept in the signature cache until then.
+        if (!esperanza::CheckVoteTx(tx, err_state, /*vote_out=*/nullptr, /*vote_sig_out=*/nullptr, /*cache_sig_store=*/true)) {
             return false;
         }
         if (!finalization::RecordVote(tx, err_state, tip_fin_state)) {
             return false;
         }
     }
-    if (!esperanza::ContextualCheckFinalizerCommit(tx, err_state, fin_state, view)) {
+    if (!esperanza::ContextualCheckFinalizerCommit(tx, err_state, fin_state, view, cache_sig_store)) {
         LogPrint(log_cat, "ERROR: %s (%s) check failed: %s\n", tx.GetType()._to_string(), tx.GetHash().GetHex(),
                  err_state.GetRejectReason());
         return false;
@@ -622,10 +625,11 @@ static bool ContextualCheckBlockFinalizerCommits(const CBlock &block,
                                                  CValidationState &err_state,
                                                  const esperanza::FinalizationState &fin_state,
                                                  const esperanza::FinalizationState &tip_fin_state,
-                                                 const CCoinsView &view) {
+                                                 const CCoinsView &view,
+                                                 const bool cache_sig_store) {
     for (const auto &tx : block.vtx) {
         if (tx->IsFinalizerCommit()) {
-            if (!::ContextualCheckFinalizerCommit(*tx, err_state, fin_state, tip_fin_state, view)) {
+            if (!::ContextualCheckFinalizerCommit(*tx, err_state, fin_state, tip_fin_state, view, cache_sig_store)) {
                 return false;
             }
         }
@@ -693,7 +697,7 @@ static bool AcceptToMemoryPoolWorker(const CChainParams& chainparams, CTxMemPool
       GetComponent<finalization::StateRepository>()->GetTipState();
     assert(fin_state != nullptr);
     if (tx.IsFinalizerCommit() &&
-        !::ContextualCheckFinalizerCommit(tx, state, *fin_state, *fin_state, view)) {
+        !::ContextualCheckFinalizerCommit(tx, state, *fin_state, *fin_state, view, /*cache_sig_store=*/true)) {
         return false; // state already filled by ContextualCheckFinalizerTx
     }
 
@@ -1467,7 +1471,7 @@ bool CScriptCheck::operator()() {
     }
     const CScript &scriptSig = ptxTo->vin[nIn].scriptSig;
     const CScriptWitness *witness = &ptxTo->vin[nIn].scriptWitness;
-    bool result = VerifyScript(scriptSig, m_tx_out.scriptPubKey, witness, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn, m_tx_out.nValue, cacheStore, *txdata), &error);
+    bool result = VerifyScript(scriptSig, m_tx_out.scriptPubKey, witness, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn, m_tx_out.nValue, cacheStore, cacheVoteStore, *txdata), &error);
     if (!result && LogAcceptCategory(BCLog::VALIDATION)) {
         LogPrint(              /* Continued */
             BCLog::VALIDATION, /* Continued */
@@ -1846,6 +1850,45 @@ void ThreadScriptCheck() {
     scriptcheckqueue.Thread();
 }
 
+/**
+ * UNIT-E: Runs the script checks of the votes in block on the script check
+ * threads and sets scripts_checked for the votes checked. Votes spending an
+ * output of the same block are not in the view yet and are left out.
+ *
+ * The vote signatures are stored in the signature cache, for the finalizer
+ * commit checks to look them up. All other signatures are stored only if
+ * fJustCheck is set, like by the script checks of the rest of the block.
+ */
+bool CheckVoteScripts(const CBlock& block, CValidationState& state, const CCoinsViewCache& view, unsigned int flags, bool fJustCheck, std::vector<bool>& scripts_checked)
+{
+    AssertLockHeld(cs_main);
+    assert(scripts_checked.size() == block.vtx.size());
+
+    CCheckQueueControl<CScriptCheck> control(&scriptcheckqueue);
+    std::vector<PrecomputedTransactionData> txdata;
+    txdata.reserve(block.vtx.size()); // Pointers to the elements are handed to the checks
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        const CTransaction &tx = *(block.vtx[i]);
+        if (!tx.IsVote() || !view.HaveInputs(tx)) {
+            continue;
+        }
+        txdata.emplace_back(tx);
+        std::vector<CScriptCheck> vChecks;
+        if (!CheckInputs(tx, state, view, true, flags, fJustCheck, fJustCheck, txdata.back(), &vChecks)) {
+            return error("%s: CheckInputs on %s failed with %s", __func__,
+                         tx.GetHash().ToString(), FormatStateMessage(state));
+        }
+        for (CScriptCheck &check : vChecks) {
+            check.SetCacheVoteStore(true);
+        }
+        control.Add(vChecks);
+        scripts_checked[i] = true;
+    }
+    if (!control.Wait())
+        return state.DoS(100, error("%s: CheckQueue failed", __func__), REJECT_INVALID, "block-validation-failed");
+    return true;
+}
+
 // Protected by cs_main
 VersionBitsCache versionbitscache;
 
@@ -2076,6 +2119,23 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
         }
     }
 
+    // UNIT-E: The signatures of votes are verified by their scripts and again
+    // by the finalizer commit checks below, which run serially. Run the script
+    // checks of the votes on the script check threads first, this stores the
+    // vote signatures in the signature cache so the serial checks only look
+    // them up. The check queue is released again before the finalizer commit
+    // checks lock mempool.cs, see below. Slashes are rare and are checked with
+    // the rest of the block.
+    //
+    // This doesn't happen during initial block download, so that syncing
+    // doesn't fill the signature cache with the votes of old blocks.
+    std::vector<bool> scripts_checked(block.vtx.size(), false);
+    if (!isGenesisBlock && has_finalization_tx && fScriptChecks && nScriptCheckThreads && !IsInitialBlockDownload()) {
+        if (!CheckVoteScripts(block, state, view, flags, fJustCheck, scripts_checked)) {
+            return false;
+        }
+    }
+
     {
         auto repo = GetComponent<finalization::StateRepository>();
         LOCK(repo->GetLock());
@@ -2098,10 +2158,13 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
         // unite-proposer or unite-http (when creating new block)
         // - lock mempool.cs in BlockAssembler::CreateNewBlock()
         // - lock pqueue->ControlMutex in BlockAssember::CreateNewBlock() -> TestBlockValidity() -> ConnectBlock() -> CCheckQueueControl()
+        //
+        // Like for script checks the vote signatures stay cached when the
+        // block is only checked, and are erased when it's connected.
         if (!isGenesisBlock &&
             has_finalization_tx &&
             !ContextualCheckBlockFinalizerCommits(
-                block,state, *fin_state, *tip_fin_state, view)) {
+                block,state, *fin_state, *tip_fin_state, view, /*cache_sig_store=*/fJustCheck)) {
             return false;
         }
     }
@@ -2180,7 +2243,7 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
         bool fCacheResults = fJustCheck;
 
         std::vector<CScriptCheck> vChecks;
-        if (!CheckInputs(tx, state, view, fScriptChecks, flags, fCacheResults, fCacheResults, txdata[i], nScriptCheckThreads ? &vChecks : nullptr)) {
+        if (!CheckInputs(tx, state, view, fScriptChecks && !scripts_checked[i], flags, fCacheResults, fCacheResults, txdata[i], nScriptCheckThreads ? &vChecks : nullptr)) {
             return error("ConnectBlock(): CheckInputs on %s failed with %s",
                          tx.GetHash().ToString(), FormatStateMessage(state));
         }
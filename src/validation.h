@@ -363,22 +363,29 @@ private:
     unsigned int nIn;
     unsigned int nFlags;
     bool cacheStore;
+    //! UNIT-E: whether vote signatures are stored in the signature cache, by default like cacheStore
+    bool cacheVoteStore;
     ScriptError error;
     PrecomputedTransactionData *txdata;
 
 public:
-    CScriptCheck(): ptxTo(nullptr), nIn(0), nFlags(0), cacheStore(false), error(SCRIPT_ERR_UNKNOWN_ERROR) {}
+    CScriptCheck(): ptxTo(nullptr), nIn(0), nFlags(0), cacheStore(false), cacheVoteStore(false), error(SCRIPT_ERR_UNKNOWN_ERROR) {}
     CScriptCheck(const CTxOut& outIn, const CTransaction& txToIn, unsigned int nInIn, unsigned int nFlagsIn, bool cacheIn, PrecomputedTransactionData* txdataIn) :
-        m_tx_out(outIn), ptxTo(&txToIn), nIn(nInIn), nFlags(nFlagsIn), cacheStore(cacheIn), error(SCRIPT_ERR_UNKNOWN_ERROR), txdata(txdataIn) { }
+        m_tx_out(outIn), ptxTo(&txToIn), nIn(nInIn), nFlags(nFlagsIn), cacheStore(cacheIn), cacheVoteStore(cacheIn), error(SCRIPT_ERR_UNKNOWN_ERROR), txdata(txdataIn) { }
 
     bool operator()();
 
+    //! UNIT-E: Stores the vote signatures checked by the script in the signature
+    //! cache, whether the other signatures are stored or not.
+    void SetCacheVoteStore(bool cacheVoteIn) { cacheVoteStore = cacheVoteIn; }
+
     void swap(CScriptCheck &check) {
         std::swap(ptxTo, check.ptxTo);
         std::swap(m_tx_out, check.m_tx_out);
         std::swap(nIn, check.nIn);
         std::swap(nFlags, check.nFlags);
         std::swap(cacheStore, check.cacheStore);
+        std::swap(cacheVoteStore, check.cacheVoteStore);
         std::swap(error, check.error);
         std::swap(txdata, check.txdata);
     }
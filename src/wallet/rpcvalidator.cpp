@@ -244,6 +244,7 @@ UniValue getvalidatorinfo(const JSONRPCRequest &request){
         "{\n"
         "  \"enabled\": true|false,    (boolean) if staking is enabled or not on this wallet.\n"
         "  \"validator_status\":       (string) the current status of the validator.\n"
+        "  \"last_vote_duration_us\":  (numeric) microseconds from the node starting to vote on a block to the vote of this wallet entering the mempool, for the last vote.\n"
         "}\n"
         "\nExamples:\n"
             + HelpExampleCli("getvalidatorinfo", "")
@@ -266,6 +267,7 @@ UniValue getvalidatorinfo(const JSONRPCRequest &request){
 
   obj.pushKV("enabled", gArgs.GetBoolArg("-validating", true));
   obj.pushKV("validator_status", extWallet.GetFinalizerPhase(*fin_state)._to_string());
+  obj.pushKV("last_vote_duration_us", pwallet->GetWalletExtension().GetLastVoteDuration());
 
   return obj;
 }
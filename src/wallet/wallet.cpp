@@ -414,7 +414,13 @@ bool CWallet::AddKeyPubKeyWithDB(WalletBatch &batch, const CKey& secret, const C
 bool CWallet::AddKeyPubKey(const CKey& secret, const CPubKey &pubkey)
 {
     WalletBatch batch(*database);
-    return CWallet::AddKeyPubKeyWithDB(batch, secret, pubkey);
+    if (!CWallet::AddKeyPubKeyWithDB(batch, secret, pubkey)) {
+        return false;
+    }
+    // Keys generated by the wallet itself can't pay to existing transactions,
+    // imported ones can make their outputs stakeable.
+    m_wallet_extension.KeyStoreChanged();
+    return true;
 }
 
 bool CWallet::AddCryptedKey(const CPubKey &vchPubKey,
@@ -500,6 +506,11 @@ bool CWallet::AddCScript(const CScript& redeemScript)
     if (!CCryptoKeyStore::AddCScript(redeemScript)) {
         return false;
     }
+    // The witness programs learned for new keys only redeem P2SH outputs,
+    // which are never stakeable, other scripts can make outputs stakeable.
+    if (!redeemScript.IsPayToWitnessPublicKeyHash()) {
+        m_wallet_extension.KeyStoreChanged();
+    }
     return WalletBatch(*database).WriteCScript(Hash160(redeemScript), redeemScript);
 }
 
@@ -524,6 +535,7 @@ bool CWallet::AddWatchOnly(const CScript& dest)
     }
     const CKeyMetadata& meta = m_script_metadata[CScriptID(dest)];
     UpdateTimeFirstKey(meta.nCreateTime);
+    m_wallet_extension.KeyStoreChanged();
     NotifyWatchonlyChanged(true);
     return WalletBatch(*database).WriteWatchOnly(dest, meta);
 }
@@ -540,6 +552,7 @@ bool CWallet::RemoveWatchOnly(const CScript &dest)
     if (!CCryptoKeyStore::RemoveWatchOnly(dest)) {
         return false;
     }
+    m_wallet_extension.KeyStoreChanged();
     if (!HaveWatchOnly()) {
         NotifyWatchonlyChanged(false);
     }
@@ -768,6 +781,7 @@ bool CWallet::IsSpent(const uint256& hash, unsigned int n) const
 void CWallet::AddToSpends(const COutPoint& outpoint, const uint256& wtxid)
 {
     mapTxSpends.insert(std::make_pair(outpoint, wtxid));
+    m_wallet_extension.OutputSpendChanged(outpoint);
 
     setLockedCoins.erase(outpoint);
 
@@ -1147,6 +1161,7 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
 
     // Break debit/credit balance caches:
     wtx.MarkDirty();
+    m_wallet_extension.TransactionAddedToWallet(hash);
 
     // Notify UI of new or updated transaction
     NotifyTransactionChanged(this, hash, fInsertedNew ? CT_NEW : CT_UPDATED);
@@ -1173,6 +1188,7 @@ void CWallet::LoadToWallet(const CWalletTx& wtxIn)
         wtx.m_it_wtxOrdered = wtxOrdered.insert(std::make_pair(wtx.nOrderPos, TxPair(&wtx, nullptr)));
     }
     AddToSpends(hash);
+    m_wallet_extension.TransactionAddedToWallet(hash);
     for (const CTxIn& txin : wtx.tx->vin) {
         auto it = mapWallet.find(txin.prevout.hash);
         if (it != mapWallet.end()) {
@@ -1276,6 +1292,7 @@ void CWallet::MarkInputsDirty(const CTransactionRef& tx)
         auto it = mapWallet.find(txin.prevout.hash);
         if (it != mapWallet.end()) {
             it->second.MarkDirty();
+            m_wallet_extension.OutputSpendChanged(txin.prevout);
         }
     }
 }
@@ -1441,8 +1458,6 @@ void CWallet::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const
     }
 
     m_last_block_processed = pindex;
-
-    m_wallet_extension.BlockConnected(pblock, *pindex);
 }
 
 void CWallet::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock) {